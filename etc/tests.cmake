@@ -5,3 +5,24 @@ add_custom_target(check COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --tim
 add_test(NAME t_eigentest1 COMMAND eigentest1)
 add_test(NAME t_formulagradienttest1 COMMAND formulagradienttest1)
 add_test(NAME t_formulagradienttest2 COMMAND formulagradienttest2)
+add_test(NAME t_formulagradienttest3 COMMAND formulagradienttest3)
+add_test(NAME t_gradientchecktest1 COMMAND gradientchecktest1)
+add_test(NAME t_composetest1 COMMAND composetest1)
+add_test(NAME t_weightimagetest1 COMMAND weightimagetest1)
+add_test(NAME t_versionedhandletest1 COMMAND versionedhandletest1)
+add_test(NAME t_eventlooptest1 COMMAND eventlooptest1)
+add_test(NAME t_timerhistogramtest1 COMMAND timerhistogramtest1)
+add_test(NAME t_timertest1 COMMAND timertest1)
+add_test(NAME t_sequentialnetworktest1 COMMAND sequentialnetworktest1)
+add_test(NAME t_fastmathtest1 COMMAND fastmathtest1)
+add_test(NAME t_matrixviewtest1 COMMAND matrixviewtest1)
+add_test(NAME t_backwardtest1 COMMAND backwardtest1)
+add_test(NAME t_gradaccumulationtest1 COMMAND gradaccumulationtest1)
+add_test(NAME t_trialsteptest1 COMMAND trialsteptest1)
+add_test(NAME t_recurrentnetworktest1 COMMAND recurrentnetworktest1)
+add_test(NAME t_conv1dtest1 COMMAND conv1dtest1)
+add_test(NAME t_lookuptabletest1 COMMAND lookuptabletest1)
+add_test(NAME t_threadpooltest1 COMMAND threadpooltest1)
+add_test(NAME t_inferenceservertest1 COMMAND inferenceservertest1)
+add_test(NAME t_distilltest1 COMMAND distilltest1)
+add_test(NAME t_onsetlogtest1 COMMAND onsetlogtest1)
@@ -13,8 +13,8 @@
  *              Big Neural Network: 16 timestamps -> tempo (bpm)
  */
 
+#include "eigen.hh"
 #include "neuralnetwork.hh"
-#include <Eigen/Dense>
 #include <iostream>
 #include <memory>
 #include <random>
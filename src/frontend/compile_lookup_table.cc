@@ -0,0 +1,109 @@
+/**
+ * File name: compile_lookup_table.cc
+ * Last Update: October 2026
+ * Description: This file compiles NN2 (seconds/beat -> tempo, 1->480->480->1,
+ *              about 231k multiply-adds per input, nn2_weights) into a
+ *              piecewise-linear LookupTable over the seconds/beat of 30..240
+ *              bpm, reports its accuracy against the network, and compares
+ *              the time per input of the two.
+ *
+ * Usage: compile_lookup_table NN2_WEIGHTS [LO HI [TOLERANCE]]
+ */
+
+#include "eigen.hh"
+#include "lookup_table.hh"
+#include "neuralnetwork.hh"
+#include "timer.hh"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr unsigned int timing_iterations = 100000;
+
+using NN2 = NeuralNetwork<float, 3, batch_size, 1, 1, 480, 480, 1>;
+
+/* init_params prints every parameter it reads, so silence cout while loading */
+void load( NN2& nn, string filename )
+{
+  nn.initialize();
+
+  ofstream null_stream { "/dev/null" };
+  auto cout_buff = cout.rdbuf( null_stream.rdbuf() );
+  nn.init_params( filename );
+  cout.rdbuf( cout_buff );
+}
+
+/* mean time per input of f, over inputs spread across [lo, hi] */
+template<class F>
+uint64_t time_per_input( const float lo, const float hi, F&& f )
+{
+  const uint64_t start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < timing_iterations; i++ ) {
+    float y = f( lo + ( hi - lo ) * ( i % 1024 ) / 1024 );
+    do_not_optimize( &y );
+  }
+  return ( Timer::timestamp_ns() - start ) / timing_iterations;
+}
+
+void program_body( const string& weights, const float lo, const float hi, const float tolerance )
+{
+  auto nn = make_unique<NN2>();
+  load( *nn, weights );
+
+  LookupTableOptions options;
+  options.tolerance = tolerance;
+  const uint64_t compile_start = Timer::timestamp_ns();
+  const LookupTable<float> table = LookupTable<float>::compile<activation::ReLU>( *nn->nn, lo, hi, options );
+  const uint64_t compile_ns = Timer::timestamp_ns() - compile_start;
+
+  cout << "domain: " << lo << " .. " << hi << " s/beat, tolerance " << tolerance << "\n\n";
+  checkLookupTable<activation::ReLU>( table, *nn->nn, options ).summary( cout );
+  cout << "\ncompiled in ";
+  Timer::pp_ns( cout, compile_ns );
+  cout << "\n";
+
+  cout << "\ntempo -> network, table\n";
+  for ( int tempo = 30; tempo <= 240; tempo += 15 ) {
+    const float spb = 60.0 / tempo;
+    nn->apply( Matrix<float, 1, 1>::Constant( spb ) );
+    cout << tempo << " -> " << nn->get_output()( 0, 0 ) << ", " << table( spb ) << "\n";
+  }
+
+  cout << "\nnetwork: ";
+  Timer::pp_ns( cout, time_per_input( lo, hi, [&]( const float spb ) {
+                  nn->apply( Matrix<float, 1, 1>::Constant( spb ) );
+                  return nn->get_output()( 0, 0 );
+                } ) );
+  cout << "\ntable:   ";
+  Timer::pp_ns( cout, time_per_input( lo, hi, table ) );
+  cout << "\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 2 and argc != 4 and argc != 5 ) {
+      cerr << "Usage: " << argv[0] << " NN2_WEIGHTS [LO HI [TOLERANCE]]\n";
+      return EXIT_FAILURE;
+    }
+
+    const float lo = argc > 2 ? stof( argv[2] ) : 60.0 / 240;
+    const float hi = argc > 2 ? stof( argv[3] ) : 60.0 / 30;
+    const float tolerance = argc > 4 ? stof( argv[4] ) : 1e-3;
+    program_body( argv[1], lo, hi, tolerance );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
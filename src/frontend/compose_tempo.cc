@@ -0,0 +1,128 @@
+/**
+ * File name: compose_tempo.cc
+ * Last Update: October 2026
+ * Description: This file builds the 16 timestamps -> tempo (bpm) model in
+ *              memory from the two separately trained networks, instead of
+ *              hand-concatenating their weight files (concatenate.cc,
+ *              big_nn_1.cc):
+ *
+ *                  NN1: 16 timestamps -> seconds/beat (16->16->1, nn1_weights)
+ *                  NN2: seconds/beat -> tempo (1->480->480->1, nn2_weights)
+ *
+ *              It chains them with ComposedNetwork, exports the folded
+ *              16->16->480->480->1 network (NN1's last layer multiplied into
+ *              NN2's first), and compares the predictions and inference time
+ *              of the two. Because the join is 1 wide, the folded layer
+ *              (16x480) does more multiply-adds than the two layers it
+ *              replaces (16x1 + 1x480), so here folding is not faster.
+ *
+ * Usage: compose_tempo NN1_WEIGHTS NN2_WEIGHTS
+ */
+
+#include "composed_network.hh"
+#include "eigen.hh"
+#include "neuralnetwork.hh"
+#include "timer.hh"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr size_t input_size = 16;
+constexpr size_t output_size = 1;
+constexpr unsigned int timing_iterations = 10000;
+
+using NN1 = NeuralNetwork<float, 2, batch_size, input_size, 1, 16, 1>;
+using NN2 = NeuralNetwork<float, 3, batch_size, 1, output_size, 480, 480, 1>;
+using Composed = ComposedNetwork<Network<float, batch_size, input_size, 16, 1>, Network<float, batch_size, 1, 480, 480, 1>>;
+
+/* init_params prints every parameter it reads, so silence cout while loading */
+template<class NN>
+void load( NN& nn, string filename )
+{
+  nn.initialize();
+
+  ofstream null_stream { "/dev/null" };
+  auto cout_buff = cout.rdbuf( null_stream.rdbuf() );
+  nn.init_params( filename );
+  cout.rdbuf( cout_buff );
+}
+
+Matrix<float, batch_size, input_size> gen_time( const float tempo )
+{
+  Matrix<float, batch_size, input_size> ret_mat;
+  for ( unsigned int i = 0; i < input_size; i++ ) {
+    ret_mat( i ) = ( 60.0 / tempo ) * i;
+  }
+  return ret_mat;
+}
+
+template<class NetworkT>
+uint64_t time_inference( NetworkT& nn )
+{
+  const Matrix<float, batch_size, input_size> input = gen_time( 120 );
+  const uint64_t start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < timing_iterations; i++ ) {
+    nn.apply( input );
+  }
+  return ( Timer::timestamp_ns() - start ) / timing_iterations;
+}
+
+void program_body( const string& nn1_weights, const string& nn2_weights )
+{
+  auto nn1 = make_unique<NN1>();
+  auto nn2 = make_unique<NN2>();
+  load( *nn1, nn1_weights );
+  load( *nn2, nn2_weights );
+
+  auto composed = make_unique<Composed>();
+  composed->a = *nn1->nn;
+  composed->b = *nn2->nn;
+
+  auto folded = make_unique<Composed::Folded>();
+  composed->exportFolded( *folded );
+
+  float max_diff = 0;
+  cout << "tempo -> composed, folded\n";
+  for ( int tempo = 30; tempo <= 240; tempo += 15 ) {
+    const Matrix<float, batch_size, input_size> input = gen_time( tempo );
+    composed->apply( input );
+    folded->apply( input );
+    max_diff = max( max_diff, abs( composed->output()( 0, 0 ) - folded->output()( 0, 0 ) ) );
+    cout << tempo << " -> " << composed->output()( 0, 0 ) << ", " << folded->output()( 0, 0 ) << "\n";
+  }
+  cout << "\nmax difference: " << max_diff << "\n\n";
+
+  cout << "multiply-adds at the join: composed " << Composed::join_macs << ", folded " << Composed::folded_join_macs
+       << "\n";
+  cout << "composed (" << composed->getNumLayers() << " layers): ";
+  Timer::pp_ns( cout, time_inference( *composed ) );
+  cout << "\nfolded   (" << folded->getNumLayers() << " layers): ";
+  Timer::pp_ns( cout, time_inference( *folded ) );
+  cout << "\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 3 ) {
+      cerr << "Usage: " << argv[0] << " NN1_WEIGHTS NN2_WEIGHTS\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( argv[1], argv[2] );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,522 @@
+/**
+ * File name: distill_tempo.cc
+ * Last Update: October 2026
+ * Description: This file distills a large, accurate tempo model (the teacher,
+ *              e.g. the 16-16-1-30-2560-1 network of compare_weights.cc) into
+ *              small networks (the students) cheap enough to run on every
+ *              onset.
+ *
+ *              1. It generates --samples noisy 16-timestamp windows, with
+ *                 tempos drawn as in sweep.cc (draw_tempo).
+ *              2. The teacher labels every window. It runs in batches of
+ *                 teacher_batch_size, on one worker thread per available CPU.
+ *                 With --cache, the windows and the teacher's outputs are
+ *                 kept in a file (keyed on a hash of the weight file), so
+ *                 later runs (other students, other learning rates) skip
+ *                 both steps.
+ *              3. One window in ten is held out for validation. Every
+ *                 student (architecture x eta x seed) trains against the
+ *                 teacher's outputs on the rest (the soft targets; --alpha
+ *                 < 1 mixes in the true tempo). Students train in parallel, one per
+ *                 worker thread, with mini-batch gradient descent on inputs
+ *                 and targets scaled to zero mean and unit variance. The
+ *                 scaling is folded into the first and last layers
+ *                 afterwards, so a student reads raw timestamps and outputs
+ *                 bpm like the teacher.
+ *
+ *              A student's learning rate halves, and its best epoch is
+ *              picked, by its error on the validation windows. Teacher and
+ *              students are then evaluated on a separate test set, the
+ *              tempos 30..240 bpm (average absolute error against the true
+ *              tempo and against the teacher, and batch-1 latency of
+ *              apply_leaky). The results are written as a tab-separated
+ *              table, one row per student. The weights of the student with
+ *              the smallest validation error are written to --out in the
+ *              format of NeuralNetwork::init_params.
+ *
+ *              Only the first output of the teacher (the tempo) is
+ *              distilled.
+ *
+ * Usage: distill_tempo --weights TEACHER_WEIGHTS [--teacher ARCH]
+ *                      [--student ARCH,...] [--eta X,...] [--seeds N]
+ *                      [--samples N] [--epochs N] [--alpha X] [--noise 0|1]
+ *                      [--offset 0|1] [--data-seed N] [--cache FILE]
+ *                      [--threads N] [--out FILE]
+ *
+ *        Run `distill_tempo --list` to print the available architectures.
+ */
+
+#include "affinity.hh"
+#include "distill.hh"
+#include "eigen.hh"
+#include "neuralnetwork.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+using namespace std;
+using namespace Eigen;
+using namespace distill;
+
+constexpr unsigned int teacher_batch_size = 64;
+constexpr unsigned int student_batch_size = 32;
+
+struct Student
+{
+  size_t id;
+  string arch;
+  float eta;
+  unsigned int seed;
+};
+
+/* errors are on the test set, except the val_ ones (which picked the best epoch and the best student) */
+struct StudentResult
+{
+  string status = "not run";
+  unsigned int best_epoch = 0;
+  float val_truth_diff = NAN;
+  float val_teacher_diff = NAN;
+  float truth_diff = NAN;
+  float teacher_diff = NAN;
+  uint64_t latency_ns = 0;
+  double seconds = 0;
+  Params params {};
+};
+
+/*
+ * Function Name: run_teacher
+ * Description: This function loads the teacher, labels the training windows
+ *              with it (unless they came from the cache), and evaluates it on
+ *              the test set.
+ * Parameters:
+ *			1. weights_file is the teacher's weights, as written by
+ *			   NeuralNetwork::printWeights
+ *			2. samples are the training windows; samples.teacher is filled
+ *			   in if it is empty
+ *			3. test is the test set; test.teacher is filled in
+ *			4. num_threads is the number of worker threads
+ */
+template<unsigned int... sizes>
+void run_teacher( const string& weights_file,
+                  Samples& samples,
+                  Samples& test,
+                  const unsigned int num_threads,
+                  float& truth_diff,
+                  uint64_t& latency_ns )
+{
+  constexpr unsigned int dims[] = { sizes... };
+  constexpr unsigned int output_size = dims[sizeof...( sizes ) - 1];
+  using Teacher = NeuralNetwork<float, sizeof...( sizes ), teacher_batch_size, input_size, output_size, sizes...>;
+  using TeacherNetwork = Network<float, teacher_batch_size, input_size, sizes...>;
+
+  /* init_params prints every parameter it reads, so silence cout while loading */
+  auto teacher = make_unique<Teacher>();
+  teacher->initialize();
+  {
+    ofstream null_stream { "/dev/null" };
+    auto cout_buff = cout.rdbuf( null_stream.rdbuf() );
+    string filename = weights_file;
+    teacher->init_params( filename );
+    cout.rdbuf( cout_buff );
+  }
+
+  if ( samples.teacher.size() == 0 ) {
+    const Index num_samples = samples.inputs.rows();
+    const Index num_batches = ( num_samples + teacher_batch_size - 1 ) / teacher_batch_size;
+    samples.teacher.resize( num_samples );
+
+    atomic<Index> next_batch { 0 };
+    run_pinned_workers( num_threads, available_cpus(), [&]( unsigned int ) {
+      auto nn = make_unique<TeacherNetwork>( *teacher->nn );
+      Matrix<float, teacher_batch_size, input_size> input;
+      for ( Index b = next_batch++; b < num_batches; b = next_batch++ ) {
+        /* the last batch is padded with copies of its last window */
+        const Index first = b * teacher_batch_size;
+        const Index count = min<Index>( teacher_batch_size, num_samples - first );
+        input.topRows( count ) = samples.inputs.middleRows( first, count );
+        input.bottomRows( teacher_batch_size - count )
+          = samples.inputs.row( first + count - 1 ).replicate( teacher_batch_size - count, 1 );
+        nn->apply_leaky( input );
+        samples.teacher.segment( first, count ) = nn->output().col( 0 ).head( count );
+      }
+    } );
+  }
+
+  /* the teacher at batch size 1, as it would run on every onset */
+  auto single = make_unique<Network<float, 1, input_size, sizes...>>();
+  set_params( *single, get_params( *teacher->nn ) );
+  test.teacher.resize( test.inputs.rows() );
+  for ( Index i = 0; i < test.inputs.rows(); i++ ) {
+    single->apply_leaky( test.inputs.row( i ) );
+    test.teacher( i ) = single->output()( 0, 0 );
+  }
+  float teacher_diff;
+  evaluate( *single, test, truth_diff, teacher_diff, latency_ns );
+}
+
+using TeacherFunction
+  = void ( * )( const string&, Samples&, Samples&, const unsigned int, float&, uint64_t& );
+
+/*
+ * Function Name: train_student
+ * Description: This function trains one student against the teacher's
+ *              outputs, evaluating it on the validation windows after every
+ *              epoch (the learning rate halves after an epoch that does not
+ *              improve on the best), and returns the parameters (scaling
+ *              folded in) of its best epoch with their errors on the
+ *              validation and the test sets.
+ */
+template<unsigned int... sizes>
+StudentResult train_student( const Student& student,
+                             const Samples& samples,
+                             const Samples& validation,
+                             const Samples& test,
+                             const Normalization& norm,
+                             const DistillOptions& options )
+{
+  using StudentNetwork = Network<float, student_batch_size, input_size, sizes...>;
+
+  mt19937 rng( student.seed );
+  auto nn = make_unique<StudentNetwork>();
+  nn->initializeWeightsRandomly( rng );
+  auto single = make_unique<Network<float, 1, input_size, sizes...>>();
+
+  /* the soft targets, mixed with the truth when alpha < 1, then scaled */
+  const VectorXf targets
+    = ( ( ( options.alpha * samples.teacher + ( 1 - options.alpha ) * samples.truth ).array() - norm.target_mean )
+        / norm.target_std )
+        .matrix();
+
+  vector<Index> order( samples.inputs.rows() );
+  iota( order.begin(), order.end(), 0 );
+  const Index num_batches = samples.inputs.rows() / student_batch_size;
+
+  StudentResult result;
+  result.status = "completed";
+  Matrix<float, student_batch_size, input_size> input;
+  Matrix<float, student_batch_size, 1> target;
+  float eta = student.eta;
+  for ( unsigned int epoch = 1; epoch <= options.epochs; epoch++ ) {
+    shuffle( order.begin(), order.end(), rng );
+    for ( Index b = 0; b < num_batches; b++ ) {
+      for ( unsigned int r = 0; r < student_batch_size; r++ ) {
+        const Index i = order[b * student_batch_size + r];
+        input.row( r ) = ( samples.inputs.row( i ) - norm.input_mean ).cwiseQuotient( norm.input_std );
+        target( r ) = targets( i );
+      }
+      nn->apply_leaky( input );
+      nn->computeLeakyDeltas( 2 * ( nn->output() - target ) / student_batch_size );
+      nn->evaluateGradients( input );
+      for ( unsigned int i = 0; i < nn->getNumLayers(); i++ ) {
+        nn->modifyParamWholeLayer( i, eta );
+      }
+    }
+
+    const Params params = fold_normalization( get_params( *nn ), norm );
+    set_params( *single, params );
+    float truth_diff, teacher_diff;
+    uint64_t latency_ns;
+    evaluate( *single, validation, truth_diff, teacher_diff, latency_ns );
+    if ( not is_finite( teacher_diff ) ) {
+      result.status = "diverged";
+      break;
+    }
+    if ( result.best_epoch > 0 and not( teacher_diff < result.val_teacher_diff ) ) {
+      eta /= 2; /* no better than the best epoch so far: take smaller steps */
+    } else {
+      result.best_epoch = epoch;
+      result.val_truth_diff = truth_diff;
+      result.val_teacher_diff = teacher_diff;
+      result.params = params;
+    }
+  }
+
+  if ( not result.params.empty() ) {
+    set_params( *single, result.params );
+    evaluate( *single, test, result.truth_diff, result.teacher_diff, result.latency_ns );
+  }
+  return result;
+}
+
+using StudentFunction
+  = StudentResult ( * )( const Student&,
+                         const Samples&,
+                         const Samples&,
+                         const Samples&,
+                         const Normalization&,
+                         const DistillOptions& );
+
+template<unsigned int... sizes>
+constexpr unsigned int count_params()
+{
+  constexpr unsigned int dims[] = { input_size, sizes... };
+  unsigned int total = 0;
+  for ( size_t i = 0; i + 1 < sizeof( dims ) / sizeof( dims[0] ); i++ ) {
+    total += ( dims[i] + 1 ) * dims[i + 1];
+  }
+  return total;
+}
+
+struct TeacherArch
+{
+  const char* name;
+  TeacherFunction run;
+  unsigned int num_params;
+};
+
+struct StudentArch
+{
+  const char* name;
+  StudentFunction run;
+  unsigned int num_params;
+};
+
+/* architectures are template parameters, so teachers and students can only be picked from these lists */
+const vector<TeacherArch>& teachers()
+{
+  static const vector<TeacherArch> archs {
+    { "16-16-1-30-2560-1", run_teacher<16, 1, 30, 2560, 1>, count_params<16, 1, 30, 2560, 1>() },
+    { "16-16-1-30-256-1", run_teacher<16, 1, 30, 256, 1>, count_params<16, 1, 30, 256, 1>() },
+    { "16-16-3-100-340-1", run_teacher<16, 3, 100, 340, 1>, count_params<16, 3, 100, 340, 1>() },
+    { "16-16-1-2500-2500-2", run_teacher<16, 1, 2500, 2500, 2>, count_params<16, 1, 2500, 2500, 2>() },
+  };
+  return archs;
+}
+
+const vector<StudentArch>& students()
+{
+  static const vector<StudentArch> archs {
+    { "16-16-1", train_student<16, 1>, count_params<16, 1>() },
+    { "16-16-16-1", train_student<16, 16, 1>, count_params<16, 16, 1>() },
+    { "16-32-1", train_student<32, 1>, count_params<32, 1>() },
+    { "16-32-32-1", train_student<32, 32, 1>, count_params<32, 32, 1>() },
+  };
+  return archs;
+}
+
+template<class Arch>
+const Arch& find_architecture( const vector<Arch>& archs, const string& name )
+{
+  for ( const auto& arch : archs ) {
+    if ( name == arch.name ) {
+      return arch;
+    }
+  }
+  throw runtime_error( "unknown architecture " + name + " (see --list)" );
+}
+
+vector<string> split( const string& list )
+{
+  vector<string> ret;
+  stringstream ss( list );
+  string item;
+  while ( getline( ss, item, ',' ) ) {
+    ret.push_back( item );
+  }
+  return ret;
+}
+
+/* in the format NeuralNetwork::init_params reads (see Layer::printWeights) */
+void write_params( ostream& out, const Params& params )
+{
+  const IOFormat CleanFmt( 10, 0, ", ", "\n", "[", "]" );
+  for ( unsigned int i = 0; i < params.size(); i++ ) {
+    out << i << endl;
+    out << "weights:" << endl << params[i].first.format( CleanFmt ) << endl << endl;
+    out << "biases:" << endl << params[i].second.format( CleanFmt ) << endl << endl;
+  }
+}
+
+void program_body( int argc, char* argv[] )
+{
+  string teacher_name = "16-16-1-30-2560-1";
+  string weights_file;
+  vector<string> student_names;
+  for ( const auto& arch : students() ) {
+    student_names.push_back( arch.name );
+  }
+  vector<string> etas { "1e-2", "3e-3" };
+  unsigned int num_seeds = 1;
+  unsigned int num_threads = 0;
+  string cache_filename;
+  string out_filename = "student_weights.txt";
+  DistillOptions options;
+
+  for ( int i = 1; i < argc; i++ ) {
+    const string arg = argv[i];
+    if ( arg == "--list" ) {
+      cout << "teachers:\n";
+      for ( const auto& arch : teachers() ) {
+        cout << arch.name << "\t" << arch.num_params << " params\n";
+      }
+      cout << "students:\n";
+      for ( const auto& arch : students() ) {
+        cout << arch.name << "\t" << arch.num_params << " params\n";
+      }
+      return;
+    }
+    if ( i + 1 >= argc ) {
+      throw runtime_error( "missing value for " + arg );
+    }
+    const string value = argv[++i];
+    if ( arg == "--weights" ) {
+      weights_file = value;
+    } else if ( arg == "--teacher" ) {
+      teacher_name = value;
+    } else if ( arg == "--student" ) {
+      student_names = split( value );
+    } else if ( arg == "--eta" ) {
+      etas = split( value );
+    } else if ( arg == "--seeds" ) {
+      num_seeds = stoul( value );
+    } else if ( arg == "--samples" ) {
+      options.samples = stoul( value );
+    } else if ( arg == "--epochs" ) {
+      options.epochs = stoul( value );
+    } else if ( arg == "--alpha" ) {
+      options.alpha = stof( value );
+    } else if ( arg == "--noise" ) {
+      options.noise = value == "1";
+    } else if ( arg == "--offset" ) {
+      options.offset = value == "1";
+    } else if ( arg == "--data-seed" ) {
+      options.data_seed = stoul( value );
+    } else if ( arg == "--cache" ) {
+      cache_filename = value;
+    } else if ( arg == "--threads" ) {
+      num_threads = stoul( value );
+    } else if ( arg == "--out" ) {
+      out_filename = value;
+    } else {
+      throw runtime_error( "unknown option " + arg );
+    }
+  }
+
+  if ( weights_file.empty() ) {
+    throw runtime_error( "--weights is required" );
+  }
+  const TeacherArch& teacher = find_architecture( teachers(), teacher_name );
+
+  const vector<unsigned int> cpus = available_cpus();
+  if ( num_threads == 0 ) {
+    num_threads = cpus.size();
+  }
+
+  /* windows and soft targets, from the cache or from the teacher */
+  const CacheHeader header = make_cache_header( teacher_name, weights_file, options );
+  Samples samples;
+  const bool cached = not cache_filename.empty() and load_cache( cache_filename, header, samples );
+  if ( not cached ) {
+    generate_samples( samples, options );
+  }
+  Samples test = make_test_set( options );
+
+  const uint64_t teacher_start = Timer::timestamp_ns();
+  float teacher_truth_diff;
+  uint64_t teacher_latency_ns;
+  teacher.run( weights_file, samples, test, num_threads, teacher_truth_diff, teacher_latency_ns );
+  cerr << "Teacher " << teacher.name << ": avg diff " << teacher_truth_diff << " bpm, latency " << teacher_latency_ns
+       << " ns; " << samples.truth.size() << " windows " << ( cached ? "from the cache" : "labelled" ) << " in "
+       << ( Timer::timestamp_ns() - teacher_start ) / BILLION << " s.\n";
+
+  if ( not cached and not cache_filename.empty() ) {
+    write_cache( cache_filename, header, samples );
+  }
+
+  /* the students train on most of the windows; the rest pick their learning rate, best epoch and the winner */
+  const auto [train, validation] = split_validation( samples );
+  if ( train.inputs.rows() < student_batch_size ) {
+    throw runtime_error( "--samples is too small for a batch of " + to_string( student_batch_size ) );
+  }
+
+  /* the students, in parallel */
+  vector<Student> trials;
+  for ( const auto& arch : student_names ) {
+    find_architecture( students(), arch );
+    for ( const auto& eta : etas ) {
+      for ( unsigned int seed = 0; seed < num_seeds; seed++ ) {
+        trials.push_back( { trials.size(), arch, stof( eta ), seed } );
+      }
+    }
+  }
+  const Normalization norm = compute_normalization( train, options.alpha );
+  num_threads = min<size_t>( num_threads, trials.size() );
+
+  cerr << "Training " << trials.size() << " students on " << num_threads << " threads.\n";
+
+  vector<StudentResult> results( trials.size() );
+  atomic<size_t> next_trial { 0 };
+  mutex log_mutex;
+  run_pinned_workers( num_threads, cpus, [&]( unsigned int ) {
+    for ( size_t n = next_trial++; n < trials.size(); n = next_trial++ ) {
+      const Student& student = trials[n];
+      StudentResult& result = results[n];
+
+      const uint64_t start = Timer::timestamp_ns();
+      try {
+        result
+          = find_architecture( students(), student.arch ).run( student, train, validation, test, norm, options );
+      } catch ( const exception& e ) {
+        result.status = string( "failed: " ) + e.what();
+      }
+      result.seconds = ( Timer::timestamp_ns() - start ) / BILLION;
+
+      lock_guard<mutex> lock( log_mutex );
+      cerr << "student " << student.id << " (" << student.arch << ", eta=" << student.eta
+           << ", seed=" << student.seed << "): " << result.status << ", validation avg diff " << result.val_truth_diff
+           << " bpm, from teacher " << result.val_teacher_diff << " bpm\n";
+    }
+  } );
+
+  /* the winner is picked on the validation windows; the test columns are reported, not used */
+  cout << "student\tarch\tparams\teta\tseed\tstatus\tbest_epoch\tval_avg_diff\tval_teacher_diff\tavg_diff\t"
+          "teacher_diff\tlatency_ns\tseconds\n";
+  cout << "teacher\t" << teacher.name << "\t" << teacher.num_params << "\t\t\t\t\t\t\t" << teacher_truth_diff
+       << "\t0\t" << teacher_latency_ns << "\t\n";
+  size_t best = trials.size();
+  for ( size_t i = 0; i < trials.size(); i++ ) {
+    const Student& s = trials[i];
+    const StudentResult& r = results[i];
+    cout << s.id << "\t" << s.arch << "\t" << find_architecture( students(), s.arch ).num_params << "\t" << s.eta
+         << "\t" << s.seed << "\t" << r.status << "\t" << r.best_epoch << "\t" << r.val_truth_diff << "\t"
+         << r.val_teacher_diff << "\t" << r.truth_diff << "\t" << r.teacher_diff << "\t" << r.latency_ns << "\t"
+         << r.seconds << "\n";
+    if ( not r.params.empty() and ( best == trials.size() or r.val_truth_diff < results[best].val_truth_diff ) ) {
+      best = i;
+    }
+  }
+
+  if ( best == trials.size() ) {
+    throw runtime_error( "no student finished training" );
+  }
+  ofstream out { out_filename };
+  write_params( out, results[best].params );
+  out.flush();
+  if ( not out ) {
+    throw runtime_error( "could not write " + out_filename );
+  }
+  cerr << "Wrote the weights of student " << best << " (" << trials[best].arch << ") to " << out_filename << ".\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+    program_body( argc, argv );
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
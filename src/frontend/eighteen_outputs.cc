@@ -1,6 +1,6 @@
+#include "eigen.hh"
 #include "neuralnetwork.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <memory>
 #include <random>
@@ -45,16 +45,6 @@ Matrix<float, batch_size, input_size> gen_time( float tempo, bool offset, bool n
   return ret_mat;
 }
 
-Matrix<float, batch_size, input_size> get_input(Matrix<float, batch_size, input_size + 1> times)
-{
-    Matrix<float, batch_size, input_size> ret_mat;
-    for(int i = 1; i < 17; i++)
-    {
-        ret_mat(i) = times(i);
-    } 
-    return ret_mat;
-}
-
 Matrix<float, batch_size, output_size> gen_truth( 
     float tempo, float next_note)
 {
@@ -5,11 +5,11 @@
   integers.
   Next step: to count the interval of the 16 inputs --> beat
 */
+#include "eigen.hh"
 #include "exception.hh"
 #include "network.hh"
 #include "timer.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <random>
 #include <utility>
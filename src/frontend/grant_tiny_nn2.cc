@@ -1,6 +1,6 @@
 // Experimental 2nd TINY neural network to figure out how to manually change weights
+#include "eigen.hh"
 #include "neuralnetwork.hh"
-#include <Eigen/Dense>
 #include <iostream>
 #include <filesystem>
 #include <memory>
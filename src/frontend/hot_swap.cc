@@ -0,0 +1,206 @@
+/**
+ * File name: hot_swap.cc
+ * Last Update: October 2026
+ * Description: This file replaces the weights of the 16 timestamps -> tempo
+ *              model while inference threads keep predicting, instead of
+ *              restarting the process and re-running init_params.
+ *
+ *              A loader thread maps a fresh copy of a weight image
+ *              (make_weight_image), validates it off the hot path (shape,
+ *              and a sane prediction at 120 bpm), and publishes it through a
+ *              VersionedHandle. Inference threads pick up the new version at
+ *              their next prediction without taking a lock, and the old
+ *              mapping is released after its grace period.
+ *
+ *              It runs once without swaps and once with swaps, and compares
+ *              the prediction latency of the two runs.
+ *
+ * Usage: hot_swap IMAGE [SECONDS] [SWAP_PERIOD_MS] [INFERENCE_THREADS]
+ *        (defaults: 2 s per run, a swap every 10 ms, 2 threads)
+ */
+
+#include "eigen.hh"
+#include "timer.hh"
+#include "versioned_handle.hh"
+#include "weight_image.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr size_t input_size = 16;
+// a validated model must predict 120 bpm within this many bpm
+constexpr float validation_tolerance = 60;
+
+using Model = MappedNetwork<float, batch_size, input_size, 16, 1, 480, 480, 1>;
+using ModelHandle = VersionedHandle<WeightImage>;
+
+Matrix<float, batch_size, input_size> gen_time( const float tempo )
+{
+  Matrix<float, batch_size, input_size> ret_mat;
+  for ( unsigned int i = 0; i < input_size; i++ ) {
+    ret_mat( i ) = ( 60.0 / tempo ) * i;
+  }
+  return ret_mat;
+}
+
+/* map an image and check that it is a usable tempo model before anyone sees it */
+unique_ptr<const WeightImage> load_and_validate( const string& filename )
+{
+  auto image = make_unique<const WeightImage>( filename );
+  auto probe = make_unique<Model>( *image );
+  probe->apply( gen_time( 120 ) );
+  const float prediction = probe->output()( 0, 0 );
+  if ( not( abs( prediction - 120 ) < validation_tolerance ) ) {
+    throw runtime_error( filename + ": predicts " + to_string( prediction ) + " bpm at 120 bpm" );
+  }
+  return image;
+}
+
+struct Latencies
+{
+  vector<uint64_t> steady {};
+  // predictions that were the first to use a new version
+  vector<uint64_t> after_swap {};
+};
+
+void print_latencies( const string& name, vector<uint64_t> latencies )
+{
+  if ( latencies.empty() ) {
+    return;
+  }
+  sort( latencies.begin(), latencies.end() );
+  const auto quantile = [&]( const double q ) { return latencies.at( size_t( q * ( latencies.size() - 1 ) ) ); };
+
+  cout << "  " << name << ": " << latencies.size() << " predictions, p50 ";
+  Timer::pp_ns( cout, quantile( 0.5 ) );
+  cout << ", p99 ";
+  Timer::pp_ns( cout, quantile( 0.99 ) );
+  cout << ", p99.9 ";
+  Timer::pp_ns( cout, quantile( 0.999 ) );
+  cout << ", max ";
+  Timer::pp_ns( cout, latencies.back() );
+  cout << defaultfloat << "\n";
+}
+
+void run( const string& filename,
+          const double seconds,
+          const unsigned int swap_period_ms,
+          const unsigned int num_threads,
+          const bool swap )
+{
+  ModelHandle handle { load_and_validate( filename ) };
+  atomic<bool> stop { false };
+
+  vector<Latencies> latencies( num_threads );
+  vector<thread> threads;
+  for ( unsigned int t = 0; t < num_threads; t++ ) {
+    threads.emplace_back( [&, t] {
+      ModelHandle::Reader reader { handle };
+      uint64_t version = 0;
+      unique_ptr<Model> model;
+      {
+        auto current = reader.read();
+        model = make_unique<Model>( *current );
+        version = current.version();
+      }
+
+      mt19937 rng( t );
+      uniform_real_distribution<float> tempo_dist( 30, 240 );
+      while ( not stop.load( memory_order_relaxed ) ) {
+        const auto input = gen_time( tempo_dist( rng ) );
+        const uint64_t start = Timer::timestamp_ns();
+        bool swapped = false;
+        {
+          auto current = reader.read();
+          if ( current.version() != version ) {
+            model->bind( *current );
+            version = current.version();
+            swapped = true;
+          }
+          model->apply( input );
+        }
+        const uint64_t elapsed = Timer::timestamp_ns() - start;
+        ( swapped ? latencies[t].after_swap : latencies[t].steady ).push_back( elapsed );
+      }
+    } );
+  }
+
+  unsigned int failed_loads = 0;
+  uint64_t load_ns = 0;
+  const auto end = chrono::steady_clock::now() + chrono::duration<double>( seconds );
+  while ( chrono::steady_clock::now() < end ) {
+    this_thread::sleep_for( chrono::milliseconds( swap_period_ms ) );
+    if ( not swap ) {
+      continue;
+    }
+
+    try {
+      const uint64_t start = Timer::timestamp_ns();
+      auto image = load_and_validate( filename );
+      load_ns += Timer::timestamp_ns() - start;
+      handle.publish( move( image ) );
+    } catch ( const exception& e ) {
+      cerr << "not swapping in new weights: " << e.what() << "\n";
+      failed_loads++;
+    }
+  }
+
+  stop = true;
+  for ( auto& thread : threads ) {
+    thread.join();
+  }
+  handle.synchronize();
+
+  Latencies all;
+  for ( const auto& l : latencies ) {
+    all.steady.insert( all.steady.end(), l.steady.begin(), l.steady.end() );
+    all.after_swap.insert( all.after_swap.end(), l.after_swap.begin(), l.after_swap.end() );
+  }
+
+  if ( swap ) {
+    cout << "With a swap every " << swap_period_ms << " ms (" << handle.version() - 1 << " swaps, " << failed_loads
+         << " rejected, " << handle.num_reclaimed() << " old versions reclaimed, mean load+validate ";
+    Timer::pp_ns( cout, ( handle.version() > 1 ) ? load_ns / ( handle.version() - 1 ) : 0 );
+    cout << defaultfloat << "):\n";
+  } else {
+    cout << "Without swaps:\n";
+  }
+  print_latencies( "steady    ", all.steady );
+  print_latencies( "after swap", all.after_swap );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc < 2 or argc > 5 ) {
+      cerr << "Usage: " << argv[0] << " IMAGE [SECONDS] [SWAP_PERIOD_MS] [INFERENCE_THREADS]\n";
+      return EXIT_FAILURE;
+    }
+
+    const double seconds = argc >= 3 ? stod( argv[2] ) : 2;
+    const unsigned int swap_period_ms = argc >= 4 ? stoul( argv[3] ) : 10;
+    const unsigned int num_threads = argc >= 5 ? stoul( argv[4] ) : 2;
+
+    run( argv[1], seconds, swap_period_ms, num_threads, false );
+    run( argv[1], seconds, swap_period_ms, num_threads, true );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
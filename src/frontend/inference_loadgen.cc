@@ -0,0 +1,147 @@
+/**
+ * File name: inference_loadgen.cc
+ * Last Update: October 2026
+ * Description: This file is a load generator for inference_server. For each
+ *              client count it starts that many client threads, each on its
+ *              own connection. Each client sends REQUESTS requests one at a
+ *              time (the next one after the previous reply) with the
+ *              timestamps of a random tempo. It then reports the throughput,
+ *              the latency distribution, and the mean absolute tempo error of
+ *              the replies.
+ *
+ * Usage: inference_loadgen SOCKET_PATH REQUESTS CLIENTS...
+ *        e.g. inference_loadgen /tmp/nnfun_inference.sock 2000 1 2 4 8 16 32
+ */
+
+#include "inference_protocol.hh"
+#include "socket.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace inference;
+
+struct ClientResult
+{
+  vector<uint64_t> latencies_ns {};
+  double total_error {};
+};
+
+void read_exactly( LocalStreamSocket& socket, char* data, size_t len )
+{
+  while ( len > 0 ) {
+    const size_t n = socket.read( string_span { data, len } );
+    if ( n == 0 ) {
+      throw runtime_error( "server closed the connection" );
+    }
+    data += n;
+    len -= n;
+  }
+}
+
+void run_client( const string& socket_path, const unsigned int num_requests, const unsigned int seed, ClientResult& result )
+{
+  LocalStreamSocket socket;
+  socket.connect( socket_path );
+
+  mt19937 rng( seed );
+  uniform_real_distribution<float> tempo_dist( 30, 240 );
+  result.latencies_ns.reserve( num_requests );
+
+  for ( unsigned int i = 0; i < num_requests; i++ ) {
+    const float tempo = tempo_dist( rng );
+    Request request;
+    for ( unsigned int j = 0; j < input_size; j++ ) {
+      request.input[j] = ( 60.0 / tempo ) * j;
+    }
+
+    Response response;
+    const uint64_t start = Timer::timestamp_ns();
+    socket.write( { reinterpret_cast<const char*>( &request ), sizeof( request ) } );
+    read_exactly( socket, reinterpret_cast<char*>( &response ), sizeof( response ) );
+    result.latencies_ns.push_back( Timer::timestamp_ns() - start );
+
+    result.total_error += abs( response.output[0] - tempo );
+  }
+
+  socket.shutdown_write();
+}
+
+void run_load( const string& socket_path, const unsigned int num_requests, const unsigned int num_clients )
+{
+  vector<ClientResult> results( num_clients );
+  vector<string> errors( num_clients );
+
+  const uint64_t start = Timer::timestamp_ns();
+  vector<thread> threads;
+  for ( unsigned int c = 0; c < num_clients; c++ ) {
+    threads.emplace_back( [&, c] {
+      try {
+        run_client( socket_path, num_requests, c, results[c] );
+      } catch ( const exception& e ) {
+        errors[c] = e.what();
+      }
+    } );
+  }
+  for ( auto& t : threads ) {
+    t.join();
+  }
+  const uint64_t elapsed = Timer::timestamp_ns() - start;
+
+  for ( const auto& error : errors ) {
+    if ( not error.empty() ) {
+      throw runtime_error( error );
+    }
+  }
+
+  vector<uint64_t> latencies;
+  double total_error = 0;
+  for ( const auto& r : results ) {
+    latencies.insert( latencies.end(), r.latencies_ns.begin(), r.latencies_ns.end() );
+    total_error += r.total_error;
+  }
+  sort( latencies.begin(), latencies.end() );
+  const auto quantile = [&]( const double q ) { return latencies.at( size_t( q * ( latencies.size() - 1 ) ) ); };
+
+  cout << setw( 7 ) << num_clients << " " << setw( 14 ) << fixed << setprecision( 0 )
+       << latencies.size() / ( elapsed / BILLION ) << "  ";
+  Timer::pp_ns( cout, quantile( 0.5 ) );
+  cout << "  ";
+  Timer::pp_ns( cout, quantile( 0.99 ) );
+  cout << "  ";
+  Timer::pp_ns( cout, latencies.back() );
+  cout << "  " << setprecision( 2 ) << total_error / latencies.size() << "\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc < 4 ) {
+      cerr << "Usage: " << argv[0] << " SOCKET_PATH REQUESTS CLIENTS...\n";
+      return EXIT_FAILURE;
+    }
+
+    cout << "clients  requests/sec      p50       p99       max  mean |error| (bpm)\n";
+    for ( int i = 3; i < argc; i++ ) {
+      run_load( argv[1], stoul( argv[2] ), stoul( argv[i] ) );
+    }
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
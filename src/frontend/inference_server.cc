@@ -0,0 +1,123 @@
+/**
+ * File name: inference_server.cc
+ * Last Update: October 2026
+ * Description: This file is a model-serving daemon for the 16 timestamps ->
+ *              tempo (bpm) network of big_nn_1.cc, so that client processes
+ *              share one loaded model instead of each linking its own copy.
+ *
+ *              Clients connect to a Unix domain socket and send requests in
+ *              the format of inference_protocol.hh. Requests from all
+ *              connections are queued. The queue is run as one batched
+ *              forward pass when it reaches the largest batch size, or when
+ *              its oldest request has waited DEADLINE_US, whichever comes
+ *              first. Batched networks are compiled for batch sizes 1, 2, 4,
+ *              8, 16 and 32, and each batch uses the smallest one that fits.
+ *              Replies are buffered per client and written as each socket
+ *              takes them, so a slow reader does not hold up the others
+ *              (see InferenceServer in inference_server.hh).
+ *
+ *              WEIGHTS_FILE is either a text weights file, which is parsed
+ *              into private copies of the parameters, or a weight image
+ *              (make_weight_image), which is mapped read-only and shared:
+ *              all batch sizes, and all servers on the host, read the same
+ *              page-cache copy of the parameters.
+ *
+ * Usage: inference_server WEIGHTS_FILE [SOCKET_PATH] [DEADLINE_US]
+ *        (defaults: /tmp/nnfun_inference.sock, 200 us)
+ */
+
+#include "eigen.hh"
+#include "inference_server.hh"
+#include "neuralnetwork.hh"
+#include "weight_image.hh"
+
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+using namespace Eigen;
+using namespace inference;
+
+using Model = NeuralNetwork<float, 5, 1, input_size, output_size, 16, 1, 480, 480, output_size>;
+
+template<unsigned int batch_size>
+using BatchNetwork = Network<float, batch_size, input_size, 16, 1, 480, 480, output_size>;
+
+template<unsigned int batch_size>
+using MappedBatchNetwork = MappedNetwork<float, batch_size, input_size, 16, 1, 480, 480, output_size>;
+
+/* answer requests on socket_path until killed */
+template<class Batched>
+void serve( Batched& batched, const string& socket_path, const uint64_t deadline_ns )
+{
+  LocalStreamSocket listener;
+  listener.bind( socket_path );
+  listener.listen();
+  cerr << "Listening on " << socket_path << " (batch deadline " << deadline_ns / THOUSAND << " us, max batch "
+       << Batched::max_batch_size << ")\n";
+
+  InferenceServer<Batched> server { batched, move( listener ), deadline_ns };
+  server.serve();
+}
+
+void program_body( const string& weights_file, const string& socket_path, const uint64_t deadline_ns )
+{
+  ifstream weights { weights_file, ios::binary };
+  array<char, WeightImage::magic.size()> magic {};
+  weights.read( magic.data(), magic.size() );
+
+  if ( magic == WeightImage::magic ) {
+    const WeightImage image { weights_file };
+    BatchedModel<MappedBatchNetwork, 1, 2, 4, 8, 16, 32> batched { [&]( auto batch_size ) {
+      return make_unique<MappedBatchNetwork<batch_size>>( image );
+    } };
+    cerr << "Mapped weight image " << weights_file << " (" << image.size() << " bytes, shared)\n";
+    serve( batched, socket_path, deadline_ns );
+  } else {
+    auto model = make_unique<Model>();
+    model->initialize();
+    {
+      /* init_params prints every parameter it reads */
+      ofstream null_stream { "/dev/null" };
+      auto cout_buff = cout.rdbuf( null_stream.rdbuf() );
+      string filename = weights_file;
+      model->init_params( filename );
+      cout.rdbuf( cout_buff );
+    }
+
+    auto batched = make_unique<BatchedModel<BatchNetwork, 1, 2, 4, 8, 16, 32>>( [&]( auto batch_size ) {
+      auto network = make_unique<BatchNetwork<batch_size>>();
+      copy_parameters( *model->nn, *network );
+      return network;
+    } );
+    serve( *batched, socket_path, deadline_ns );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc < 2 or argc > 4 ) {
+      cerr << "Usage: " << argv[0] << " WEIGHTS_FILE [SOCKET_PATH] [DEADLINE_US]\n";
+      return EXIT_FAILURE;
+    }
+
+    /* a client that disconnects mid-reply should not kill the server */
+    signal( SIGPIPE, SIG_IGN );
+
+    const string socket_path = argc >= 3 ? argv[2] : default_socket_path;
+    const uint64_t deadline_ns = ( argc >= 4 ? stoul( argv[3] ) : 200 ) * 1000;
+    program_body( argv[1], socket_path, deadline_ns );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
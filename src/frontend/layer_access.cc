@@ -1,6 +1,6 @@
+#include "eigen.hh"
 #include "neuralnetwork.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <fstream>
 #include <memory>
@@ -1,8 +1,8 @@
+#include "eigen.hh"
 #include "exception.hh"
 #include "network.hh"
 #include "timer.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <random>
 #include <utility>
@@ -0,0 +1,154 @@
+/**
+ * File name: make_weight_image.cc
+ * Last Update: October 2026
+ * Description: This file converts a text weights file (the format read by
+ *              NeuralNetwork::init_params and written by printWeights) into a
+ *              binary weight image (weight_image.hh) that processes can map
+ *              and share instead of parsing. The layer sizes are read from
+ *              the text file. It then maps the image back and checks every
+ *              parameter, and reports how long the parse and the mapping take.
+ *
+ * Usage: make_weight_image TEXT_WEIGHTS IMAGE
+ */
+
+#include "eigen.hh"
+#include "timer.hh"
+#include "weight_image.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace Eigen;
+
+using DynamicMatrix = Matrix<float, Dynamic, Dynamic>;
+
+/* one row of parameters, e.g. "[ 0.6418, -0.2696]" */
+vector<float> parse_row( string line )
+{
+  replace( line.begin(), line.end(), '[', ' ' );
+  replace( line.begin(), line.end(), ']', ' ' );
+  replace( line.begin(), line.end(), ',', ' ' );
+
+  vector<float> ret;
+  istringstream stream { line };
+  float value;
+  while ( stream >> value ) {
+    ret.push_back( value );
+  }
+  return ret;
+}
+
+DynamicMatrix to_matrix( const vector<vector<float>>& rows )
+{
+  if ( rows.empty() ) {
+    throw runtime_error( "empty matrix in weights file" );
+  }
+  DynamicMatrix ret( rows.size(), rows.front().size() );
+  for ( size_t i = 0; i < rows.size(); i++ ) {
+    if ( rows[i].size() != rows.front().size() ) {
+      throw runtime_error( "ragged matrix in weights file" );
+    }
+    ret.row( i ) = Map<const Matrix<float, 1, Dynamic>>( rows[i].data(), rows[i].size() );
+  }
+  return ret;
+}
+
+vector<pair<DynamicMatrix, DynamicMatrix>> parse_weights( const string& filename )
+{
+  ifstream file { filename };
+  if ( not file ) {
+    throw runtime_error( "could not open " + filename );
+  }
+
+  vector<pair<DynamicMatrix, DynamicMatrix>> layers;
+  vector<vector<float>> weight_rows, bias_rows;
+  vector<vector<float>>* current = nullptr;
+
+  const auto finish_layer = [&] {
+    if ( not weight_rows.empty() ) {
+      layers.emplace_back( to_matrix( weight_rows ), to_matrix( bias_rows ) );
+    }
+    weight_rows.clear();
+    bias_rows.clear();
+  };
+
+  string line;
+  while ( getline( file, line ) ) {
+    if ( line.empty() ) {
+      continue;
+    } else if ( line.find( "weights" ) != string::npos ) {
+      current = &weight_rows;
+    } else if ( line.find( "biases" ) != string::npos ) {
+      current = &bias_rows;
+    } else if ( line.find( '[' ) != string::npos ) {
+      if ( not current ) {
+        throw runtime_error( "parameters before \"weights:\" in " + filename );
+      }
+      current->push_back( parse_row( line ) );
+    } else {
+      /* layer number */
+      finish_layer();
+      current = nullptr;
+    }
+  }
+  finish_layer();
+
+  return layers;
+}
+
+void program_body( const string& text_filename, const string& image_filename )
+{
+  uint64_t start = Timer::timestamp_ns();
+  const auto layers = parse_weights( text_filename );
+  const uint64_t parse_ns = Timer::timestamp_ns() - start;
+
+  WeightImage::write( image_filename, layers );
+
+  start = Timer::timestamp_ns();
+  const WeightImage image { image_filename };
+  const uint64_t map_ns = Timer::timestamp_ns() - start;
+
+  cout << "layer sizes:";
+  for ( const auto size : image.layer_sizes() ) {
+    cout << " " << size;
+  }
+  cout << "\nimage size: " << image.size() << " bytes\n";
+
+  for ( unsigned int i = 0; i < image.num_layers(); i++ ) {
+    const auto& [weights, biases] = layers[i];
+    if ( Map<const DynamicMatrix>( image.weights<float>( i ), weights.rows(), weights.cols() ) != weights
+         or Map<const DynamicMatrix>( image.biases<float>( i ), 1, biases.cols() ) != biases ) {
+      throw runtime_error( "image does not match the text weights in layer " + to_string( i ) );
+    }
+  }
+
+  cout << "parse text: ";
+  Timer::pp_ns( cout, parse_ns );
+  cout << "\nmap image:  ";
+  Timer::pp_ns( cout, map_ns );
+  cout << "\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 3 ) {
+      cerr << "Usage: " << argv[0] << " TEXT_WEIGHTS IMAGE\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( argv[1], argv[2] );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -1,5 +1,5 @@
+#include "eigen.hh"
 #include "timer.hh"
-#include <Eigen/Dense>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
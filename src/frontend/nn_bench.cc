@@ -0,0 +1,561 @@
+/**
+ * File name: nn_bench.cc
+ * Last Update: October 2026
+ * Description: This file is a reproducible microbenchmark suite for the layer
+ *              and network kernels, replacing hand-timed tables such as the
+ *              one in progress_reports/06_14_2022.txt.
+ *
+ *              It covers the activation policies (forward and fused delta
+ *              kernels), Layer::apply, Layer::applyWith<LeakyReLU> and
+ *              <GELU>, computeDeltas, evaluateGradients and
+ *              modifyParamWholeLayer over the layer shapes we use, forward
+ *              passes and full training steps of our network shapes, the
+ *              per-event cost of RecurrentNetwork (streaming, and re-reading
+ *              the window), forward passes, sliding-window updates and training
+ *              steps of ConvolutionalNetwork, and NeuralNetwork::init_params
+ *              load time.
+ *
+ *              Each benchmark first calibrates the number of iterations so
+ *              one repetition takes about --rep-ms, runs --warmup untimed
+ *              repetitions, then --reps timed ones. It reports ns/iter (mean,
+ *              stddev, min, median, max), GFLOP/s and GB/s, computed from the
+ *              mean. FLOPs count multiply-adds as 2. Bytes count the
+ *              parameter-sized matrices as the kernel touches them (e.g. the
+ *              zero-fill plus read-modify-write of grad_weights_ in
+ *              evaluateGradients), since they dominate the traffic.
+ *
+ *              Layers with at least parallel_layer_weights weights run on
+ *              the threads of ThreadPool::layers() (layer.hh); run with
+ *              NN_LAYER_THREADS=1 to time them on one core.
+ *
+ *              --json writes all results as JSON, so two commits can be
+ *              compared entry by entry.
+ *
+ * Usage: nn_bench [--filter SUBSTRING] [--reps N] [--warmup N] [--rep-ms MS]
+ *                 [--label TEXT] [--json FILE]
+ */
+
+#include "convolutional_network.hh"
+#include "eigen.hh"
+#include "exception.hh"
+#include "neuralnetwork.hh"
+#include "recurrent_network.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+
+/* s as a quoted JSON string, with quotes, backslashes and control characters escaped */
+string json_string( const string& s )
+{
+  string ret = "\"";
+  for ( const char c : s ) {
+    if ( c == '"' or c == '\\' ) {
+      ret += '\\';
+      ret += c;
+    } else if ( static_cast<unsigned char>( c ) < 0x20 ) {
+      char escaped[7];
+      snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+      ret += escaped;
+    } else {
+      ret += c;
+    }
+  }
+  return ret + "\"";
+}
+
+struct BenchResult
+{
+  string name;
+  string shape;
+  uint64_t iterations_per_rep;
+  double flops_per_iter;
+  double bytes_per_iter;
+  vector<double> ns_per_iter;
+
+  double mean() const
+  {
+    double sum = 0;
+    for ( const double x : ns_per_iter ) {
+      sum += x;
+    }
+    return sum / ns_per_iter.size();
+  }
+
+  double stddev() const
+  {
+    const double m = mean();
+    double sum = 0;
+    for ( const double x : ns_per_iter ) {
+      sum += ( x - m ) * ( x - m );
+    }
+    return ns_per_iter.size() > 1 ? sqrt( sum / ( ns_per_iter.size() - 1 ) ) : 0;
+  }
+
+  double quantile( const double q ) const
+  {
+    vector<double> sorted = ns_per_iter;
+    sort( sorted.begin(), sorted.end() );
+    return sorted[min<size_t>( sorted.size() - 1, q * sorted.size() )];
+  }
+
+  double gflops() const { return flops_per_iter / mean(); }
+  double gbytes_per_second() const { return bytes_per_iter / mean(); }
+};
+
+class BenchSuite
+{
+  string filter_;
+  unsigned int reps_;
+  unsigned int warmup_;
+  double rep_ns_;
+  vector<BenchResult> results_ {};
+
+public:
+  BenchSuite( const string& filter, const unsigned int reps, const unsigned int warmup, const double rep_ms )
+    : filter_( filter )
+    , reps_( reps )
+    , warmup_( warmup )
+    , rep_ns_( rep_ms * MILLION )
+  {}
+
+  bool selected( const string& name, const string& shape ) const
+  {
+    return ( name + " " + shape ).find( filter_ ) != string::npos;
+  }
+
+  /*
+   * Function Name: run
+   * Description: Times body() and records the result. If fixed_iterations is
+   *              nonzero, each repetition runs exactly that many iterations
+   *              instead of being calibrated to --rep-ms (for slow bodies).
+   */
+  template<class F>
+  void run( const string& name,
+            const string& shape,
+            const double flops,
+            const double bytes,
+            F&& body,
+            const uint64_t fixed_iterations = 0 )
+  {
+    if ( not selected( name, shape ) ) {
+      return;
+    }
+
+    const auto time_rep = [&]( const uint64_t iterations ) {
+      const uint64_t start = Timer::timestamp_ns();
+      for ( uint64_t i = 0; i < iterations; i++ ) {
+        body();
+      }
+      return double( Timer::timestamp_ns() - start );
+    };
+
+    /* calibrate: grow the iteration count until one repetition is long enough */
+    uint64_t iterations = fixed_iterations;
+    if ( iterations == 0 ) {
+      iterations = 1;
+      while ( true ) {
+        const double elapsed = time_rep( iterations );
+        if ( elapsed >= rep_ns_ / 4 or iterations >= ( uint64_t( 1 ) << 30 ) ) {
+          iterations = max<uint64_t>( 1, iterations * rep_ns_ / max( elapsed, 1.0 ) );
+          break;
+        }
+        iterations *= 4;
+      }
+    }
+
+    for ( unsigned int i = 0; i < warmup_; i++ ) {
+      time_rep( iterations );
+    }
+
+    BenchResult result { name, shape, iterations, flops, bytes, {} };
+    for ( unsigned int i = 0; i < reps_; i++ ) {
+      result.ns_per_iter.push_back( time_rep( iterations ) / iterations );
+    }
+
+    cout << left << setw( 32 ) << name << setw( 40 ) << shape << right << fixed << setprecision( 1 ) << setw( 14 )
+         << result.mean() << " ns/iter  +- " << setw( 5 ) << 100 * result.stddev() / result.mean() << "%"
+         << setprecision( 2 ) << setw( 10 ) << result.gflops() << " GFLOP/s" << setw( 10 )
+         << result.gbytes_per_second() << " GB/s\n";
+
+    results_.push_back( move( result ) );
+  }
+
+  void write_json( ostream& out, const string& label ) const
+  {
+    out << "{\n";
+    out << "  \"label\": " << json_string( label ) << ",\n";
+    out << "  \"timestamp\": " << time( nullptr ) << ",\n";
+    out << "  \"compiler\": " << json_string( __VERSION__ ) << ",\n";
+    out << "  \"eigen\": \"" << EIGEN_WORLD_VERSION << "." << EIGEN_MAJOR_VERSION << "." << EIGEN_MINOR_VERSION
+        << "\",\n";
+    out << "  \"simd\": " << json_string( SimdInstructionSetsInUse() ) << ",\n";
+    out << "  \"reps\": " << reps_ << ",\n";
+    out << "  \"warmup\": " << warmup_ << ",\n";
+    out << "  \"benchmarks\": [\n";
+    out << setprecision( 6 ) << defaultfloat;
+    for ( size_t i = 0; i < results_.size(); i++ ) {
+      const BenchResult& r = results_[i];
+      out << "    {\"name\": " << json_string( r.name ) << ", \"shape\": " << json_string( r.shape )
+          << ", \"iterations_per_rep\": " << r.iterations_per_rep << ", \"ns_per_iter\": {\"mean\": " << r.mean()
+          << ", \"stddev\": " << r.stddev() << ", \"min\": " << r.quantile( 0 ) << ", \"median\": "
+          << r.quantile( 0.5 ) << ", \"max\": " << r.quantile( 1 ) << "}, \"flops_per_iter\": " << r.flops_per_iter
+          << ", \"bytes_per_iter\": " << r.bytes_per_iter << ", \"gflops\": " << r.gflops()
+          << ", \"gbytes_per_s\": " << r.gbytes_per_second() << "}" << ( i + 1 < results_.size() ? "," : "" )
+          << "\n";
+    }
+    out << "  ]\n}\n";
+  }
+};
+
+/* Layer kernels at one shape */
+template<unsigned int input_size, unsigned int output_size>
+void bench_layer( BenchSuite& suite )
+{
+  using LayerT = Layer<float, batch_size, input_size, output_size>;
+  const string shape = to_string( input_size ) + "x" + to_string( output_size );
+  const double macs = double( batch_size ) * input_size * output_size;
+  const double param_bytes = sizeof( float ) * double( input_size ) * output_size;
+
+  mt19937 rng( 0 );
+  auto layer = make_unique<LayerT>();
+  layer->initializeWeightsRandomly( rng );
+  const Matrix<float, batch_size, input_size> input = Matrix<float, batch_size, input_size>::Random();
+  const Matrix<float, batch_size, output_size> next_deltas = Matrix<float, batch_size, output_size>::Random();
+  layer->apply( input );
+  LayerT* l = layer.get();
+
+  suite.run( "Layer::apply", shape, 2 * macs, param_bytes, [&] {
+    l->apply( input );
+    do_not_optimize( l );
+  } );
+  suite.run( "Layer::applyWith<LeakyReLU>", shape, 2 * macs, param_bytes, [&] {
+    l->template applyWith<activation::LeakyReLU>( input );
+    do_not_optimize( l );
+  } );
+  suite.run( "Layer::applyWith<GELU>", shape, 2 * macs, param_bytes, [&] {
+    l->template applyWith<activation::GELU>( input );
+    do_not_optimize( l );
+  } );
+  suite.run( "Layer::computeDeltas", shape, 2 * macs, param_bytes, [&] {
+    auto d = l->computeDeltas( next_deltas );
+    do_not_optimize( &d );
+  } );
+  suite.run( "Layer::evaluateGradients", shape, 2 * macs, 3 * param_bytes, [&] {
+    l->evaluateGradients( input );
+    do_not_optimize( l );
+  } );
+  suite.run( "Layer::modifyParamWholeLayer", shape, 2 * macs, 3 * param_bytes, [&] {
+    l->modifyParamWholeLayer( 1e-30 );
+    do_not_optimize( l );
+  } );
+}
+
+/* an activation policy's forward and fused delta kernels on one layer's outputs */
+template<class Activation>
+void bench_activation( BenchSuite& suite, const string& name, const unsigned int width )
+{
+  const string shape = "1x" + to_string( width );
+  const double bytes = 2 * sizeof( float ) * double( width );
+
+  const ArrayXf z = ArrayXf::Random( width ) * 4;
+  const ArrayXf next_deltas = ArrayXf::Random( width );
+  ArrayXf a = Activation::forward( z );
+  ArrayXf deltas( width );
+
+  suite.run( name + "::forward", shape, 0, bytes, [&] {
+    a = Activation::forward( z );
+    do_not_optimize( a.data() );
+  } );
+  suite.run( name + "::deltas", shape, 0, 1.5 * bytes, [&] {
+    deltas = next_deltas * Activation::derivative( z, a );
+    do_not_optimize( deltas.data() );
+  } );
+}
+
+/* Forward pass, backward pass and full training step (apply, computeDeltas, evaluateGradients, update) of one
+ * network shape */
+template<unsigned int input_size, unsigned int... rest>
+void bench_network( BenchSuite& suite )
+{
+  using NetworkT = Network<float, batch_size, input_size, rest...>;
+
+  constexpr unsigned int dims[] = { input_size, rest... };
+  string shape = to_string( input_size );
+  double macs = 0;
+  for ( size_t i = 1; i < sizeof( dims ) / sizeof( dims[0] ); i++ ) {
+    shape += "-" + to_string( dims[i] );
+    macs += double( batch_size ) * dims[i - 1] * dims[i];
+  }
+  const double param_bytes = sizeof( float ) * macs / batch_size;
+
+  mt19937 rng( 0 );
+  auto nn = make_unique<NetworkT>();
+  nn->initializeWeightsRandomly( rng );
+  const Matrix<float, batch_size, input_size> input = Matrix<float, batch_size, input_size>::Random();
+  NetworkT* n = nn.get();
+
+  suite.run( "Network::apply", shape, 2 * macs, param_bytes, [&] {
+    n->apply( input );
+    do_not_optimize( n );
+  } );
+  n->apply( input );
+  suite.run( "Network::computeDeltas", shape, 2 * macs, param_bytes, [&] {
+    n->computeDeltas();
+    do_not_optimize( n );
+  } );
+  suite.run( "Network::training_step", shape, 8 * macs, 8 * param_bytes, [&] {
+    n->apply( input );
+    n->computeDeltas();
+    n->evaluateGradients( input );
+    for ( unsigned int i = 0; i < n->getNumLayers(); i++ ) {
+      n->modifyParamWholeLayer( i, 1e-30 );
+    }
+    do_not_optimize( n );
+  } );
+}
+
+/*
+ * Per-event cost of a RecurrentNetwork: the streaming step, against re-reading the whole window as a
+ * Network of the same input does. Shapes are window x event size, GRU state, read-out.
+ */
+template<unsigned int window_size, unsigned int hidden_size, unsigned int... head>
+void bench_recurrent( BenchSuite& suite )
+{
+  using RecurrentT = RecurrentNetwork<float, batch_size, window_size, 1, hidden_size, head...>;
+
+  string shape = to_string( window_size ) + "x1-gru" + to_string( hidden_size );
+  double head_macs = 0;
+  unsigned int previous = hidden_size;
+  for ( const unsigned int size : { head... } ) {
+    shape += "-" + to_string( size );
+    head_macs += double( batch_size ) * previous * size;
+    previous = size;
+  }
+  const double step_macs = double( batch_size ) * ( 1 + hidden_size ) * 3 * hidden_size + head_macs;
+  const double param_bytes = sizeof( float ) * step_macs / batch_size;
+
+  mt19937 rng( 0 );
+  auto nn = make_unique<RecurrentT>();
+  nn->initializeWeightsRandomly( rng );
+  const Matrix<float, batch_size, window_size> window = Matrix<float, batch_size, window_size>::Random();
+  RecurrentT* n = nn.get();
+
+  unsigned int t = 0;
+  suite.run( "Recurrent::apply_streaming", shape, 2 * step_macs, param_bytes, [&] {
+    n->apply_streaming( window.col( t++ % window_size ) );
+    do_not_optimize( n );
+  } );
+  suite.run( "Recurrent::apply", shape, 2 * window_size * step_macs, param_bytes, [&] {
+    n->apply( window );
+    do_not_optimize( n );
+  } );
+}
+
+/*
+ * Forward pass, one-event sliding-window update and full training step of a ConvolutionalNetwork over a window of
+ * single events (to set against bench_network rows of the same window). Shapes are window, conv channels x kernel
+ * size, read-out.
+ */
+template<unsigned int window_size, unsigned int channels, unsigned int kernel_size, unsigned int... head>
+void bench_convolutional( BenchSuite& suite )
+{
+  using ConvT = Conv1D<window_size, 1, channels, kernel_size>;
+  using ConvolutionalT = ConvolutionalNetwork<float, batch_size, ConvT, head...>;
+  constexpr unsigned int conv_outputs = ConvT::template layer_type<float, batch_size>::output_length;
+
+  string shape = to_string( window_size ) + "-conv" + to_string( channels ) + "x" + to_string( kernel_size );
+  double head_macs = 0;
+  unsigned int previous = conv_outputs * channels;
+  for ( const unsigned int size : { head... } ) {
+    shape += "-" + to_string( size );
+    head_macs += double( batch_size ) * previous * size;
+    previous = size;
+  }
+  const double position_macs = double( batch_size ) * kernel_size * channels;
+  const double macs = conv_outputs * position_macs + head_macs;
+  const double param_bytes = sizeof( float ) * ( position_macs + head_macs ) / batch_size;
+
+  mt19937 rng( 0 );
+  auto nn = make_unique<ConvolutionalT>();
+  nn->initializeWeightsRandomly( rng );
+  const Matrix<float, batch_size, window_size> input = Matrix<float, batch_size, window_size>::Random();
+  ConvolutionalT* n = nn.get();
+
+  suite.run( "Conv::apply", shape, 2 * macs, param_bytes, [&] {
+    n->apply( input );
+    do_not_optimize( n );
+  } );
+  unsigned int t = 0;
+  suite.run( "Conv::apply_shifted", shape, 2 * ( position_macs + head_macs ), param_bytes, [&] {
+    n->apply_shifted( input.col( t++ % window_size ) );
+    do_not_optimize( n );
+  } );
+  suite.run( "Conv::training_step", shape, 8 * macs, 8 * param_bytes, [&] {
+    n->apply( input );
+    n->computeDeltas();
+    n->evaluateGradients( input );
+    for ( unsigned int i = 0; i < n->getNumLayers(); i++ ) {
+      n->modifyParamWholeLayer( i, 1e-30 );
+    }
+    do_not_optimize( n );
+  } );
+}
+
+/* NeuralNetwork::init_params on a weights file written by printWeights */
+template<unsigned int num_layers, unsigned int input_size, unsigned int output_size, unsigned int... rest>
+void bench_init_params( BenchSuite& suite, const string& shape )
+{
+  using NN = NeuralNetwork<float, num_layers, batch_size, input_size, output_size, rest...>;
+
+  if ( not suite.selected( "NeuralNetwork::init_params", shape ) ) {
+    return;
+  }
+
+  string filename = "/tmp/nn_bench_weights_" + to_string( getpid() ) + ".txt";
+  mt19937 rng( 0 );
+  auto nn = make_unique<NN>();
+  nn->initialize( 0.001, rng );
+
+  /* printWeights(mode=0) prints to stdout; init_params prints every parameter it reads */
+  auto cout_buff = cout.rdbuf();
+  {
+    ofstream ofs { filename };
+    cout.rdbuf( ofs.rdbuf() );
+    nn->printWeights( filename, 0 );
+    cout.rdbuf( cout_buff );
+  }
+  ifstream sized { filename, ios::ate };
+  const double file_bytes = sized.tellg();
+
+  ofstream null_stream { "/dev/null" };
+  suite.run(
+    "NeuralNetwork::init_params",
+    shape,
+    0,
+    file_bytes,
+    [&] {
+      cout.rdbuf( null_stream.rdbuf() );
+      nn->init_params( filename );
+      cout.rdbuf( cout_buff );
+    },
+    1 );
+
+  remove( filename.c_str() );
+}
+
+void program_body( int argc, char* argv[] )
+{
+  /* remove limit on stack size */
+  const rlimit limits { RLIM_INFINITY, RLIM_INFINITY };
+  CheckSystemCall( "setrlimit", setrlimit( RLIMIT_STACK, &limits ) );
+
+  string filter, label, json_filename;
+  unsigned int reps = 10, warmup = 2;
+  double rep_ms = 20;
+  for ( int i = 1; i < argc; i++ ) {
+    const string arg = argv[i];
+    if ( i + 1 >= argc ) {
+      throw runtime_error( "missing value for " + arg );
+    }
+    const string value = argv[++i];
+    if ( arg == "--filter" ) {
+      filter = value;
+    } else if ( arg == "--reps" ) {
+      reps = stoul( value );
+    } else if ( arg == "--warmup" ) {
+      warmup = stoul( value );
+    } else if ( arg == "--rep-ms" ) {
+      rep_ms = stod( value );
+    } else if ( arg == "--label" ) {
+      label = value;
+    } else if ( arg == "--json" ) {
+      json_filename = value;
+    } else {
+      throw runtime_error( "unknown option " + arg );
+    }
+  }
+
+  if ( reps == 0 ) {
+    throw runtime_error( "--reps must be positive" );
+  }
+
+  BenchSuite suite( filter, reps, warmup, rep_ms );
+
+  for ( const unsigned int width : { 480u, 2560u } ) {
+    bench_activation<activation::ReLU>( suite, "ReLU", width );
+    bench_activation<activation::LeakyReLU>( suite, "LeakyReLU", width );
+    bench_activation<activation::GELU>( suite, "GELU", width );
+    bench_activation<activation::FastGELU>( suite, "FastGELU", width );
+    bench_activation<activation::Tanh>( suite, "Tanh", width );
+    bench_activation<activation::FastTanh>( suite, "FastTanh", width );
+    bench_activation<activation::Sigmoid>( suite, "Sigmoid", width );
+    bench_activation<activation::FastSigmoid>( suite, "FastSigmoid", width );
+    bench_activation<activation::Softplus>( suite, "Softplus", width );
+  }
+
+  bench_layer<16, 16>( suite );
+  bench_layer<1, 4096>( suite );
+  bench_layer<4096, 1>( suite );
+  bench_layer<256, 256>( suite );
+  bench_layer<1024, 1024>( suite );
+  bench_layer<2048, 2048>( suite );
+  bench_layer<2500, 2500>( suite );
+  bench_layer<2560, 2560>( suite );
+
+  bench_network<16, 16, 1>( suite );
+  bench_network<1, 4096, 1>( suite );
+  bench_network<1, 2048, 2048, 1>( suite );
+  bench_network<1, 1024, 1024, 1024, 1024, 1>( suite );
+  bench_network<1, 256, 256, 256, 256, 256, 256, 256, 256, 1>( suite );
+  bench_network<16, 16, 1, 2500, 2500, 2>( suite );
+
+  bench_recurrent<16, 32, 16, 1>( suite );
+  bench_recurrent<16, 128, 1>( suite );
+  bench_recurrent<64, 128, 1>( suite );
+
+  bench_network<16, 2500, 1>( suite );
+  bench_convolutional<16, 16, 4, 16, 1>( suite );
+  bench_convolutional<16, 64, 4, 1>( suite );
+
+  bench_init_params<2, 16, 1, 16, 1>( suite, "16-16-1" );
+  bench_init_params<3, 1, 1, 480, 480, 1>( suite, "1-480-480-1" );
+
+  if ( not json_filename.empty() ) {
+    ofstream out { json_filename };
+    suite.write_json( out, label );
+    out.flush();
+    if ( not out ) {
+      throw runtime_error( "could not write " + json_filename );
+    }
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+    program_body( argc, argv );
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,289 @@
+/**
+ * File name: onset_mux.cc
+ * Last Update: October 2026
+ * Description: This file serves many onset-event streams from one thread with
+ *              an EventLoop, and feeds them into the tempo network.
+ *
+ *              A generator thread plays a steady beat, each at its own
+ *              tempo, into STREAMS streams, split evenly between pipes
+ *              carrying timestamps, socket pairs carrying timestamps, and
+ *              pipes standing in for MIDI devices (note-on/note-off
+ *              messages). The event loop thread reads every stream
+ *              (edge-triggered), and once a stream has 16 onsets, predicts
+ *              its tempo after each new onset. Predictions are batched: the
+ *              streams with new onsets in one wakeup run through the
+ *              network together, 8 at a time.
+ *
+ *              At the end it reports the mean tempo error of each kind of
+ *              stream, the event loop's wakeups and callbacks, and the global
+ *              timer (time waiting for events vs. in callbacks).
+ *
+ *              With LOG, every onset is also recorded in an onset log
+ *              (onset_log.hh) for onset_replay.
+ *
+ * Usage: onset_mux IMAGE [STREAMS] [SECONDS] [LOG]
+ *        (IMAGE from make_weight_image; defaults: 240 streams, 10 s)
+ */
+
+#include "eigen.hh"
+#include "eventloop.hh"
+#include "onset_log.hh"
+#include "socket.hh"
+#include "tempo_stream.hh"
+#include "timer.hh"
+#include "weight_image.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+using namespace tempo_stream;
+
+constexpr unsigned int big_batch_size = 8;
+
+template<unsigned int batch_size>
+using TempoNetwork = MappedNetwork<float, batch_size, window_size, 16, 1, 480, 480, 1>;
+
+enum class Kind
+{
+  Pipe,
+  Socket,
+  Midi,
+  count
+};
+
+constexpr array<const char*, size_t( Kind::count )> kind_names { "pipe (timestamps)", "socket (timestamps)",
+                                                                  "MIDI stand-in" };
+
+struct Stream
+{
+  Kind kind;
+  float tempo;
+  FileDescriptor reader;
+  FileDescriptor writer;
+  OnsetParser parser;
+
+  unsigned int num_predictions {};
+  double total_error {};
+};
+
+/* write each stream's beat until `end`, then close the writers */
+void play_beats( vector<Stream>& streams, const chrono::steady_clock::time_point end )
+{
+  using Beat = pair<chrono::steady_clock::time_point, size_t>;
+  priority_queue<Beat, vector<Beat>, greater<Beat>> beats;
+
+  mt19937 rng( 0 );
+  for ( size_t i = 0; i < streams.size(); i++ ) {
+    /* start each stream at a random phase of its beat */
+    const auto period = chrono::duration<double>( 60.0 / streams[i].tempo );
+    beats.push( { chrono::steady_clock::now()
+                    + chrono::duration_cast<chrono::steady_clock::duration>(
+                      period * uniform_real_distribution<double>( 0, 1 )( rng ) ),
+                  i } );
+  }
+
+  while ( not beats.empty() and beats.top().first < end ) {
+    const auto [time, i] = beats.top();
+    beats.pop();
+    this_thread::sleep_until( time );
+
+    Stream& stream = streams[i];
+    if ( stream.kind == Kind::Midi ) {
+      stream.writer.write( { midi_note_on.data(), midi_note_on.size() } );
+      stream.writer.write( { midi_note_off.data(), midi_note_off.size() } );
+    } else {
+      const uint64_t time_ns = chrono::duration_cast<chrono::nanoseconds>( time.time_since_epoch() ).count();
+      stream.writer.write( { reinterpret_cast<const char*>( &time_ns ), sizeof( time_ns ) } );
+    }
+
+    beats.push( { time + chrono::duration_cast<chrono::steady_clock::duration>(
+                           chrono::duration<double>( 60.0 / stream.tempo ) ),
+                  i } );
+  }
+
+  for ( auto& stream : streams ) {
+    stream.writer.close();
+  }
+}
+
+void program_body( const string& image_filename,
+                   const unsigned int num_streams,
+                   const double seconds,
+                   const optional<string>& log_filename )
+{
+  const WeightImage image { image_filename };
+  auto network = make_unique<TempoNetwork<1>>( image );
+  auto big_network = make_unique<TempoNetwork<big_batch_size>>( image );
+
+  mt19937 rng( 1 );
+  uniform_real_distribution<float> tempo_dist( 60, 180 );
+
+  vector<Stream> streams;
+  streams.reserve( num_streams );
+  for ( unsigned int i = 0; i < num_streams; i++ ) {
+    const Kind kind = Kind( i % size_t( Kind::count ) );
+    const Format format = kind == Kind::Midi ? Format::Midi : Format::Timestamps;
+    if ( kind == Kind::Socket ) {
+      auto [reader, writer] = LocalStreamSocket::make_pair();
+      streams.push_back( { kind, tempo_dist( rng ), move( reader ), move( writer ), OnsetParser { format } } );
+    } else {
+      auto [reader, writer] = make_pipe();
+      streams.push_back( { kind, tempo_dist( rng ), move( reader ), move( writer ), OnsetParser { format } } );
+    }
+    streams.back().reader.set_blocking( false );
+  }
+
+  EventLoop loop;
+  const size_t read_category = loop.add_category( "read onsets" );
+  const size_t inference_category = loop.add_category( "predict tempo" );
+
+  /* streams with a new onset since the last prediction */
+  vector<size_t> updated;
+  vector<bool> is_updated( num_streams );
+  unsigned int open_streams = num_streams;
+  string buffer( 4096, 0 );
+
+  unique_ptr<OnsetLogWriter> log;
+  optional<EventLoop::RuleHandle> log_rule;
+  if ( log_filename.has_value() ) {
+    vector<float> tempos;
+    for ( const auto& stream : streams ) {
+      tempos.push_back( stream.tempo );
+    }
+    log = make_unique<OnsetLogWriter>( log_filename.value(), tempos );
+    log_rule = loop.add_rule(
+      "write onset log",
+      [&] {
+        log->flush();
+        if ( open_streams == 0 ) {
+          log_rule->cancel();
+        }
+      },
+      [&] { return log->wants_flush() or open_streams == 0; } );
+  }
+
+  for ( size_t i = 0; i < num_streams; i++ ) {
+    loop.add_rule(
+      read_category,
+      streams[i].reader,
+      Direction::In,
+      [&, i] {
+        Stream& stream = streams[i];
+        const size_t bytes_read = stream.reader.read( { buffer.data(), buffer.size() } );
+        const auto record = [&]( const uint64_t time_ns ) {
+          if ( log ) {
+            log->record( i, time_ns );
+          }
+        };
+        if ( stream.parser.parse( { buffer.data(), bytes_read }, Timer::timestamp_ns(), record ) > 0
+             and stream.parser.window_full() and not is_updated[i] ) {
+          is_updated[i] = true;
+          updated.push_back( i );
+        }
+      },
+      [] { return true; },
+      [&] { open_streams--; } );
+  }
+
+  const auto record_prediction = [&]( const size_t i, const float prediction ) {
+    streams[i].num_predictions++;
+    streams[i].total_error += abs( prediction - streams[i].tempo );
+    is_updated[i] = false;
+  };
+
+  EventLoop::RuleHandle inference_rule = loop.add_rule(
+    inference_category,
+    [&] {
+      size_t next = 0;
+      for ( ; next + big_batch_size <= updated.size(); next += big_batch_size ) {
+        Matrix<float, big_batch_size, window_size> input;
+        for ( unsigned int j = 0; j < big_batch_size; j++ ) {
+          input.row( j ) = streams[updated[next + j]].parser.window();
+        }
+        big_network->apply( input );
+        for ( unsigned int j = 0; j < big_batch_size; j++ ) {
+          record_prediction( updated[next + j], big_network->output()( j, 0 ) );
+        }
+      }
+      for ( ; next < updated.size(); next++ ) {
+        network->apply( streams[updated[next]].parser.window() );
+        record_prediction( updated[next], network->output()( 0, 0 ) );
+      }
+      updated.clear();
+
+      if ( open_streams == 0 ) {
+        inference_rule.cancel();
+      }
+    },
+    [&] { return not updated.empty() or open_streams == 0; } );
+
+  cout << "Serving " << num_streams << " streams for " << seconds << " s\n";
+
+  reset_global_timer();
+  const auto end = chrono::steady_clock::now()
+                   + chrono::duration_cast<chrono::steady_clock::duration>( chrono::duration<double>( seconds ) );
+  thread generator( play_beats, ref( streams ), end );
+
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+  generator.join();
+
+  cout << "\n";
+  for ( size_t k = 0; k < size_t( Kind::count ); k++ ) {
+    unsigned int count = 0, predictions = 0;
+    uint64_t onsets = 0;
+    double total_error = 0;
+    for ( const auto& stream : streams ) {
+      if ( stream.kind == Kind( k ) ) {
+        count++;
+        onsets += stream.parser.num_onsets();
+        predictions += stream.num_predictions;
+        total_error += stream.total_error;
+      }
+    }
+    cout << kind_names[k] << ": " << count << " streams, " << onsets << " onsets, " << predictions
+         << " predictions, mean |error| " << total_error / max( predictions, 1U ) << " bpm\n";
+  }
+
+  if ( log ) {
+    log->flush();
+    cout << "recorded " << log->num_records() << " onsets in " << log_filename.value() << "\n";
+  }
+
+  cout << "\n";
+  loop.summary( cout );
+  cout << "\n";
+  global_timer_summary( cout );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc < 2 or argc > 5 ) {
+      cerr << "Usage: " << argv[0] << " IMAGE [STREAMS] [SECONDS] [LOG]\n";
+      return EXIT_FAILURE;
+    }
+
+    const unsigned int num_streams = argc >= 3 ? stoul( argv[2] ) : 240;
+    const double seconds = argc >= 4 ? stod( argv[3] ) : 10;
+    const optional<string> log_filename = argc >= 5 ? optional<string> { argv[4] } : nullopt;
+    program_body( argv[1], num_streams, seconds, log_filename );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
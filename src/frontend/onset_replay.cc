@@ -0,0 +1,132 @@
+/**
+ * File name: onset_replay.cc
+ * Last Update: October 2026
+ * Description: This file replays an onset log (recorded by onset_mux) through
+ *              the streaming tempo path: each onset is encoded as it arrived
+ *              on the wire, parsed by its stream's OnsetParser, and once the
+ *              stream has 16 onsets, its tempo is predicted.
+ *
+ *              In realtime mode each onset is replayed at its recorded time,
+ *              and its latency runs from that time to the end of its
+ *              prediction (so it includes any lateness of the replay itself).
+ *              In fast mode onsets are replayed back to back, and the latency
+ *              is the time to process each one.
+ *
+ *              It reports onsets/sec, the latency distribution of onsets with
+ *              and without a prediction, and the mean tempo error.
+ *
+ * Usage: onset_replay IMAGE LOG [realtime|fast] [REPEAT]
+ *        (defaults: fast, 1 repetition)
+ */
+
+#include "eigen.hh"
+#include "onset_log.hh"
+#include "tempo_stream.hh"
+#include "timer.hh"
+#include "weight_image.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+using namespace tempo_stream;
+
+using TempoNetwork = MappedNetwork<float, 1, window_size, 16, 1, 480, 480, 1>;
+
+void print_latencies( const string& name, vector<uint64_t> latencies )
+{
+  if ( latencies.empty() ) {
+    return;
+  }
+  sort( latencies.begin(), latencies.end() );
+  const auto quantile = [&]( const double q ) { return latencies.at( size_t( q * ( latencies.size() - 1 ) ) ); };
+
+  cout << "  " << name << ": " << setw( 8 ) << latencies.size() << " onsets, p50 ";
+  Timer::pp_ns( cout, quantile( 0.5 ) );
+  cout << ", p99 ";
+  Timer::pp_ns( cout, quantile( 0.99 ) );
+  cout << ", p99.9 ";
+  Timer::pp_ns( cout, quantile( 0.999 ) );
+  cout << ", max ";
+  Timer::pp_ns( cout, latencies.back() );
+  cout << defaultfloat << "\n";
+}
+
+void program_body( const string& image_filename, const string& log_filename, const bool realtime, const unsigned int repeat )
+{
+  const WeightImage image { image_filename };
+  auto network = make_unique<TempoNetwork>( image );
+  const OnsetLog log { log_filename };
+
+  cout << "Replaying " << log.size() << " onsets from " << log.num_streams() << " streams "
+       << ( realtime ? "in real time" : "as fast as possible" ) << ", " << repeat << " time(s)\n";
+
+  vector<uint64_t> predicted_latencies, other_latencies;
+  predicted_latencies.reserve( log.size() * repeat );
+  other_latencies.reserve( log.size() * repeat );
+  double total_error = 0;
+
+  const uint64_t replay_start = Timer::timestamp_ns();
+  for ( unsigned int r = 0; r < repeat; r++ ) {
+    const uint64_t start = Timer::timestamp_ns();
+    OnsetReplayer replayer { log.num_streams(), start };
+
+    for ( size_t i = 0; i < log.size(); i++ ) {
+      const onset_log::Onset onset = log[i];
+      const uint64_t scheduled = start + onset.time_ns;
+      if ( realtime ) {
+        while ( Timer::timestamp_ns() < scheduled ) {
+          this_thread::sleep_for( chrono::nanoseconds( scheduled - Timer::timestamp_ns() ) );
+        }
+      }
+
+      const uint64_t begin = realtime ? scheduled : Timer::timestamp_ns();
+      const bool predict = replayer.feed( onset, begin );
+      if ( predict ) {
+        network->apply( replayer.parser( onset.stream ).window() );
+        total_error += abs( network->output()( 0, 0 ) - log.tempo( onset.stream ) );
+      }
+
+      const uint64_t latency = Timer::timestamp_ns() - begin;
+      ( predict ? predicted_latencies : other_latencies ).push_back( latency );
+    }
+  }
+  const uint64_t elapsed = Timer::timestamp_ns() - replay_start;
+
+  const size_t num_onsets = predicted_latencies.size() + other_latencies.size();
+  cout << fixed << setprecision( 0 ) << num_onsets / ( elapsed / BILLION ) << " onsets/sec, "
+       << predicted_latencies.size() << " predictions, mean |error| " << setprecision( 2 )
+       << total_error / max<size_t>( predicted_latencies.size(), 1 ) << " bpm\n";
+  cout << "latency:\n";
+  print_latencies( "with prediction   ", predicted_latencies );
+  print_latencies( "filling the window", other_latencies );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc < 3 or argc > 5 or ( argc >= 4 and string( argv[3] ) != "realtime" and string( argv[3] ) != "fast" ) ) {
+      cerr << "Usage: " << argv[0] << " IMAGE LOG [realtime|fast] [REPEAT]\n";
+      return EXIT_FAILURE;
+    }
+
+    const bool realtime = argc >= 4 and string( argv[3] ) == "realtime";
+    const unsigned int repeat = argc >= 5 ? stoul( argv[4] ) : 1;
+    program_body( argv[1], argv[2], realtime, repeat );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -1,6 +1,6 @@
 // Test reading file to initialize weights/biases
+#include "eigen.hh"
 #include "neuralnetwork.hh"
-#include <Eigen/Dense>
 #include <iostream>
 #include <filesystem>
 #include <memory>
@@ -0,0 +1,102 @@
+/**
+ * File name: perf_phases.cc
+ * Last Update: October 2026
+ * Description: This file runs training steps of a 1->2048->2048->1 network
+ *              (the largest shape in the 06_14_2022 speed table) and counts
+ *              cycles, instructions, LLC misses and dTLB misses separately for
+ *              each phase of a step: apply, computeDeltas, evaluateGradients
+ *              and the parameter update. The counters come from
+ *              perf_event_open(2); where they are unavailable (e.g. in a VM
+ *              without a virtual PMU) only wall time is reported.
+ *
+ * Usage: perf_phases NUM_ITERATIONS
+ */
+
+#include "eigen.hh"
+#include "neuralnetwork.hh"
+#include "perf_counters.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr size_t input_size = 1;
+constexpr size_t output_size = 1;
+constexpr size_t num_layers = 3;
+
+void program_body( const unsigned int num_iterations )
+{
+  auto nn = make_unique<NeuralNetwork<float, num_layers, batch_size, input_size, output_size, 2048, 2048, 1>>();
+  mt19937 rng( 0 );
+  nn->initialize( 0.000001, rng );
+  auto& net = *nn->nn;
+
+  PerfCounters counters;
+  PerfCounters::Record apply {}, compute_deltas {}, evaluate_gradients {}, update {}, step {};
+
+  Matrix<float, batch_size, input_size> input;
+  Matrix<float, batch_size, output_size> ground_truth_output;
+  uniform_real_distribution<float> input_dist( -1, 1 );
+
+  for ( unsigned int i = 0; i < num_iterations; i++ ) {
+    input( 0, 0 ) = input_dist( rng );
+    ground_truth_output( 0, 0 ) = 2 * input( 0, 0 );
+
+    PerfScopeCounter whole_step { counters, step };
+
+    {
+      PerfScopeCounter scope { counters, apply };
+      net.apply( input );
+    }
+
+    {
+      PerfScopeCounter scope { counters, compute_deltas };
+      net.computeDeltas();
+    }
+
+    {
+      PerfScopeCounter scope { counters, evaluate_gradients };
+      net.evaluateGradients( input );
+    }
+
+    {
+      PerfScopeCounter scope { counters, update };
+      const float pd_loss_wrt_output = -2 * ( ground_truth_output( 0, 0 ) - net.output()( 0, 0 ) );
+      for ( unsigned int layer = 0; layer < net.getNumLayers(); layer++ ) {
+        net.modifyParamWholeLayer( layer, nn->get_current_learning_rate() * pd_loss_wrt_output );
+      }
+    }
+  }
+
+  counters.summary( cout,
+                    { { "apply", apply },
+                      { "computeDeltas", compute_deltas },
+                      { "evaluateGradients", evaluate_gradients },
+                      { "update", update },
+                      { "whole step", step } } );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 2 ) {
+      cerr << "Usage: " << argv[0] << " NUM_ITERATIONS\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( stoi( argv[1] ) );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -1,11 +1,11 @@
 /**
   This file tries to predict 1/x given x
 */
+#include "eigen.hh"
 #include "exception.hh"
 #include "network.hh"
 #include "timer.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <random>
 #include <utility>
@@ -1,7 +1,7 @@
+#include "eigen.hh"
 #include "neuralnetwork.hh"
 
 #include <cmath>
-#include <Eigen/Dense>
 #include <iostream>
 #include <memory>
 #include <random>
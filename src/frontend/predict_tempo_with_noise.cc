@@ -4,11 +4,11 @@
 
   We want range of tempo: 35 - 250 bpm //TODO
 */
+#include "eigen.hh"
 #include "exception.hh"
 #include "network.hh"
 #include "timer.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <random>
 #include <utility>
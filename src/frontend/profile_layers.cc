@@ -0,0 +1,87 @@
+/**
+ * File name: profile_layers.cc
+ * Last Update: October 2026
+ * Description: This file runs leaky training steps of the
+ *              16->16->1->2500->2500->2 tempo network (eighteen_outputs.cc)
+ *              and prints the per-layer time spent in apply, computeDeltas,
+ *              evaluateGradients and update, to show which layer dominates a
+ *              step, with hardware counts per call where the machine provides
+ *              them. It is built with NN_PROFILE and NN_PERF_COUNTERS defined
+ *              (see CMakeLists.txt).
+ *
+ * Usage: profile_layers NUM_ITERATIONS
+ */
+
+#include "eigen.hh"
+#include "neuralnetwork.hh"
+#include "profile.hh"
+#include "timer.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr size_t input_size = 16;
+constexpr size_t output_size = 2;
+constexpr size_t num_layers = 5;
+
+void program_body( const unsigned int num_iterations )
+{
+  auto nn = make_unique<NeuralNetwork<float, num_layers, batch_size, input_size, output_size, 16, 1, 2500, 2500, 2>>();
+  mt19937 rng( 0 );
+  nn->initialize( 0.000000001, rng );
+
+  NetworkProfile profile( *nn->nn );
+
+  Matrix<float, batch_size, input_size> input;
+  Matrix<float, batch_size, output_size> ground_truth_output;
+  uniform_real_distribution<float> tempo_dist( 30, 240 );
+
+  /* warm up caches before measuring */
+  for ( unsigned int i = 0; i < 10; i++ ) {
+    nn->apply_leaky( Matrix<float, batch_size, input_size>::Zero() );
+  }
+  profile.reset_summary();
+
+  const uint64_t start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < num_iterations; i++ ) {
+    const float tempo = tempo_dist( rng );
+    for ( unsigned int j = 0; j < input_size; j++ ) {
+      input( j ) = ( 60.0 / tempo ) * j;
+    }
+    ground_truth_output << tempo, -60.0 / tempo;
+    nn->leaky_gradient_descent( input, ground_truth_output, false );
+  }
+  const uint64_t end = Timer::timestamp_ns();
+
+  cout << "Average training step (over " << num_iterations << " iterations): ";
+  Timer::pp_ns( cout, ( end - start ) / float( num_iterations ) );
+  cout << "\n\n";
+
+  profile.summary( cout );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 2 ) {
+      cerr << "Usage: " << argv[0] << " NUM_ITERATIONS\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( stoi( argv[1] ) );
+
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,446 @@
+/**
+ * File name: sweep.cc
+ * Last Update: October 2026
+ * Description: This file runs a grid of tempo-prediction trials
+ *              (architecture x eta x noise x offset x seed) in parallel, with
+ *              one worker thread pinned to each available CPU. It replaces
+ *              running arch_testing.cc and compare_eta.cc one setting at a time.
+ *
+ *              Every trial trains with the leaky dynamic-learning-rate
+ *              gradient descent of NeuralNetwork and is evaluated every
+ *              `--checkpoint` iterations on the tempos 30..240 bpm. A trial
+ *              stops early when it converges, diverges, or (median stopping
+ *              rule) when its average error is worse than `--prune-factor`
+ *              times the median error that the trials on the same task
+ *              (noise/offset setting) had at the same checkpoint.
+ *
+ *              The results are written as a tab-separated table with a header
+ *              row, one row per trial, in grid order.
+ *
+ * Usage: sweep [--arch NAME,...] [--eta X,...] [--noise 0,1] [--offset 0,1]
+ *              [--seeds N] [--iterations N] [--checkpoint N] [--threshold X]
+ *              [--prune-factor X] [--min-trials N] [--threads N] [--out FILE]
+ *
+ *        Run `sweep --list` to print the available architectures.
+ */
+
+#include "affinity.hh"
+#include "eigen.hh"
+#include "neuralnetwork.hh"
+#include "tempo_training.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+constexpr size_t input_size = tempo_window_size;
+constexpr size_t output_size = 1;
+
+/* one point of the grid */
+struct Trial
+{
+  size_t id;
+  string arch;
+  float eta;
+  bool noise;
+  bool offset;
+  unsigned int seed;
+};
+
+struct TrialResult
+{
+  string status = "not run";
+  unsigned int iterations = 0;
+  float final_avg_diff = NAN;
+  float best_avg_diff = numeric_limits<float>::max();
+  float final_eta = NAN;
+  double seconds = 0;
+  unsigned int cpu = 0;
+};
+
+struct SweepOptions
+{
+  unsigned int iterations = 1000000;
+  unsigned int checkpoint = 50000;
+  float threshold = 0.2;
+  float prune_factor = 1.5;
+  unsigned int min_trials = 3;
+};
+
+/*
+ * Class Name: MedianPruner
+ * Description: Shared record of the average error every trial reported at
+ *              each checkpoint, kept separately per task (noise, offset).
+ *              A trial should stop if it is worse than prune_factor times the
+ *              median of the errors reported so far at the same checkpoint.
+ */
+class MedianPruner
+{
+  mutex mutex_ {};
+  map<pair<bool, bool>, map<unsigned int, vector<float>>> scores_ {}; // task -> iterations -> errors
+  float prune_factor_;
+  unsigned int min_trials_;
+
+public:
+  MedianPruner( const float prune_factor, const unsigned int min_trials )
+    : prune_factor_( prune_factor )
+    , min_trials_( min_trials )
+  {}
+
+  /* checkpoints are keyed by the iterations trained, so a final, partial checkpoint has its own entry */
+  bool should_stop( const Trial& trial, const unsigned int iterations, const float avg_diff )
+  {
+    lock_guard<mutex> lock( mutex_ );
+    vector<float>& scores = scores_[{ trial.noise, trial.offset }][iterations];
+    scores.push_back( avg_diff );
+    if ( scores.size() < min_trials_ ) {
+      return false;
+    }
+
+    vector<float> sorted = scores;
+    nth_element( sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end() );
+    return avg_diff > prune_factor_ * sorted[sorted.size() / 2];
+  }
+};
+
+/* average absolute error over 30..240 bpm; eval_seed fixes the noise so trials are comparable */
+template<class NN>
+float evaluate( NN& nn, const Trial& trial, const unsigned int eval_seed )
+{
+  mt19937 rng( eval_seed );
+  float total_diff = 0;
+  for ( int tempo_test = 30; tempo_test < 241; tempo_test++ ) {
+    nn.apply_leaky( gen_time( tempo_test, trial.offset, trial.noise, rng ) );
+    total_diff += abs( tempo_test - nn.get_output()( 0, 0 ) );
+  }
+  return total_diff / 211.0;
+}
+
+template<unsigned int... sizes>
+TrialResult run_trial( const Trial& trial, const SweepOptions& options, MedianPruner& pruner )
+{
+  using NN = NeuralNetwork<float, sizeof...( sizes ), batch_size, input_size, output_size, sizes...>;
+
+  mt19937 rng( trial.seed );
+  auto nn = make_unique<NN>();
+  nn->initialize( trial.eta, rng );
+
+  TrialResult result;
+  result.status = "completed";
+
+  Matrix<float, batch_size, input_size> input;
+  Matrix<float, batch_size, output_size> ground_truth_output;
+  for ( unsigned int iter = 1; iter <= options.iterations; iter++ ) {
+    const float tempo = draw_tempo( rng );
+    input = gen_time( tempo, trial.offset, trial.noise, rng );
+    ground_truth_output( 0, 0 ) = tempo;
+    nn->leaky_gradient_descent( input, ground_truth_output, true );
+    result.iterations = iter;
+
+    if ( iter % options.checkpoint != 0 and iter != options.iterations ) {
+      continue;
+    }
+
+    const float avg_diff = evaluate( *nn, trial, trial.seed + 1 );
+    result.final_avg_diff = avg_diff;
+    if ( not is_finite( avg_diff ) ) {
+      result.status = "diverged";
+      break;
+    }
+    result.best_avg_diff = min( result.best_avg_diff, avg_diff );
+
+    if ( avg_diff < options.threshold ) {
+      result.status = "converged";
+      break;
+    }
+    if ( pruner.should_stop( trial, iter, avg_diff ) ) {
+      result.status = "pruned";
+      break;
+    }
+  }
+
+  result.final_eta = nn->get_current_learning_rate();
+  return result;
+}
+
+using TrialFunction = TrialResult ( * )( const Trial&, const SweepOptions&, MedianPruner& );
+
+struct Arch
+{
+  const char* name;
+  TrialFunction run;
+  unsigned int num_params;
+};
+
+template<unsigned int... sizes>
+constexpr unsigned int count_params()
+{
+  constexpr unsigned int dims[] = { input_size, sizes... };
+  unsigned int total = 0;
+  for ( size_t i = 0; i + 1 < sizeof( dims ) / sizeof( dims[0] ); i++ ) {
+    total += ( dims[i] + 1 ) * dims[i + 1];
+  }
+  return total;
+}
+
+/* architectures are template parameters, so the sweep can only pick from this list */
+const vector<Arch>& architectures()
+{
+  static const vector<Arch> archs {
+    { "16-16-1", run_trial<16, 1>, count_params<16, 1>() },
+    { "16-32-32-1", run_trial<32, 32, 1>, count_params<32, 32, 1>() },
+    { "16-64-64-1", run_trial<64, 64, 1>, count_params<64, 64, 1>() },
+    { "16-16-3-100-340-1", run_trial<16, 3, 100, 340, 1>, count_params<16, 3, 100, 340, 1>() },
+    { "16-16-1-30-256-1", run_trial<16, 1, 30, 256, 1>, count_params<16, 1, 30, 256, 1>() },
+    { "16-16-1-30-2560-1", run_trial<16, 1, 30, 2560, 1>, count_params<16, 1, 30, 2560, 1>() },
+  };
+  return archs;
+}
+
+const Arch& find_architecture( const string& name )
+{
+  for ( const auto& arch : architectures() ) {
+    if ( name == arch.name ) {
+      return arch;
+    }
+  }
+  throw runtime_error( "unknown architecture " + name + " (see --list)" );
+}
+
+vector<string> split( const string& list )
+{
+  vector<string> ret;
+  stringstream ss( list );
+  string item;
+  while ( getline( ss, item, ',' ) ) {
+    ret.push_back( item );
+  }
+  return ret;
+}
+
+/* a comma-separated list of booleans (0, 1, false or true) */
+vector<bool> split_bools( const string& list )
+{
+  vector<bool> ret;
+  for ( const auto& item : split( list ) ) {
+    if ( item == "1" or item == "true" ) {
+      ret.push_back( true );
+    } else if ( item == "0" or item == "false" ) {
+      ret.push_back( false );
+    } else {
+      throw runtime_error( "expected 0, 1, false or true, got \"" + item + "\"" );
+    }
+  }
+  return ret;
+}
+
+/* a whole non-negative number: no sign, no trailing characters, in range of unsigned int */
+unsigned int parse_unsigned( const string& value )
+{
+  size_t pos = 0;
+  if ( value.empty() or not isdigit( static_cast<unsigned char>( value.front() ) ) ) {
+    throw runtime_error( "expected a non-negative integer, got \"" + value + "\"" );
+  }
+  const unsigned long ret = stoul( value, &pos );
+  if ( pos != value.size() or ret > numeric_limits<unsigned int>::max() ) {
+    throw runtime_error( "expected a non-negative integer, got \"" + value + "\"" );
+  }
+  return ret;
+}
+
+/* a non-negative decimal number: no sign, no trailing characters */
+float parse_float( const string& value )
+{
+  size_t pos = 0;
+  if ( value.empty() or not( isdigit( static_cast<unsigned char>( value.front() ) ) or value.front() == '.' ) ) {
+    throw runtime_error( "expected a non-negative number, got \"" + value + "\"" );
+  }
+  const float ret = stof( value, &pos );
+  if ( pos != value.size() ) {
+    throw runtime_error( "expected a non-negative number, got \"" + value + "\"" );
+  }
+  return ret;
+}
+
+void write_results( ostream& out, const vector<Trial>& trials, const vector<TrialResult>& results )
+{
+  out << "trial\tarch\teta\tnoise\toffset\tseed\tstatus\titerations\tfinal_avg_diff\tbest_avg_diff\tfinal_eta"
+         "\tseconds\tcpu\n";
+  for ( size_t i = 0; i < trials.size(); i++ ) {
+    const Trial& t = trials[i];
+    const TrialResult& r = results[i];
+    out << t.id << "\t" << t.arch << "\t" << t.eta << "\t" << t.noise << "\t" << t.offset << "\t" << t.seed << "\t"
+        << r.status << "\t" << r.iterations << "\t" << r.final_avg_diff << "\t" << r.best_avg_diff << "\t"
+        << r.final_eta << "\t" << r.seconds << "\t" << r.cpu << "\n";
+  }
+}
+
+void program_body( int argc, char* argv[] )
+{
+  vector<string> arch_names;
+  for ( const auto& arch : architectures() ) {
+    arch_names.push_back( arch.name );
+  }
+  vector<string> etas { "1e-7", "1e-8", "1e-9" };
+  vector<bool> noises { true };
+  vector<bool> offsets { false, true };
+  unsigned int num_seeds = 1;
+  unsigned int num_threads = 0;
+  string out_filename;
+  SweepOptions options;
+
+  for ( int i = 1; i < argc; i++ ) {
+    const string arg = argv[i];
+    if ( arg == "--list" ) {
+      for ( const auto& arch : architectures() ) {
+        cout << arch.name << "\t" << arch.num_params << " params\n";
+      }
+      return;
+    }
+    if ( i + 1 >= argc ) {
+      throw runtime_error( "missing value for " + arg );
+    }
+    const string value = argv[++i];
+    if ( arg == "--arch" ) {
+      arch_names = split( value );
+    } else if ( arg == "--eta" ) {
+      etas = split( value );
+    } else if ( arg == "--noise" ) {
+      noises = split_bools( value );
+    } else if ( arg == "--offset" ) {
+      offsets = split_bools( value );
+    } else if ( arg == "--seeds" ) {
+      num_seeds = parse_unsigned( value );
+    } else if ( arg == "--iterations" ) {
+      options.iterations = parse_unsigned( value );
+    } else if ( arg == "--checkpoint" ) {
+      options.checkpoint = parse_unsigned( value );
+    } else if ( arg == "--threshold" ) {
+      options.threshold = parse_float( value );
+    } else if ( arg == "--prune-factor" ) {
+      options.prune_factor = parse_float( value );
+    } else if ( arg == "--min-trials" ) {
+      options.min_trials = parse_unsigned( value );
+    } else if ( arg == "--threads" ) {
+      num_threads = parse_unsigned( value );
+    } else if ( arg == "--out" ) {
+      out_filename = value;
+    } else {
+      throw runtime_error( "unknown option " + arg );
+    }
+  }
+
+  if ( options.checkpoint == 0 ) {
+    throw runtime_error( "--checkpoint must be positive" );
+  }
+
+  /* open the output before the sweep, so a bad path fails now rather than after it */
+  ofstream out_file;
+  if ( not out_filename.empty() ) {
+    out_file.open( out_filename );
+    if ( not out_file ) {
+      throw runtime_error( "could not open " + out_filename );
+    }
+  }
+
+  /* build the grid */
+  vector<Trial> trials;
+  for ( const auto& arch : arch_names ) {
+    find_architecture( arch );
+    for ( const auto& eta : etas ) {
+      for ( const bool noise : noises ) {
+        for ( const bool offset : offsets ) {
+          for ( unsigned int seed = 0; seed < num_seeds; seed++ ) {
+            trials.push_back( { trials.size(), arch, parse_float( eta ), noise, offset, seed } );
+          }
+        }
+      }
+    }
+  }
+
+  /* start the most expensive trials first so a big one does not finish last on its own */
+  vector<size_t> order( trials.size() );
+  for ( size_t i = 0; i < order.size(); i++ ) {
+    order[i] = i;
+  }
+  stable_sort( order.begin(), order.end(), [&]( const size_t a, const size_t b ) {
+    return find_architecture( trials[a].arch ).num_params > find_architecture( trials[b].arch ).num_params;
+  } );
+
+  const vector<unsigned int> cpus = available_cpus();
+  if ( num_threads == 0 ) {
+    num_threads = cpus.size();
+  }
+  num_threads = min<size_t>( num_threads, trials.size() );
+
+  cerr << "Running " << trials.size() << " trials on " << num_threads << " threads.\n";
+
+  MedianPruner pruner( options.prune_factor, options.min_trials );
+  vector<TrialResult> results( trials.size() );
+  atomic<size_t> next_trial { 0 };
+  mutex log_mutex;
+
+  const uint64_t sweep_start = Timer::timestamp_ns();
+  run_pinned_workers( num_threads, cpus, [&]( const unsigned int w ) {
+    for ( size_t n = next_trial++; n < trials.size(); n = next_trial++ ) {
+      const Trial& trial = trials[order[n]];
+      TrialResult& result = results[order[n]];
+
+      const uint64_t start = Timer::timestamp_ns();
+      try {
+        result = find_architecture( trial.arch ).run( trial, options, pruner );
+      } catch ( const exception& e ) {
+        result.status = string( "failed: " ) + e.what();
+      }
+      result.seconds = ( Timer::timestamp_ns() - start ) / BILLION;
+      result.cpu = cpus[w % cpus.size()];
+
+      lock_guard<mutex> lock( log_mutex );
+      cerr << "trial " << trial.id << " (" << trial.arch << ", eta=" << trial.eta << ", noise=" << trial.noise
+           << ", offset=" << trial.offset << ", seed=" << trial.seed << "): " << result.status << " after "
+           << result.iterations << " iterations, avg diff " << result.final_avg_diff << "\n";
+    }
+  } );
+
+  cerr << "Sweep finished in ";
+  Timer::pp_ns( cerr, Timer::timestamp_ns() - sweep_start );
+  cerr << ".\n";
+
+  if ( out_filename.empty() ) {
+    write_results( cout, trials, results );
+  } else {
+    write_results( out_file, trials, results );
+    out_file.flush();
+    if ( not out_file ) {
+      throw runtime_error( "could not write " + out_filename );
+    }
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+    program_body( argc, argv );
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
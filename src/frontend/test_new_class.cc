@@ -1,8 +1,8 @@
+#include "eigen.hh"
 #include "exception.hh"
 #include "neuralnetwork.hh"
 #include "timer.hh"
 
-#include <Eigen/Dense>
 #include <iostream>
 #include <memory>
 #include <random>
@@ -0,0 +1,209 @@
+/**
+ * File name: activation.hh
+ * Last Update: October 2026
+ * Description: Activation policies, chosen per layer at compile time (the
+ *              last template parameter of Layer, or of FullyConnected in a
+ *              SequentialNetwork).
+ *
+ *              Each policy has
+ *                forward( z ):        f(z), elementwise
+ *                derivative( z, a ):  f'(z), given z and a = f(z) (whichever
+ *                                     is cheaper to differentiate from)
+ *              Both return Eigen array expressions, so a layer's activation
+ *              and its delta computation (deltas = next_deltas * f'(z)) each
+ *              compile into one vectorized loop, with no branch on the kind
+ *              of activation.
+ *
+ *              The Fast policies and Softplus trade a documented error for
+ *              speed, using the approximations in fast_math.hh.
+ */
+
+#pragma once
+
+#include "eigen.hh"
+#include "fast_math.hh"
+
+#include <type_traits>
+
+namespace activation {
+
+/* max( z, 0 ) */
+struct ReLU
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return z.cwiseMax( typename Z::Scalar( 0 ) );
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>& z, const Eigen::ArrayBase<A>& )
+  {
+    using T = typename Z::Scalar;
+    return ( z > T( 0 ) ).select( Z::PlainObject::Ones( z.rows(), z.cols() ), T( 0 ) );
+  }
+};
+
+/* max( z, 0.01 z ) */
+struct LeakyReLU
+{
+  constexpr static double slope = 0.01;
+
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return z.cwiseMax( typename Z::Scalar( slope ) * z );
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>& z, const Eigen::ArrayBase<A>& )
+  {
+    using T = typename Z::Scalar;
+    return ( z > T( 0 ) ).select( Z::PlainObject::Ones( z.rows(), z.cols() ), T( slope ) );
+  }
+};
+
+/* z * Phi( z ), with Phi the standard normal CDF (exact, not the tanh approximation) */
+struct GELU
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    using T = typename Z::Scalar;
+    return T( 0.5 ) * z * ( T( 1 ) + ( z * T( M_SQRT1_2 ) ).erf() );
+  }
+
+  /* Phi( z ) + z * phi( z ) */
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>& z, const Eigen::ArrayBase<A>& )
+  {
+    using T = typename Z::Scalar;
+    return T( 0.5 ) * ( T( 1 ) + ( z * T( M_SQRT1_2 ) ).erf() )
+           + z * ( T( -0.5 ) * z.square() ).exp() * T( 0.5 * M_2_SQRTPI * M_SQRT1_2 );
+  }
+};
+
+struct Tanh
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return z.tanh();
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>&, const Eigen::ArrayBase<A>& a )
+  {
+    return typename A::Scalar( 1 ) - a.square();
+  }
+};
+
+/* 1 / ( 1 + exp( -z ) ) */
+struct Sigmoid
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return z.logistic();
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>&, const Eigen::ArrayBase<A>& a )
+  {
+    return a * ( typename A::Scalar( 1 ) - a );
+  }
+};
+
+/* the tanh form of GELU, with fast_math's tanh (max error 1e-3 against z * Phi( z )) */
+struct FastGELU
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return fast_math::gelu( z );
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>& z, const Eigen::ArrayBase<A>& )
+  {
+    return fast_math::gelu_derivative( z );
+  }
+};
+
+/* rational tanh (max error 1e-4) */
+struct FastTanh
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return fast_math::tanh( z );
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>&, const Eigen::ArrayBase<A>& a )
+  {
+    return typename A::Scalar( 1 ) - a.square();
+  }
+};
+
+/* sigmoid through the rational tanh (max error 5e-5) */
+struct FastSigmoid
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return fast_math::sigmoid( z );
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>&, const Eigen::ArrayBase<A>& a )
+  {
+    return a * ( typename A::Scalar( 1 ) - a );
+  }
+};
+
+/* log( 1 + exp( z ) ) */
+struct Softplus
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return fast_math::softplus( z );
+  }
+
+  /* sigmoid( z ) = 1 - exp( -a ), since exp( -a ) = 1 / ( 1 + exp( z ) ) */
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>&, const Eigen::ArrayBase<A>& a )
+  {
+    return typename A::Scalar( 1 ) - ( -a ).exp();
+  }
+};
+
+/* no activation (a network's last layer); layers skip the elementwise pass entirely */
+struct Identity
+{
+  template<class Z>
+  static auto forward( const Eigen::ArrayBase<Z>& z )
+  {
+    return z.derived();
+  }
+
+  template<class Z, class A>
+  static auto derivative( const Eigen::ArrayBase<Z>& z, const Eigen::ArrayBase<A>& )
+  {
+    return Z::PlainObject::Ones( z.rows(), z.cols() );
+  }
+};
+
+template<class Activation>
+constexpr bool is_identity = std::is_same_v<Activation, Identity>;
+
+/* not a policy: as the Hidden activation of a network's apply<Hidden>, each layer keeps its own */
+struct Own
+{};
+
+/* Hidden, or the layer's own Activation if Hidden is Own */
+template<class Hidden, class Activation>
+using hidden_or_own = std::conditional_t<std::is_same_v<Hidden, Own>, Activation, Hidden>;
+
+}
@@ -0,0 +1,185 @@
+/**
+ * File name: composed_network.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "network.hh"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+/* the scalar type, batch size and layer sizes of a Network (or SequentialNetwork) type */
+template<class NetworkT>
+struct network_traits;
+
+template<class T, unsigned int batch, class L0, class... rest>
+struct network_traits<SequentialNetwork<T, batch, L0, rest...>>
+{
+  using scalar = T;
+  constexpr static unsigned int batch_size = batch;
+  constexpr static std::array<unsigned int, 2 + sizeof...( rest )> layer_sizes {
+    L0::input, L0::output, rest::output... };
+  constexpr static unsigned int input_size = layer_sizes.front();
+  constexpr static unsigned int output_size = layer_sizes.back();
+};
+
+/*
+ * Class Name: ComposedNetwork
+ * Description: Two networks chained in memory: the output of NetA is the
+ *              input of NetB. Both keep their own activations (NetA's last
+ *              layer stays unactivated, as in a standalone Network), and the
+ *              whole chain trains end to end: computeDeltas seeds NetA with
+ *              the inputDeltas() of NetB.
+ *              It has the Network interface used by NeuralNetwork-style
+ *              training loops and by GradientChecker, with layers numbered
+ *              from NetA's first to NetB's last (see LayerSequence).
+ *              exportFolded writes an equivalent network of type Folded, in
+ *              which NetA's last (affine) layer and NetB's first layer are
+ *              multiplied out into a single layer.
+ */
+template<class NetA, class NetB>
+class ComposedNetwork : public LayerSequence<ComposedNetwork<NetA, NetB>, typename network_traits<NetA>::scalar>
+{
+  using A = network_traits<NetA>;
+  using B = network_traits<NetB>;
+
+  static_assert( std::is_same_v<typename A::scalar, typename B::scalar>, "networks must share a scalar type" );
+  static_assert( A::batch_size == B::batch_size, "networks must share a batch size" );
+  static_assert( A::output_size == B::input_size, "NetA's output must be NetB's input" );
+
+  using T = typename A::scalar;
+  constexpr static unsigned int batch_size = A::batch_size;
+
+  /* NetA's sizes without its output, then NetB's sizes without its input */
+  constexpr static size_t num_folded_sizes = A::layer_sizes.size() - 1 + B::layer_sizes.size() - 1;
+
+  constexpr static std::array<unsigned int, num_folded_sizes> folded_sizes()
+  {
+    std::array<unsigned int, num_folded_sizes> ret {};
+    size_t k = 0;
+    for ( size_t i = 0; i + 1 < A::layer_sizes.size(); i++ ) {
+      ret[k++] = A::layer_sizes[i];
+    }
+    for ( size_t i = 1; i < B::layer_sizes.size(); i++ ) {
+      ret[k++] = B::layer_sizes[i];
+    }
+    return ret;
+  }
+
+  constexpr static std::array<unsigned int, num_folded_sizes> folded_sizes_ = folded_sizes();
+
+  template<size_t... I>
+  static Network<T, batch_size, folded_sizes_[I]...> make_folded( std::index_sequence<I...> );
+
+public:
+  using Folded = decltype( make_folded( std::make_index_sequence<num_folded_sizes>() ) );
+
+  constexpr static unsigned int input_size = A::input_size;
+  constexpr static unsigned int output_size = B::output_size;
+
+  /*
+   * multiply-adds per sample in NetA's last and NetB's first layer, and in the folded layer.
+   * Folding always saves a layer and a round trip through its output, but with a narrow join
+   * (e.g. the 1-wide seconds/beat between NN1 and NN2) the folded layer needs more multiply-adds.
+   */
+  constexpr static unsigned int join_macs
+    = A::layer_sizes[A::layer_sizes.size() - 2] * A::output_size + B::input_size * B::layer_sizes[1];
+  constexpr static unsigned int folded_join_macs
+    = A::layer_sizes[A::layer_sizes.size() - 2] * B::layer_sizes[1];
+
+  NetA a {};
+  NetB b {};
+
+  /* Hidden, if given, runs in place of the hidden activations of both networks (see SequentialNetwork::apply) */
+  template<class Hidden = activation::Own, class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    a.template apply<Hidden>( input );
+    b.template apply<Hidden>( a.output() );
+  }
+
+  template<class Hidden = activation::Own, class Input, class Out>
+  void apply_into( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
+  {
+    a.template apply<Hidden>( input );
+    b.template apply_into<Hidden>( a.output(), out );
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return b.output(); }
+
+  template<class Hidden = activation::Own>
+  void computeDeltas()
+  {
+    b.template computeDeltas<Hidden>();
+    a.template computeDeltas<Hidden>( b.inputDeltas() );
+  }
+
+  auto inputDeltas() const { return a.inputDeltas(); }
+
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& input )
+  {
+    a.evaluateGradients( input );
+    b.evaluateGradients( a.output() );
+  }
+
+  template<class Input>
+  void accumulateGradients( const MatrixBase<Input>& input )
+  {
+    a.accumulateGradients( input );
+    b.accumulateGradients( a.output() );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f )
+  {
+    a.forEachLayer( f );
+    b.forEachLayer( f );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f ) const
+  {
+    a.forEachLayer( f );
+    b.forEachLayer( f );
+  }
+
+  /*
+   * Function Name: exportFolded
+   * Description: This function copies the parameters into a Folded network,
+   *              which computes the same function with one layer fewer.
+   *              NetA's last layer computes y = x*Wa + ba without activation,
+   *              and NetB's first layer computes act(y*Wb + bb), so the two
+   *              fold into act(x*(Wa*Wb) + (ba*Wb + bb)).
+   * Parameters:
+   *			1. folded is the network to overwrite
+   */
+  void exportFolded( Folded& folded ) const
+  {
+    using DynamicMatrix = Matrix<T, Dynamic, Dynamic>;
+    std::vector<std::pair<DynamicMatrix, DynamicMatrix>> params;
+
+    a.forEachLayer( [&]( const auto& layer ) { params.emplace_back( layer.weights(), layer.biases() ); } );
+
+    unsigned int layer_num = 0;
+    b.forEachLayer( [&]( const auto& layer ) {
+      if ( layer_num++ == 0 ) {
+        auto& [weights, biases] = params.back();
+        biases = biases * layer.weights() + layer.biases();
+        weights = weights * layer.weights();
+      } else {
+        params.emplace_back( layer.weights(), layer.biases() );
+      }
+    } );
+
+    size_t k = 0;
+    folded.forEachLayer( [&]( auto& layer ) {
+      layer.weights() = params[k].first;
+      layer.biases() = params[k].second;
+      k++;
+    } );
+  }
+};
@@ -0,0 +1,352 @@
+/**
+ * File name: conv1d_layer.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "activation.hh"
+#include "eigen.hh"
+#include "gradient_sum.hh"
+#include "profile.hh"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <utility>
+
+using namespace std;
+using namespace Eigen;
+
+/*
+ * Class Name: Conv1DLayer
+ * Description: A 1-D convolution over a window of events, with one small
+ *              kernel shared by every position: output position t sees the
+ *              events t * stride + k * dilation, k < kernel_size. Features
+ *              that do not depend on where they appear in the window (e.g.
+ *              an interval between two onsets) are learned once instead of
+ *              once per position, so the layer has kernel_size * in_channels
+ *              * out_channels weights, however long the window.
+ *
+ *              Rows of the input and output matrices are time-major: event t
+ *              of the input occupies columns [ t * in_channels, ( t + 1 ) *
+ *              in_channels ), and output position t columns [ t *
+ *              out_channels, ( t + 1 ) * out_channels ), so the output feeds
+ *              a Layer directly.
+ *
+ *              Each output position is a product of the input columns it
+ *              sees with the kernel, read in place: with dilation 1 those
+ *              columns are contiguous and form one product, otherwise one
+ *              per kernel tap. No im2col matrix is built.
+ *
+ *              weights() is the ( kernel_size * in_channels ) x out_channels
+ *              kernel, tap by tap, and biases() is 1 x out_channels, so
+ *              parameters are numbered, perturbed and trained as in Layer.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the layer (usually float)
+ *			2. batch_size specifies the size of a batch
+ *			3. length specifies the number of events in the window
+ *			4. in_channels specifies the size of one event
+ *			5. out_channels specifies the number of kernels
+ *			6. kernel_size specifies the number of events each kernel sees
+ *			7. stride specifies the step between output positions
+ *			8. dilation specifies the step between the events a kernel sees
+ *			9. Activation specifies the activation policy (activation.hh)
+ */
+template<class T,
+         unsigned int batch_size,
+         unsigned int length,
+         unsigned int in_channels,
+         unsigned int out_channels,
+         unsigned int kernel_size,
+         unsigned int stride = 1,
+         unsigned int dilation = 1,
+         class Activation = activation::ReLU>
+class Conv1DLayer
+  : public GradientSum<
+      Conv1DLayer<T, batch_size, length, in_channels, out_channels, kernel_size, stride, dilation, Activation>,
+      T>
+{
+  friend class GradientSum<Conv1DLayer, T>;
+
+  constexpr static unsigned int span = dilation * ( kernel_size - 1 ) + 1;
+  static_assert( kernel_size >= 1 and stride >= 1 and dilation >= 1, "kernel, stride and dilation must be positive" );
+  static_assert( span <= length, "the kernel must fit in the window" );
+
+public:
+  constexpr static unsigned int input_size = length * in_channels;
+  constexpr static unsigned int output_length = ( length - span ) / stride + 1;
+  constexpr static unsigned int output_size = output_length * out_channels;
+
+private:
+  constexpr static unsigned int taps_size = kernel_size * in_channels;
+
+  alignas( 64 ) Matrix<T, batch_size, output_size> output_ {};
+  alignas( 64 ) Matrix<T, batch_size, output_size> unactivated_output_ {};
+  alignas( 64 ) Matrix<T, taps_size, out_channels> weights_ {};
+  alignas( 64 ) Matrix<T, 1, out_channels> biases_ {};
+
+  // the input of the last pass, kept for evaluateGradients and apply_shifted
+  alignas( 64 ) Matrix<T, batch_size, input_size> input_ {};
+
+  alignas( 64 ) Matrix<T, batch_size, output_size> deltas_ {};
+  alignas( 64 ) Matrix<T, taps_size, out_channels> grad_weights_ {};
+  alignas( 64 ) Matrix<T, 1, out_channels> grad_biases_ {};
+
+  LayerTimings timings_ {};
+
+  /* the input columns of tap k of output position t */
+  template<class Input>
+  static auto tap( const MatrixBase<Input>& input, const unsigned int t, const unsigned int k )
+  {
+    return input.template middleCols<in_channels>( ( t * stride + k * dilation ) * in_channels );
+  }
+
+  auto kernelTap( const unsigned int k ) const { return weights_.template middleRows<in_channels>( k * in_channels ); }
+
+  /* unactivated output position t = its input columns times the kernel, plus the biases */
+  template<class Input>
+  void convolve( const MatrixBase<Input>& input, const unsigned int t )
+  {
+    auto out = unactivated_output_.template middleCols<out_channels>( t * out_channels );
+    if constexpr ( dilation == 1 ) {
+      out.noalias() = input.template middleCols<taps_size>( t * stride * in_channels ) * weights_;
+    } else {
+      out.noalias() = tap( input, t, 0 ) * kernelTap( 0 );
+      for ( unsigned int k = 1; k < kernel_size; k++ ) {
+        out.noalias() += tap( input, t, k ) * kernelTap( k );
+      }
+    }
+    out.rowwise() += biases_;
+  }
+
+  void activate()
+  {
+    if constexpr ( activation::is_identity<Activation> ) {
+      output_ = unactivated_output_;
+    } else {
+      output_.array() = Activation::forward( unactivated_output_.array() );
+    }
+  }
+
+  // add the gradients of the last pass to grad_weights_ and grad_biases_
+  void addGradients()
+  {
+    for ( unsigned int t = 0; t < output_length; t++ ) {
+      const auto deltas = deltas_.template middleCols<out_channels>( t * out_channels );
+      if constexpr ( dilation == 1 ) {
+        const auto taps = input_.template middleCols<taps_size>( t * stride * in_channels );
+        grad_weights_.noalias() += taps.transpose() * deltas;
+      } else {
+        for ( unsigned int k = 0; k < kernel_size; k++ ) {
+          grad_weights_.template middleRows<in_channels>( k * in_channels ).noalias()
+            += tap( input_, t, k ).transpose() * deltas;
+        }
+      }
+      grad_biases_ += deltas.colwise().sum();
+    }
+  }
+
+  // add this pass's gradients to the sum (see GradientSum::accumulateGradients)
+  void addToGradients()
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
+    addGradients();
+  }
+
+  void clearGradients()
+  {
+    grad_weights_.setZero();
+    grad_biases_.setZero();
+  }
+
+public:
+  Conv1DLayer() {}
+
+  /* draw every parameter uniformly from +-1/sqrt(kernel_size * in_channels) */
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
+  {
+    uniform_real_distribution<T> dist( -1 / std::sqrt( T( taps_size ) ), 1 / std::sqrt( T( taps_size ) ) );
+    weights_ = decltype( weights_ )::NullaryExpr( [&] { return dist( rng ); } );
+    biases_ = decltype( biases_ )::NullaryExpr( [&] { return dist( rng ); } );
+  }
+
+  /*
+   * Function Name: apply
+   * Description: This function convolves the input window with the kernels
+   *              and activates the result. The Matrix output_ will be
+   *              updated.
+   * Parameters:
+   *			1. input is batch_size x ( length * in_channels ), time-major
+   */
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    LayerTimings::Scope timer { timings_.apply };
+    input_ = input;
+    for ( unsigned int t = 0; t < output_length; t++ ) {
+      convolve( input_, t );
+    }
+    activate();
+  }
+
+  /*
+   * Function Name: apply_shifted
+   * Description: Same as apply, for a window that is the last one applied
+   *              moved along by one event (the oldest event dropped, a new
+   *              one appended). Every output position but the last is an
+   *              output position of the last window, so only the last is
+   *              computed; the others move along.
+   * Parameters:
+   *			1. event is the new event, batch_size x in_channels
+   */
+  template<class Event>
+  void apply_shifted( const MatrixBase<Event>& event )
+  {
+    static_assert( stride == 1, "shifting by one event moves the output by one position only with stride 1" );
+    LayerTimings::Scope timer { timings_.apply };
+    constexpr unsigned int kept_input = input_size - in_channels;
+    constexpr unsigned int kept_output = output_size - out_channels;
+
+    // move along in place, front to back, so nothing is read after it is overwritten
+    for ( unsigned int c = 0; c < kept_input; c++ ) {
+      input_.col( c ) = input_.col( c + in_channels );
+    }
+    input_.template rightCols<in_channels>() = event;
+    for ( unsigned int c = 0; c < kept_output; c++ ) {
+      unactivated_output_.col( c ) = unactivated_output_.col( c + out_channels );
+      output_.col( c ) = output_.col( c + out_channels );
+    }
+
+    convolve( input_, output_length - 1 );
+    auto last = output_.template rightCols<out_channels>();
+    if constexpr ( activation::is_identity<Activation> ) {
+      last = unactivated_output_.template rightCols<out_channels>();
+    } else {
+      last.array() = Activation::forward( unactivated_output_.template rightCols<out_channels>().array() );
+    }
+  }
+
+  /*
+   * Function Name: computeDeltas
+   * Description: This function computes the deltas of the pre-activation
+   *              outputs in place, as Layer::setDeltasWith does with the
+   *              layer's own activation.
+   * Parameters:
+   *			1. outputDeltas is the derivative of the loss w.r.t. the output
+   *			   (e.g. the inputDeltas() of the layer this one feeds)
+   */
+  template<class OutputDeltas>
+  void computeDeltas( const MatrixBase<OutputDeltas>& outputDeltas )
+  {
+    LayerTimings::Scope timer { timings_.computeDeltas };
+    deltas_.noalias() = outputDeltas;
+    if constexpr ( not activation::is_identity<Activation> ) {
+      deltas_.array() *= Activation::derivative( unactivated_output_.array(), output_.array() );
+    }
+  }
+
+  /* the derivative of the loss w.r.t. the input, after computeDeltas (computed only when asked for) */
+  Matrix<T, batch_size, input_size> inputDeltas() const
+  {
+    Matrix<T, batch_size, input_size> ret = Matrix<T, batch_size, input_size>::Zero();
+    for ( unsigned int t = 0; t < output_length; t++ ) {
+      const auto deltas = deltas_.template middleCols<out_channels>( t * out_channels );
+      for ( unsigned int k = 0; k < kernel_size; k++ ) {
+        ret.template middleCols<in_channels>( ( t * stride + k * dilation ) * in_channels ).noalias()
+          += deltas * kernelTap( k ).transpose();
+      }
+    }
+    return ret;
+  }
+
+  /* the gradients of the last pass, overwriting any accumulated ones (as Layer::evaluateGradients) */
+  void evaluateGradients()
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
+    grad_weights_.setZero();
+    grad_biases_.setZero();
+    addGradients();
+    this->startSum();
+  }
+
+  // accumulateGradients, zeroGradients, applyAccumulated and accumulatedBatches come from GradientSum
+
+  void modifyParamWholeLayer( T epsilon )
+  {
+    LayerTimings::Scope timer { timings_.update };
+    weights_ -= grad_weights_ * epsilon;
+    biases_ -= grad_biases_ * epsilon;
+    this->endSum();
+  }
+
+  void perturbWeight( const unsigned int weight_num, const T epsilon )
+  {
+    const unsigned int i = weight_num / out_channels;
+    const unsigned int j = weight_num % out_channels;
+    if ( i < taps_size ) {
+      weights_( i, j ) += epsilon;
+    } else {
+      biases_( 0, j ) += epsilon;
+    }
+  }
+
+  T getEvaluatedGradient( const unsigned int paramNum ) const
+  {
+    const unsigned int i = paramNum / out_channels;
+    const unsigned int j = paramNum % out_channels;
+    return i < taps_size ? grad_weights_( i, j ) : grad_biases_( 0, j );
+  }
+
+  unsigned int getNumParams() const { return ( taps_size + 1 ) * out_channels; }
+  unsigned int getInputSize() const { return input_size; }
+  unsigned int getOutputSize() const { return output_size; }
+
+  void print( const unsigned int layer_num ) const
+  {
+    const IOFormat CleanFmt( 4, 0, ", ", "\n", "[", "]" );
+
+    cout << "Conv1D layer " << layer_num << endl;
+    cout << "length: " << length << " x " << in_channels << " channels -> " << output_length << " x " << out_channels
+         << " channels (kernel " << kernel_size << ", stride " << stride << ", dilation " << dilation << ")" << endl
+         << endl;
+
+    cout << "weights:" << endl << weights_.format( CleanFmt ) << endl << endl;
+    cout << "biases:" << endl << biases_.format( CleanFmt ) << endl << endl;
+    cout << "output:" << endl << output_.format( CleanFmt ) << endl << endl << endl;
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return output_; }
+  const Matrix<T, batch_size, output_size>& deltas() const { return deltas_; }
+  const Matrix<T, taps_size, out_channels>& weights() const { return weights_; }
+  const Matrix<T, 1, out_channels>& biases() const { return biases_; }
+  const Matrix<T, taps_size, out_channels>& grad_weights() const { return grad_weights_; }
+  const Matrix<T, 1, out_channels>& grad_biases() const { return grad_biases_; }
+
+  Matrix<T, taps_size, out_channels>& weights() { return weights_; }
+  Matrix<T, 1, out_channels>& biases() { return biases_; }
+
+  const LayerTimings& timings() const { return timings_; }
+  LayerTimings& timings() { return timings_; }
+};
+
+/*
+ * Class Name: Conv1D
+ * Description: The description of a Conv1DLayer for ConvolutionalNetwork:
+ *              its window, channels, kernel, stride, dilation and activation.
+ */
+template<unsigned int length,
+         unsigned int in_channels,
+         unsigned int out_channels,
+         unsigned int kernel_size,
+         unsigned int stride = 1,
+         unsigned int dilation = 1,
+         class Activation = activation::ReLU>
+struct Conv1D
+{
+  template<class T, unsigned int batch_size>
+  using layer_type
+    = Conv1DLayer<T, batch_size, length, in_channels, out_channels, kernel_size, stride, dilation, Activation>;
+};
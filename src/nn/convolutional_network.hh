@@ -0,0 +1,158 @@
+/**
+ * File name: convolutional_network.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "conv1d_layer.hh"
+#include "network.hh"
+
+/*
+ * Class Name: ConvolutionalNetwork
+ * Description: A Conv1DLayer over a window of events followed by a Network
+ *              read-out of its output (ReLU hidden layers, unactivated last
+ *              layer, as in Network). It is used like a Network over the
+ *              same window: apply, computeDeltas and evaluateGradients
+ *              behave the same, so training loops and GradientChecker work
+ *              unchanged.
+ *
+ *              With stride 1, apply_shifted( event ) moves the last window
+ *              along by one event and only convolves the new output
+ *              position, for sliding windows fed one event at a time.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the network (usually float)
+ *			2. batch_size specifies the size of a batch
+ *			3. Conv specifies the convolution (a Conv1D<...>)
+ *			4. head... specifies the output sizes of the read-out layers
+ *
+ * Example: ConvolutionalNetwork<float, 1, Conv1D<16, 1, 8, 4>, 16, 1> reads
+ *          the same 16-onset window as Network<float, 1, 16, ...>, with 40
+ *          first-layer parameters instead of 17 per first-layer neuron.
+ */
+template<class T, unsigned int batch_size, class Conv, unsigned int... head>
+class ConvolutionalNetwork
+{
+public:
+  typename Conv::template layer_type<T, batch_size> conv {};
+  Network<T, batch_size, decltype( conv )::output_size, head...> next {};
+
+  constexpr static unsigned int input_size = decltype( conv )::input_size;
+  constexpr static unsigned int output_size = decltype( next )::output_size;
+
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
+  {
+    conv.initializeWeightsRandomly( rng );
+    next.initializeWeightsRandomly( rng );
+  }
+
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    conv.apply( input );
+    next.apply( conv.output() );
+  }
+
+  /* apply to the last window moved along by one event (stride 1 only; see Conv1DLayer::apply_shifted) */
+  template<class Event>
+  void apply_shifted( const MatrixBase<Event>& event )
+  {
+    conv.apply_shifted( event );
+    next.apply( conv.output() );
+  }
+
+  /* apply and copy the output into out (as Network::apply_into) */
+  template<class Input, class Out>
+  void apply_into( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
+  {
+    conv.apply( input );
+    next.apply_into( conv.output(), out );
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return next.output(); }
+
+  /* backprop with the derivative of the loss w.r.t. each output being 1 / batch_size */
+  void computeDeltas() { computeDeltas( Matrix<T, batch_size, output_size>::Ones() / batch_size ); }
+
+  template<class Seed>
+  void computeDeltas( const MatrixBase<Seed>& seed )
+  {
+    next.computeDeltas( seed );
+    conv.computeDeltas( next.inputDeltas() );
+  }
+
+  /* the derivative of the loss w.r.t. the input window (computed only when asked for) */
+  Matrix<T, batch_size, input_size> inputDeltas() const { return conv.inputDeltas(); }
+
+  /* the convolution keeps the window it was applied to, so the input is not read again */
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& )
+  {
+    conv.evaluateGradients();
+    next.evaluateGradients( conv.output() );
+  }
+
+  /* as in Network: add to the gradients summed since the last applyAccumulated */
+  template<class Input>
+  void accumulateGradients( const MatrixBase<Input>& )
+  {
+    conv.accumulateGradients();
+    next.accumulateGradients( conv.output() );
+  }
+
+  void zeroGradients()
+  {
+    conv.zeroGradients();
+    next.zeroGradients();
+  }
+
+  void applyAccumulated( T epsilon )
+  {
+    conv.applyAccumulated( epsilon );
+    next.applyAccumulated( epsilon );
+  }
+
+  void print( const unsigned int layerNum = 0 ) const
+  {
+    conv.print( layerNum );
+    next.print( layerNum + 1 );
+  }
+
+  unsigned int getNumLayers() const { return next.getNumLayers() + 1; }
+
+  unsigned int getNumParams( const unsigned int layerNum ) const
+  {
+    return layerNum > 0 ? next.getNumParams( layerNum - 1 ) : conv.getNumParams();
+  }
+
+  T getEvaluatedGradient( const unsigned int layerNum, const unsigned int paramNum )
+  {
+    return layerNum > 0 ? next.getEvaluatedGradient( layerNum - 1, paramNum ) : conv.getEvaluatedGradient( paramNum );
+  }
+
+  void modifyParamWholeLayer( const unsigned int layerNum, T epsilon )
+  {
+    if ( layerNum > 0 ) {
+      next.modifyParamWholeLayer( layerNum - 1, epsilon );
+    } else {
+      conv.modifyParamWholeLayer( epsilon );
+    }
+  }
+
+  /* f is called on the Conv1DLayer, then on every Layer of the read-out */
+  template<class F>
+  void forEachLayer( F&& f )
+  {
+    f( conv );
+    next.forEachLayer( f );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f ) const
+  {
+    f( conv );
+    next.forEachLayer( f );
+  }
+};
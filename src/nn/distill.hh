@@ -0,0 +1,288 @@
+/**
+ * File name: distill.hh
+ * Last Update: October 2026
+ * Description: The data side of distill_tempo: generating the windows,
+ *              splitting off the validation windows, scaling inputs and
+ *              targets (and folding the scaling into a trained student), the
+ *              evaluation of a model, and the cache of the teacher's outputs.
+ */
+
+#pragma once
+
+#include "eigen.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+#include "mmap.hh"
+#include "tempo_training.hh"
+#include "timer.hh"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace distill {
+
+constexpr unsigned int input_size = tempo_window_size;
+// one training window in validation_stride is held out for validation
+constexpr unsigned int validation_stride = 10;
+// noisy windows per tempo in the test set
+constexpr unsigned int test_windows_per_tempo = 4;
+constexpr unsigned int test_seed = 12345;
+
+using Windows = Eigen::Matrix<float, Eigen::Dynamic, input_size, Eigen::RowMajor>;
+using Params = std::vector<std::pair<Eigen::MatrixXf, Eigen::MatrixXf>>; // weights and biases of each layer
+
+struct DistillOptions
+{
+  unsigned int samples = 200000;
+  unsigned int epochs = 40;
+  float alpha = 1;
+  bool noise = true;
+  bool offset = false;
+  unsigned int data_seed = 0;
+};
+
+/* windows with their true tempo and the teacher's output */
+struct Samples
+{
+  Windows inputs {};
+  Eigen::VectorXf truth {};
+  Eigen::VectorXf teacher {};
+};
+
+/* scaling of inputs and targets to zero mean and unit variance */
+struct Normalization
+{
+  Eigen::Matrix<float, 1, input_size> input_mean {};
+  Eigen::Matrix<float, 1, input_size> input_std {};
+  float target_mean {};
+  float target_std {};
+};
+
+/* options.samples windows, with tempos drawn by draw_tempo */
+inline void generate_samples( Samples& samples, const DistillOptions& options )
+{
+  std::mt19937 rng( options.data_seed );
+  samples.inputs.resize( options.samples, input_size );
+  samples.truth.resize( options.samples );
+  for ( unsigned int i = 0; i < options.samples; i++ ) {
+    const float tempo = draw_tempo( rng );
+    samples.inputs.row( i ) = gen_time( tempo, options.offset, options.noise, rng );
+    samples.truth( i ) = tempo;
+  }
+}
+
+/* the test set: test_windows_per_tempo windows for each tempo 30..240 bpm (teacher outputs not filled in) */
+inline Samples make_test_set( const DistillOptions& options )
+{
+  std::mt19937 rng( test_seed );
+  Samples test;
+  const unsigned int num_windows = ( 241 - 30 ) * test_windows_per_tempo;
+  test.inputs.resize( num_windows, input_size );
+  test.truth.resize( num_windows );
+  unsigned int i = 0;
+  for ( int tempo = 30; tempo < 241; tempo++ ) {
+    for ( unsigned int n = 0; n < test_windows_per_tempo; n++, i++ ) {
+      test.inputs.row( i ) = gen_time( tempo, options.offset, options.noise, rng );
+      test.truth( i ) = tempo;
+    }
+  }
+  return test;
+}
+
+/*
+ * Function Name: split_validation
+ * Description: This function splits the labelled windows into the ones the
+ *              students train on and the held-out ones that pick the
+ *              learning rate, the best epoch and the best student. Every
+ *              validation_stride-th window is held out (the windows are
+ *              drawn independently, so this is a random split that does not
+ *              depend on the number of windows).
+ */
+inline std::pair<Samples, Samples> split_validation( const Samples& samples )
+{
+  const Eigen::Index n = samples.inputs.rows();
+  const Eigen::Index num_validation = ( n + validation_stride - 1 ) / validation_stride;
+
+  Samples train, validation;
+  for ( auto* part : { &train, &validation } ) {
+    const Eigen::Index rows = part == &validation ? num_validation : n - num_validation;
+    part->inputs.resize( rows, input_size );
+    part->truth.resize( rows );
+    part->teacher.resize( rows );
+  }
+
+  Eigen::Index t = 0, v = 0;
+  for ( Eigen::Index i = 0; i < n; i++ ) {
+    Samples& part = i % validation_stride == 0 ? validation : train;
+    const Eigen::Index row = i % validation_stride == 0 ? v++ : t++;
+    part.inputs.row( row ) = samples.inputs.row( i );
+    part.truth( row ) = samples.truth( i );
+    part.teacher( row ) = samples.teacher( i );
+  }
+  return { std::move( train ), std::move( validation ) };
+}
+
+template<class NetworkT>
+Params get_params( const NetworkT& nn )
+{
+  Params params;
+  nn.forEachLayer( [&]( const auto& layer ) { params.emplace_back( layer.weights(), layer.biases() ); } );
+  return params;
+}
+
+template<class NetworkT>
+void set_params( NetworkT& nn, const Params& params )
+{
+  for ( unsigned int i = 0; i < params.size(); i++ ) {
+    nn.initializeWeights( i, params[i].first );
+    nn.initializeBiases( i, params[i].second );
+  }
+}
+
+/* the scaling of the training windows, and of the targets mixed as alpha * teacher + ( 1 - alpha ) * truth */
+inline Normalization compute_normalization( const Samples& samples, const float alpha )
+{
+  Normalization norm;
+  const float n = samples.inputs.rows();
+  norm.input_mean = samples.inputs.colwise().mean();
+  norm.input_std
+    = ( ( samples.inputs.rowwise() - norm.input_mean ).array().square().colwise().sum() / n ).sqrt().matrix();
+  /* a constant input (the first timestamp without an offset) is left unscaled */
+  norm.input_std = norm.input_std.unaryExpr( []( const float s ) { return s > 1e-6f ? s : 1.0f; } );
+
+  const Eigen::VectorXf targets = alpha * samples.teacher + ( 1 - alpha ) * samples.truth;
+  norm.target_mean = targets.mean();
+  norm.target_std = std::sqrt( ( targets.array() - norm.target_mean ).square().mean() );
+  return norm;
+}
+
+/* the parameters of a network that reads raw timestamps and outputs bpm, from one trained on scaled data */
+inline Params fold_normalization( Params params, const Normalization& norm )
+{
+  /* ( ( x - m ) / s ) W + b = x ( W / s ) + ( b - ( m / s ) W ) */
+  auto& [first_weights, first_biases] = params.front();
+  const Eigen::RowVectorXf shift = norm.input_mean.cwiseQuotient( norm.input_std );
+  first_biases -= shift * first_weights;
+  first_weights = norm.input_std.cwiseInverse().asDiagonal() * first_weights;
+
+  auto& [last_weights, last_biases] = params.back();
+  last_weights *= norm.target_std;
+  last_biases = ( last_biases.array() * norm.target_std + norm.target_mean ).matrix();
+  return params;
+}
+
+/* average absolute errors of nn (batch size 1) against the true tempo and the teacher, and its latency */
+template<class NetworkT>
+void evaluate( NetworkT& nn, const Samples& set, float& truth_diff, float& teacher_diff, uint64_t& latency_ns )
+{
+  truth_diff = teacher_diff = 0;
+  const uint64_t start = Timer::timestamp_ns();
+  for ( Eigen::Index i = 0; i < set.inputs.rows(); i++ ) {
+    nn.apply_leaky( set.inputs.row( i ) );
+    truth_diff += std::abs( nn.output()( 0, 0 ) - set.truth( i ) );
+    teacher_diff += std::abs( nn.output()( 0, 0 ) - set.teacher( i ) );
+  }
+  latency_ns = ( Timer::timestamp_ns() - start ) / set.inputs.rows();
+  truth_diff /= set.inputs.rows();
+  teacher_diff /= set.inputs.rows();
+}
+
+/*
+ * The cache file: a header naming the teacher (with a hash of its weight
+ * file) and the data, then the windows, the true tempos and the teacher's
+ * outputs as floats (native byte order).
+ */
+struct CacheHeader
+{
+  std::array<char, 8> magic;
+  std::array<char, 32> teacher;
+  uint64_t weights_bytes;
+  uint64_t weights_hash;
+  uint64_t num_samples;
+  uint32_t data_seed;
+  uint8_t noise;
+  uint8_t offset;
+  uint16_t padding;
+};
+
+constexpr std::array<char, 8> cache_magic { 'N', 'N', 'F', 'D', 'I', 'S', 'T', '2' };
+
+/* 64-bit FNV-1a */
+inline uint64_t hash_bytes( const std::string_view bytes )
+{
+  uint64_t hash = 0xcbf29ce484222325;
+  for ( const char c : bytes ) {
+    hash = ( hash ^ static_cast<uint8_t>( c ) ) * 0x100000001b3;
+  }
+  return hash;
+}
+
+inline CacheHeader make_cache_header( const std::string& teacher,
+                                      const std::string& weights_file,
+                                      const DistillOptions& options )
+{
+  ReadOnlyFile weights { weights_file };
+
+  CacheHeader header {};
+  header.magic = cache_magic;
+  teacher.copy( header.teacher.data(), header.teacher.size() - 1 );
+  header.weights_bytes = weights.length();
+  header.weights_hash = hash_bytes( weights );
+  header.num_samples = options.samples;
+  header.data_seed = options.data_seed;
+  header.noise = options.noise;
+  header.offset = options.offset;
+  return header;
+}
+
+/* fill samples from the cache if it holds the same teacher and data */
+inline bool load_cache( const std::string& filename, const CacheHeader& header, Samples& samples )
+{
+  if ( access( filename.c_str(), R_OK ) != 0 ) {
+    return false;
+  }
+  ReadOnlyFile file { filename };
+  const std::string_view contents = file;
+  const size_t n = header.num_samples;
+  if ( contents.size() != sizeof( header ) + sizeof( float ) * n * ( input_size + 2 )
+       or memcmp( contents.data(), &header, sizeof( header ) ) ) {
+    return false;
+  }
+
+  const char* data = contents.data() + sizeof( header );
+  samples.inputs.resize( n, input_size );
+  samples.truth.resize( n );
+  samples.teacher.resize( n );
+  memcpy( samples.inputs.data(), data, sizeof( float ) * n * input_size );
+  memcpy( samples.truth.data(), data + sizeof( float ) * n * input_size, sizeof( float ) * n );
+  memcpy( samples.teacher.data(), data + sizeof( float ) * n * ( input_size + 1 ), sizeof( float ) * n );
+  return true;
+}
+
+inline void write_cache( const std::string& filename, const CacheHeader& header, const Samples& samples )
+{
+  FileDescriptor fd { CheckSystemCall( "open( \"" + filename + "\" )",
+                                       open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) ) };
+  const auto bytes = []( const auto* data, const size_t count ) {
+    return std::string_view( reinterpret_cast<const char*>( data ), sizeof( *data ) * count );
+  };
+  const size_t n = samples.truth.size();
+  for ( std::string_view buffer : { bytes( &header, 1 ),
+                                    bytes( samples.inputs.data(), n * input_size ),
+                                    bytes( samples.truth.data(), n ),
+                                    bytes( samples.teacher.data(), n ) } ) {
+    while ( not buffer.empty() ) {
+      buffer.remove_prefix( fd.write( buffer ) );
+    }
+  }
+}
+
+}
@@ -0,0 +1,330 @@
+/**
+ * File name: gradient_check.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "affinity.hh"
+#include "network.hh"
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/* settings for GradientChecker; the defaults match src/tests/formulagradienttest2.cc */
+struct GradientCheckOptions
+{
+  // step for the central finite differences
+  double epsilon = 1e-5;
+  // a check fails only when it exceeds both the absolute and the relative tolerance
+  double abs_tolerance = 1e-5;
+  double rel_tolerance = 1e-3;
+  // parameters checked per layer, drawn at random (0 = every parameter)
+  unsigned int samples_per_layer = 0;
+  // random directions along which the whole gradient is checked at once
+  unsigned int directions = 0;
+  // worker threads, each with its own copy of the network (0 = one per available CPU, within copy_budget)
+  unsigned int threads = 0;
+  // most memory (bytes) the default number of threads may take for their copies of the network
+  size_t copy_budget = size_t( 1 ) << 30;
+  uint64_t seed = 0;
+  // print every failing check
+  bool verbose = true;
+};
+
+struct GradientCheckResult
+{
+  uint64_t params_checked {};
+  uint64_t directions_checked {};
+  uint64_t failures {};
+  uint64_t forward_passes {};
+  double max_abs_diff {};
+  double max_rel_error {};
+  double max_direction_rel_error {};
+
+  bool passed() const { return failures == 0; }
+
+  void merge( const GradientCheckResult& other )
+  {
+    params_checked += other.params_checked;
+    directions_checked += other.directions_checked;
+    failures += other.failures;
+    forward_passes += other.forward_passes;
+    max_abs_diff = std::max( max_abs_diff, other.max_abs_diff );
+    max_rel_error = std::max( max_rel_error, other.max_rel_error );
+    max_direction_rel_error = std::max( max_direction_rel_error, other.max_direction_rel_error );
+  }
+
+  void summary( std::ostream& out ) const
+  {
+    out << std::defaultfloat << std::setprecision( 6 );
+    out << "Checked " << params_checked << " parameters and " << directions_checked << " directions with "
+        << forward_passes << " forward passes: " << failures << " failures\n";
+    out << "maxDiff: " << max_abs_diff << "\nmaxPercentageError: " << max_rel_error
+        << "\nmaxDirectionPercentageError: " << max_direction_rel_error << "\n";
+  }
+};
+
+/*
+ * Class Name: GradientChecker
+ * Description: Compares the gradients computed by backpropagation
+ *              (evaluateGradients) with central finite differences of the
+ *              summed network output, like Network::calculateNumericalGradient.
+ *              Two kinds of check are spread over worker threads, each of which
+ *              perturbs its own copy of the network:
+ *              1. per parameter, for every parameter or for a random sample
+ *                 of each layer (two forward passes per parameter);
+ *              2. per random unit direction v, comparing the directional
+ *                 derivative (f(p + eps*v) - f(p - eps*v)) / 2eps with the dot
+ *                 product of the gradient and v. This covers every parameter
+ *                 with two forward passes per direction, so it stays cheap for
+ *                 wide layers. It needs double: in float, the step of each
+ *                 parameter (eps/sqrt(P)) is below the rounding of the
+ *                 weights, so GradientChecker throws if directions are asked
+ *                 for on a float network.
+ *              The network passed in is left with the activations and
+ *              gradients of `input`.
+ */
+template<class NetworkT, class InputT>
+class GradientChecker
+{
+  using T = typename InputT::Scalar;
+  using DynamicMatrix = Matrix<T, Dynamic, Dynamic>;
+
+  constexpr static unsigned int batch_size = InputT::RowsAtCompileTime;
+
+  NetworkT& network_;
+  const InputT& input_;
+  GradientCheckOptions options_;
+
+  std::mutex mutex_ {};
+  GradientCheckResult result_ {};
+
+  struct ParamCheck
+  {
+    unsigned int layer;
+    unsigned int param;
+    T formula_gradient;
+  };
+
+  static void perturbParam( NetworkT& network, const unsigned int layerNum, const unsigned int param, const T amount )
+  {
+    unsigned int i = 0;
+    network.forEachLayer( [&]( auto& layer ) {
+      if ( i++ == layerNum ) {
+        layer.perturbWeight( param, amount );
+      }
+    } );
+  }
+
+  /*
+   * a random unit vector with entries +-1/sqrt(P) over all P parameters, as a weights/biases matrix
+   * pair per layer. Keeping it unit length keeps each parameter's step far below epsilon on wide
+   * networks, so the finite difference does not cross ReLU kinks.
+   */
+  static std::vector<DynamicMatrix> randomDirection( NetworkT& network, const uint64_t seed, const unsigned int d )
+  {
+    std::seed_seq seq { seed, uint64_t( d ) };
+    std::mt19937_64 rng( seq );
+
+    std::vector<DynamicMatrix> direction;
+    const auto draw = [&]( const Index rows, const Index cols ) {
+      DynamicMatrix v( rows, cols );
+      for ( Index k = 0; k < v.size(); k++ ) {
+        v.data()[k] = ( rng() & 1 ) ? 1 : -1;
+      }
+      direction.push_back( std::move( v ) );
+    };
+
+    network.forEachLayer( [&]( const auto& layer ) {
+      draw( layer.weights().rows(), layer.weights().cols() );
+      draw( layer.biases().rows(), layer.biases().cols() );
+    } );
+
+    size_t num_params = 0;
+    for ( const auto& v : direction ) {
+      num_params += v.size();
+    }
+    for ( auto& v : direction ) {
+      v /= std::sqrt( T( num_params ) );
+    }
+    return direction;
+  }
+
+  static void addDirection( NetworkT& network, const std::vector<DynamicMatrix>& direction, const T scale )
+  {
+    size_t k = 0;
+    network.forEachLayer( [&]( auto& layer ) {
+      layer.weights() += scale * direction[k++];
+      layer.biases() += scale * direction[k++];
+    } );
+  }
+
+  T f( NetworkT& network ) const
+  {
+    network.apply( input_ );
+    return network.output().sum() / batch_size;
+  }
+
+  /* records one comparison; returns whether it failed */
+  bool compare( GradientCheckResult& result, const T formula, const T numerical, const bool direction ) const
+  {
+    const double diff = std::abs( formula - numerical );
+    const double rel = diff > 0 ? diff / std::max( std::abs( formula ), std::abs( numerical ) ) : 0;
+    const bool failed = diff > options_.abs_tolerance and rel > options_.rel_tolerance;
+
+    if ( direction ) {
+      result.directions_checked++;
+      result.max_direction_rel_error = std::max( result.max_direction_rel_error, rel );
+    } else {
+      result.params_checked++;
+      result.max_abs_diff = std::max( result.max_abs_diff, diff );
+      result.max_rel_error = std::max( result.max_rel_error, rel );
+    }
+    result.failures += failed;
+    result.forward_passes += 2;
+
+    return failed;
+  }
+
+  void worker( const std::vector<ParamCheck>& params, std::atomic<size_t>& next_item )
+  {
+    auto copy = std::make_unique<NetworkT>( network_ );
+    const T eps = options_.epsilon;
+    GradientCheckResult local {};
+
+    const size_t num_items = params.size() + options_.directions;
+    for ( size_t n = next_item++; n < num_items; n = next_item++ ) {
+      if ( n < params.size() ) {
+        const ParamCheck& check = params[n];
+
+        perturbParam( *copy, check.layer, check.param, eps );
+        const T f_plus = f( *copy );
+        perturbParam( *copy, check.layer, check.param, -2 * eps );
+        const T f_minus = f( *copy );
+        perturbParam( *copy, check.layer, check.param, eps );
+
+        const T numerical = ( f_plus - f_minus ) / ( 2 * eps );
+        if ( compare( local, check.formula_gradient, numerical, false ) and options_.verbose ) {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          std::cout << "Error in Layer " << check.layer << ", Param " << check.param << ": formula "
+                    << check.formula_gradient << ", numerical " << numerical << "\n";
+        }
+      } else {
+        const unsigned int d = n - params.size();
+        const std::vector<DynamicMatrix> direction = randomDirection( *copy, options_.seed, d );
+
+        /* the copy still holds the gradients evaluated on the original */
+        T formula = 0;
+        size_t k = 0;
+        copy->forEachLayer( [&]( const auto& layer ) {
+          formula += ( direction[k++].array() * layer.grad_weights().array() ).sum();
+          formula += ( direction[k++].array() * layer.grad_biases().array() ).sum();
+        } );
+
+        addDirection( *copy, direction, eps );
+        const T f_plus = f( *copy );
+        addDirection( *copy, direction, -2 * eps );
+        const T f_minus = f( *copy );
+        addDirection( *copy, direction, eps );
+
+        const T numerical = ( f_plus - f_minus ) / ( 2 * eps );
+        if ( compare( local, formula, numerical, true ) and options_.verbose ) {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          std::cout << "Error in direction " << d << ": formula " << formula << ", numerical " << numerical
+                    << "\n";
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock( mutex_ );
+    result_.merge( local );
+  }
+
+public:
+  GradientChecker( NetworkT& network, const InputT& input, const GradientCheckOptions& options = {} )
+    : network_( network )
+    , input_( input )
+    , options_( options )
+  {
+    if ( options_.directions > 0 and std::numeric_limits<T>::digits < std::numeric_limits<double>::digits ) {
+      throw std::runtime_error( "GradientChecker: directional checks need double parameters" );
+    }
+  }
+
+  GradientCheckResult run()
+  {
+    network_.apply( input_ );
+    network_.computeDeltas();
+    network_.evaluateGradients( input_ );
+
+    /* choose the parameters to perturb, and read their backprop gradients up front */
+    std::mt19937 rng( options_.seed );
+    std::vector<ParamCheck> params;
+    for ( unsigned int layer = 0; layer < network_.getNumLayers(); layer++ ) {
+      const unsigned int num_params = network_.getNumParams( layer );
+      const bool sampled = options_.samples_per_layer > 0 and options_.samples_per_layer < num_params;
+      std::uniform_int_distribution<unsigned int> param_dist( 0, num_params - 1 );
+
+      for ( unsigned int i = 0; i < ( sampled ? options_.samples_per_layer : num_params ); i++ ) {
+        const unsigned int param = sampled ? param_dist( rng ) : i;
+        params.push_back( { layer, param, network_.getEvaluatedGradient( layer, param ) } );
+      }
+    }
+
+    const std::vector<unsigned int> cpus = available_cpus();
+    const size_t num_items = params.size() + options_.directions;
+    const size_t copies_in_budget = std::max<size_t>( 1, options_.copy_budget / sizeof( NetworkT ) );
+    const size_t default_threads = std::min( cpus.size(), copies_in_budget );
+    const size_t num_threads = std::min<size_t>( options_.threads ? options_.threads : default_threads, num_items );
+
+    result_ = {};
+    result_.forward_passes = 1;
+
+    std::atomic<size_t> next_item { 0 };
+    std::vector<std::exception_ptr> errors( num_threads );
+    std::vector<std::thread> workers;
+    for ( size_t w = 0; w < num_threads; w++ ) {
+      workers.emplace_back( [&, w] {
+        try {
+          pin_this_thread( cpus[w % cpus.size()] );
+          ThreadPool::run_inline_on_this_thread();
+          worker( params, next_item );
+        } catch ( ... ) {
+          errors[w] = std::current_exception();
+        }
+      } );
+    }
+
+    for ( auto& thread : workers ) {
+      thread.join();
+    }
+
+    for ( const auto& error : errors ) {
+      if ( error ) {
+        std::rethrow_exception( error );
+      }
+    }
+
+    return result_;
+  }
+};
+
+/* convenience wrapper: GradientChecker( network, input, options ).run() */
+template<class NetworkT, class InputT>
+GradientCheckResult checkGradients( NetworkT& network, const InputT& input, const GradientCheckOptions& options = {} )
+{
+  return GradientChecker<NetworkT, InputT>( network, input, options ).run();
+}
@@ -0,0 +1,98 @@
+/**
+ * File name: gradient_sum.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include <cassert>
+
+/*
+ * Class Name: GradientSum
+ * Description: The gradient accumulation shared by Layer, GRULayer and
+ *              Conv1DLayer: it counts the micro-batches summed in a layer's
+ *              gradient buffers and provides accumulateGradients,
+ *              zeroGradients, applyAccumulated and accumulatedBatches on top
+ *              of the layer's own kernels.
+ *
+ *              A sum starts with evaluateGradients, which overwrites the
+ *              buffers and calls startSum, and ends when the gradients are
+ *              applied to the parameters (modifyParamWholeLayer or tryStep
+ *              call endSum). So a plain evaluateGradients and
+ *              modifyParamWholeLayer step leaves nothing for the next
+ *              accumulateGradients to add onto.
+ *
+ *              Derived provides, besides evaluateGradients( input... ) and
+ *              modifyParamWholeLayer( epsilon ):
+ *                addToGradients( input... ):  add one micro-batch's
+ *                                             gradients to the buffers
+ *                clearGradients():            set the buffers to zero
+ *
+ * Inputs:
+ *			1. Derived is the layer class (which befriends GradientSum)
+ *			2. T specifies the type of variables in the layer
+ */
+template<class Derived, class T>
+class GradientSum
+{
+  // number of micro-batches summed in the gradients
+  unsigned int batches_ = 0;
+
+  Derived& derived() { return static_cast<Derived&>( *this ); }
+
+protected:
+  /* the gradients now hold one micro-batch's, overwriting the buffers: the first of a new sum */
+  void startSum() { batches_ = 1; }
+
+  /* the gradients were applied to the parameters: the next micro-batch starts a new sum */
+  void endSum() { batches_ = 0; }
+
+public:
+  /*
+   * Function Name: accumulateGradients
+   * Description: Same as evaluateGradients, but adds this micro-batch's
+   *              gradients to the ones summed since the last step (or
+   *              zeroGradients), so K passes of batch_size act as one batch
+   *              of K * batch_size without a larger instantiation. The first
+   *              micro-batch of a sum overwrites the buffers, so they need no
+   *              zeroing between steps.
+   * Parameters:
+   *			1. input... is what the layer's evaluateGradients takes (the
+   *			   input of the last pass for Layer, nothing for layers that
+   *			   keep their own)
+   */
+  template<class... Input>
+  void accumulateGradients( const Input&... input )
+  {
+    if ( batches_ == 0 ) {
+      derived().evaluateGradients( input... );
+      return;
+    }
+    derived().addToGradients( input... );
+    batches_++;
+  }
+
+  /* discard the accumulated gradients */
+  void zeroGradients()
+  {
+    derived().clearGradients();
+    batches_ = 0;
+  }
+
+  /*
+   * Function Name: applyAccumulated
+   * Description: This function steps the parameters like
+   *              modifyParamWholeLayer by the mean of the accumulated
+   *              micro-batch gradients, and starts a new sum.
+   * Parameters:
+   *			1. epsilon is the constant to be multiplied to the mean gradient
+   */
+  void applyAccumulated( T epsilon )
+  {
+    assert( batches_ > 0 );
+    derived().modifyParamWholeLayer( epsilon / batches_ );
+  }
+
+  /* number of micro-batches in the accumulated gradients */
+  unsigned int accumulatedBatches() const { return batches_; }
+};
@@ -0,0 +1,323 @@
+/**
+ * File name: gru_layer.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "activation.hh"
+#include "eigen.hh"
+#include "gradient_sum.hh"
+#include "profile.hh"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+/*
+ * Class Name: GRULayer
+ * Description: A gated recurrent unit: a layer with a hidden state that is
+ *              updated once per event, so the state summarizes the whole
+ *              history at a constant cost per event.
+ *              For an event x and the previous state h:
+ *                z  = sigmoid( x Wz + h Uz + bz )          update gate
+ *                r  = sigmoid( x Wr + h Ur + br )          reset gate
+ *                c  = tanh( x Wc + ( r * h ) Uc + bc )     candidate state
+ *                h' = ( 1 - z ) * h + z * c
+ *              The parameters are kept like a Layer's, so the same training
+ *              and checking code applies: weights() is the
+ *              ( input_size + hidden_size ) x 3 hidden_size matrix
+ *              [ Wz Wr Wc ; Uz Ur Uc ] (the rows multiplying x, then those
+ *              multiplying h), and biases() is [ bz br bc ].
+ *
+ *              apply records each step, keeping the last bptt_steps of them,
+ *              and computeDeltas backpropagates through those (truncated
+ *              backpropagation through time: the state before the oldest
+ *              recorded step is treated as a constant). apply_streaming
+ *              updates the state without recording anything, for inference.
+ *              Memory is fixed by bptt_steps, however long the history.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the layer (usually float)
+ *			2. batch_size specifies the number of independent sequences
+ *			3. input_size specifies the size of one event
+ *			4. hidden_size specifies the size of the state (the output)
+ *			5. bptt_steps specifies how many steps are recorded for training
+ */
+template<class T, unsigned int batch_size, unsigned int input_size, unsigned int hidden_size, unsigned int bptt_steps>
+class GRULayer : public GradientSum<GRULayer<T, batch_size, input_size, hidden_size, bptt_steps>, T>
+{
+  friend class GradientSum<GRULayer, T>;
+
+  static_assert( bptt_steps >= 1, "at least one step must be recorded" );
+
+  constexpr static unsigned int gates_size = 3 * hidden_size;
+
+  using State = Matrix<T, batch_size, hidden_size>;
+
+  // one recorded step: its input and previous state, its gates, and (after computeDeltas) its deltas
+  struct Step
+  {
+    Matrix<T, batch_size, input_size> input {};
+    State previous {};
+    State update {};
+    State reset {};
+    State candidate {};
+    // derivatives of the loss w.r.t. the pre-activation [ z r c ]
+    Matrix<T, batch_size, gates_size> deltas {};
+  };
+
+  alignas( 64 ) Matrix<T, input_size + hidden_size, gates_size> weights_ {};
+  alignas( 64 ) Matrix<T, 1, gates_size> biases_ {};
+
+  alignas( 64 ) State state_ {};
+  // the last bptt_steps steps, in a ring: step n is steps_[n % bptt_steps]
+  std::array<Step, bptt_steps> steps_ {};
+  // number of steps recorded since resetState
+  unsigned int num_steps_ = 0;
+  // number of recorded steps computeDeltas reached
+  unsigned int num_deltas_ = 0;
+
+  alignas( 64 ) Matrix<T, input_size + hidden_size, gates_size> grad_weights_ {};
+  alignas( 64 ) Matrix<T, 1, gates_size> grad_biases_ {};
+
+  LayerTimings timings_ {};
+
+  auto inputWeights() const { return weights_.template topRows<input_size>(); }
+  auto recurrentWeights() const { return weights_.template bottomRows<hidden_size>(); }
+
+  /* one step from state_, writing the gates into step and the new state into state_ */
+  template<class Input>
+  void forward( const MatrixBase<Input>& input, Step& step )
+  {
+    LayerTimings::Scope timer { timings_.apply };
+    Matrix<T, batch_size, gates_size> pre;
+    pre.noalias() = input * inputWeights();
+    pre.rowwise() += biases_;
+    pre.template leftCols<2 * hidden_size>().noalias()
+      += state_ * recurrentWeights().template leftCols<2 * hidden_size>();
+
+    step.update.array() = activation::Sigmoid::forward( pre.template leftCols<hidden_size>().array() );
+    step.reset.array() = activation::Sigmoid::forward( pre.template middleCols<hidden_size>( hidden_size ).array() );
+    pre.template rightCols<hidden_size>().noalias()
+      += ( step.reset.array() * state_.array() ).matrix() * recurrentWeights().template rightCols<hidden_size>();
+    step.candidate.array() = activation::Tanh::forward( pre.template rightCols<hidden_size>().array() );
+
+    step.previous = state_;
+    state_.array() += step.update.array() * ( step.candidate.array() - state_.array() );
+  }
+
+  Step& recorded( const unsigned int n ) { return steps_[n % bptt_steps]; }
+  const Step& recorded( const unsigned int n ) const { return steps_[n % bptt_steps]; }
+
+  // add each step's inputs^T * deltas to grad_weights_
+  void addGradients()
+  {
+    for ( unsigned int k = 0; k < num_deltas_; k++ ) {
+      const Step& step = recorded( num_steps_ - 1 - k );
+      grad_weights_.template topRows<input_size>().noalias() += step.input.transpose() * step.deltas;
+      grad_weights_.template bottomRows<hidden_size>().template leftCols<2 * hidden_size>().noalias()
+        += step.previous.transpose() * step.deltas.template leftCols<2 * hidden_size>();
+      grad_weights_.template bottomRows<hidden_size>().template rightCols<hidden_size>().noalias()
+        += ( step.reset.array() * step.previous.array() ).matrix().transpose()
+           * step.deltas.template rightCols<hidden_size>();
+      grad_biases_ += step.deltas.colwise().sum();
+    }
+  }
+
+  // add this pass's gradients to the sum (see GradientSum::accumulateGradients)
+  void addToGradients()
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
+    addGradients();
+  }
+
+  void clearGradients()
+  {
+    grad_weights_.setZero();
+    grad_biases_.setZero();
+  }
+
+public:
+  GRULayer() {}
+
+  /*
+   * Function Name: initializeWeightsRandomly
+   * Description: This function draws every parameter uniformly from
+   *              +-1/sqrt(hidden_size), which keeps the gates away from
+   *              saturation at the start of training, and resets the state.
+   * Parameters:
+   *			1. rng is a standard uniform random bit generator
+   */
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
+  {
+    uniform_real_distribution<T> dist( -1 / std::sqrt( T( hidden_size ) ), 1 / std::sqrt( T( hidden_size ) ) );
+    weights_ = decltype( weights_ )::NullaryExpr( [&] { return dist( rng ); } );
+    biases_ = decltype( biases_ )::NullaryExpr( [&] { return dist( rng ); } );
+    resetState();
+  }
+
+  /* start new sequences: zero the state and forget the recorded steps */
+  void resetState()
+  {
+    state_.setZero();
+    num_steps_ = 0;
+    num_deltas_ = 0;
+  }
+
+  /*
+   * Function Name: apply
+   * Description: This function advances the state by one event, and
+   *              records the step for computeDeltas.
+   * Parameters:
+   *			1. input is the event: any batch_size x input_size Eigen
+   *			   expression
+   */
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    Step& step = recorded( num_steps_ );
+    step.input = input;
+    forward( input, step );
+    num_steps_++;
+  }
+
+  /* advance the state by one event without recording it (inference). The recorded steps no longer lead to the
+     state, so they are forgotten: training resumes from the next recorded step. */
+  template<class Input>
+  void apply_streaming( const MatrixBase<Input>& input )
+  {
+    Step step;
+    forward( input, step );
+    num_steps_ = 0;
+    num_deltas_ = 0;
+  }
+
+  /* the state, which is the layer's output */
+  const State& output() const { return state_; }
+
+  /*
+   * Function Name: computeDeltas
+   * Description: This function backpropagates the derivative of the loss
+   *              w.r.t. the current state through the recorded steps, newest
+   *              first, and keeps each step's deltas for evaluateGradients.
+   * Parameters:
+   *			1. seed is the derivative of the loss w.r.t. the current state
+   *			   (e.g. the inputDeltas() of the layer this one feeds)
+   */
+  template<class Seed>
+  void computeDeltas( const MatrixBase<Seed>& seed )
+  {
+    LayerTimings::Scope timer { timings_.computeDeltas };
+    num_deltas_ = std::min( num_steps_, bptt_steps );
+
+    // the derivative of the loss w.r.t. the state after the step being processed
+    State state_deltas = seed;
+    State reset_state_deltas;
+    for ( unsigned int k = 0; k < num_deltas_; k++ ) {
+      Step& step = recorded( num_steps_ - 1 - k );
+      auto update_deltas = step.deltas.template leftCols<hidden_size>();
+      auto reset_deltas = step.deltas.template middleCols<hidden_size>( hidden_size );
+      auto candidate_deltas = step.deltas.template rightCols<hidden_size>();
+
+      candidate_deltas.array() = state_deltas.array() * step.update.array()
+                                 * activation::Tanh::derivative( step.candidate.array(), step.candidate.array() );
+      update_deltas.array() = state_deltas.array() * ( step.candidate.array() - step.previous.array() )
+                              * activation::Sigmoid::derivative( step.update.array(), step.update.array() );
+
+      // the derivative w.r.t. r * h
+      reset_state_deltas.noalias()
+        = candidate_deltas * recurrentWeights().template rightCols<hidden_size>().transpose();
+      reset_deltas.array() = reset_state_deltas.array() * step.previous.array()
+                             * activation::Sigmoid::derivative( step.reset.array(), step.reset.array() );
+
+      state_deltas.array() = state_deltas.array() * ( T( 1 ) - step.update.array() )
+                             + reset_state_deltas.array() * step.reset.array();
+      state_deltas.noalias() += step.deltas.template leftCols<2 * hidden_size>()
+                                * recurrentWeights().template leftCols<2 * hidden_size>().transpose();
+    }
+  }
+
+  /*
+   * Function Name: evaluateGradients
+   * Description: This function sums the gradients w.r.t. the weights and
+   *              biases over the steps computeDeltas reached, overwriting any
+   *              accumulated gradients (as Layer::evaluateGradients).
+   */
+  void evaluateGradients()
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
+    grad_weights_.setZero();
+    grad_biases_.setZero();
+    addGradients();
+    this->startSum();
+  }
+
+  // accumulateGradients, zeroGradients, applyAccumulated and accumulatedBatches come from GradientSum
+
+  /* decrement every parameter by epsilon times its gradient */
+  void modifyParamWholeLayer( T epsilon )
+  {
+    LayerTimings::Scope timer { timings_.update };
+    weights_ -= grad_weights_ * epsilon;
+    biases_ -= grad_biases_ * epsilon;
+    this->endSum();
+  }
+
+  /* parameters are numbered as in Layer: row by row through weights(), then biases() */
+  void perturbWeight( const unsigned int weight_num, const T epsilon )
+  {
+    const unsigned int i = weight_num / gates_size;
+    const unsigned int j = weight_num % gates_size;
+    if ( i < input_size + hidden_size ) {
+      weights_( i, j ) += epsilon;
+    } else {
+      biases_( 0, j ) += epsilon;
+    }
+  }
+
+  T getEvaluatedGradient( const unsigned int paramNum ) const
+  {
+    const unsigned int i = paramNum / gates_size;
+    const unsigned int j = paramNum % gates_size;
+    return i < input_size + hidden_size ? grad_weights_( i, j ) : grad_biases_( 0, j );
+  }
+
+  unsigned int getNumParams() const { return ( input_size + hidden_size + 1 ) * gates_size; }
+  unsigned int getInputSize() const { return input_size; }
+  unsigned int getOutputSize() const { return hidden_size; }
+
+  /* number of steps recorded since resetState */
+  unsigned int numSteps() const { return num_steps_; }
+
+  void print( const unsigned int layer_num ) const
+  {
+    const IOFormat CleanFmt( 4, 0, ", ", "\n", "[", "]" );
+
+    cout << "GRU layer " << layer_num << endl;
+    cout << "input_size: " << input_size << " -> "
+         << "hidden_size: " << hidden_size << " (" << bptt_steps << " steps recorded)" << endl
+         << endl;
+
+    cout << "weights:" << endl << weights_.format( CleanFmt ) << endl << endl;
+    cout << "biases:" << endl << biases_.format( CleanFmt ) << endl << endl;
+    cout << "state:" << endl << state_.format( CleanFmt ) << endl << endl << endl;
+  }
+
+  const Matrix<T, input_size + hidden_size, gates_size>& weights() const { return weights_; }
+  const Matrix<T, 1, gates_size>& biases() const { return biases_; }
+  const Matrix<T, input_size + hidden_size, gates_size>& grad_weights() const { return grad_weights_; }
+  const Matrix<T, 1, gates_size>& grad_biases() const { return grad_biases_; }
+
+  Matrix<T, input_size + hidden_size, gates_size>& weights() { return weights_; }
+  Matrix<T, 1, gates_size>& biases() { return biases_; }
+
+  const LayerTimings& timings() const { return timings_; }
+  LayerTimings& timings() { return timings_; }
+};
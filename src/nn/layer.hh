@@ -5,14 +5,95 @@
 
 #pragma once
 
+#include "activation.hh"
+#include "arena.hh"
+#include "eigen.hh"
+#include "gradient_sum.hh"
+#include "profile.hh"
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <cassert>
 #include <cmath>
-#include <Eigen/Dense>
-#include <unsupported/Eigen/SpecialFunctions>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <utility>
 
 using namespace std;
 using namespace Eigen;
 
+// layers with at least this many weights split their products by output column across ThreadPool::layers()
+constexpr unsigned int parallel_layer_weights = 1 << 20;
+
+// columns in each task of a split product (whole cache lines of floats)
+constexpr unsigned int column_block = 64;
+
+// most stack a task may take for the packed operands of its block's product
+constexpr size_t column_block_stack_bytes = 1 << 21;
+
+/*
+ * Function Name: fitsColumnBlock
+ * Description: This function tells whether a column block's product with a
+ *              rows x depth matrix packs its operands within
+ *              column_block_stack_bytes. Deeper products are left unsplit.
+ */
+template<class T, unsigned int rows, unsigned int depth>
+constexpr bool fitsColumnBlock()
+{
+  return size_t( rows + column_block ) * depth * sizeof( T ) <= column_block_stack_bytes;
+}
+
+/*
+ * Function Name: forEachColumnBlock
+ * Description: This function splits the product of a rows x depth and a
+ *              depth x columns matrix into tasks of column_block columns
+ *              (the last one takes the rest), and calls f( first, width ) for
+ *              every task across ThreadPool::layers(), with width an
+ *              integral_constant. Blocks of a compile-time width keep the
+ *              product's packed operands in fixed-size buffers on the stack
+ *              of the thread that runs the task, instead of allocating them
+ *              on every call.
+ */
+template<class T, unsigned int rows, unsigned int depth, unsigned int columns, class F>
+void forEachColumnBlock( const F& f )
+{
+  constexpr unsigned int full_blocks = columns / column_block;
+  constexpr unsigned int rest = columns % column_block;
+  ThreadPool::layers().parallel_for( full_blocks + ( rest > 0 ), [&]( const unsigned int block ) {
+    if constexpr ( rest > 0 ) {
+      if ( block == full_blocks ) {
+        f( Index( block * column_block ), integral_constant<int, rest>() );
+        return;
+      }
+    }
+    f( Index( block * column_block ), integral_constant<int, column_block>() );
+  } );
+}
+
+/*
+ * Function Name: applyAffine
+ * Description: This function computes out = Act( input * weights + biases ),
+ *              the forward pass of a fully connected layer, for Layer::applyInto
+ *              and for networks whose parameters live elsewhere (MappedNetwork).
+ *              out must not share storage with input: the product is written
+ *              into out as it reads input.
+ */
+template<class Act, class Input, class Weights, class Biases, class Out>
+void applyAffine( const MatrixBase<Input>& input,
+                  const MatrixBase<Weights>& weights,
+                  const MatrixBase<Biases>& biases,
+                  MatrixBase<Out>& out )
+{
+  out.noalias() = input * weights;
+  out.rowwise() += biases;
+  if constexpr ( not activation::is_identity<Act> ) {
+    out.array() = Act::forward( out.array() );
+  }
+}
+
 /*
  * Class Name: Layer
  * Description: This class defines the behavior of the layer (atom component of
@@ -36,29 +117,193 @@ using namespace Eigen;
  *			2. batch_size specifies the size of a batch (usually 1)
  *			3. input_size specifies the size of input
  *			4. output_size specifies the size of output
+ *			5. Activation specifies the activation policy used by apply and
+ *			   computeDeltas (see activation.hh; ReLU unless given)
+ *
+ *              Layers with at least parallel_layer_weights weights (e.g.
+ *              1024x1024 and wider) split apply, the deltas from the next
+ *              layer and evaluateGradients by output column across the
+ *              pinned threads of ThreadPool::layers(). Each thread computes
+ *              whole columns, so the result does not depend on the number
+ *              of threads. Products too deep for fitsColumnBlock (large
+ *              batches of wide layers) stay unsplit.
  */
-template<class T, unsigned int batch_size, unsigned int input_size, unsigned int output_size>
-class Layer
+template<class T,
+         unsigned int batch_size,
+         unsigned int input_size,
+         unsigned int output_size,
+         class Activation = activation::ReLU>
+class Layer : public GradientSum<Layer<T, batch_size, input_size, output_size, Activation>, T>
 {
 private:
+  friend class GradientSum<Layer, T>;
+
+  // every matrix starts on its own 64-byte cache line, also inside a ParameterArena
+
   // matrix to store outputs of neurons after activation sigma(W*X + B)
-  Matrix<T, batch_size, output_size> output_ {};
+  alignas( 64 ) Matrix<T, batch_size, output_size> output_ {};
   // matrix to store outputs of neurons before activation W*X + B
-  Matrix<T, batch_size, output_size> unactivated_output_ {};
-  // matrix to store weights of the connections  (W)*X + (B)
-  Matrix<T, input_size, output_size> weights_ {};
-  // matrix to store biases of the layer W*X + (B)
-  Matrix<T, 1, output_size> biases_ {};
+  alignas( 64 ) Matrix<T, batch_size, output_size> unactivated_output_ {};
+  struct ParameterSet
+  {
+    // matrix to store weights of the connections  (W)*X + (B)
+    alignas( 64 ) Matrix<T, input_size, output_size> weights {};
+    // matrix to store biases of the layer W*X + (B)
+    alignas( 64 ) Matrix<T, 1, output_size> biases {};
+  };
+
+  // the two other parameter sets, for tryStep, shelve and snapshot; copies of the layer copy them onto the heap
+  struct TrialSets
+  {
+    // where to allocate them (see placeTrialSetsIn), or nullptr for the heap
+    ParameterArena* arena {};
+    std::unique_ptr<ParameterSet[]> heap {};
+    ParameterSet* sets {};
+
+    TrialSets() = default;
+    TrialSets( const TrialSets& other ) { *this = other; }
+    TrialSets& operator=( const TrialSets& other )
+    {
+      if ( other.sets ) {
+        allocate();
+        std::copy( other.sets, other.sets + 2, sets );
+      }
+      return *this;
+    }
+    ~TrialSets()
+    {
+      if ( sets and not heap ) {
+        sets[0].~ParameterSet();
+        sets[1].~ParameterSet();
+      }
+    }
+
+    void allocate()
+    {
+      if ( sets ) {
+        return;
+      }
+      if ( arena ) {
+        sets = static_cast<ParameterSet*>( arena->allocate( 2 * sizeof( ParameterSet ), alignof( ParameterSet ) ) );
+        new ( sets ) ParameterSet();
+        new ( sets + 1 ) ParameterSet();
+      } else {
+        heap = std::make_unique<ParameterSet[]>( 2 );
+        sets = heap.get();
+      }
+    }
+  };
+
+  // set 0 is params_, sets 1 and 2 are trial_; trial_ is only allocated by the first tryStep or snapshot, so
+  // layers that are never trained with trial steps keep a single parameter set
+  constexpr static unsigned char no_set = 3;
+  ParameterSet params_ {};
+  TrialSets trial_ {};
+  unsigned char live_ = 0;
+  // the set holding parameters that rollback can return to
+  unsigned char saved_ = no_set;
+  // the set holding a trial step put aside by shelve
+  unsigned char shelved_ = no_set;
+
+  ParameterSet& set( const unsigned char i ) { return i == 0 ? params_ : trial_.sets[i - 1]; }
+  ParameterSet& live() { return set( live_ ); }
+  const ParameterSet& live() const { return live_ == 0 ? params_ : trial_.sets[live_ - 1]; }
+
+  // a set that is neither live nor shelved (so possibly the saved one), allocated on first use
+  unsigned char spare()
+  {
+    trial_.allocate();
+    unsigned char i = 0;
+    while ( i == live_ or i == shelved_ ) {
+      i++;
+    }
+    return i;
+  }
 
   // matrix to store errors at intermediate nodes for given input i.e. target activation - current activation
-  Matrix<T, batch_size, output_size> deltas_ {};
+  alignas( 64 ) Matrix<T, batch_size, output_size> deltas_ {};
   // matrix to store gradients w.r.t. weights
-  Matrix<T, input_size, output_size> grad_weights_ {};
+  alignas( 64 ) Matrix<T, input_size, output_size> grad_weights_ {};
   // matrix to store gradients w.r.t. biases
-  Matrix<T, 1, output_size> grad_biases_ {};
+  alignas( 64 ) Matrix<T, 1, output_size> grad_biases_ {};
+
+  // time spent in each phase (empty unless built with NN_PROFILE)
+  LayerTimings timings_ {};
 
   // unsigned int numParam = (input_size + 1) * output_size;
 
+  constexpr static bool parallel = input_size * output_size >= parallel_layer_weights
+                                   and fitsColumnBlock<T, batch_size, input_size>()
+                                   and fitsColumnBlock<T, input_size, batch_size>()
+                                   and fitsColumnBlock<T, batch_size, output_size>();
+
+  // whether two expressions share storage (only those with direct access, e.g. a Matrix, Map or block, have any)
+  template<class A, class B>
+  static bool overlaps( const MatrixBase<A>& a, const MatrixBase<B>& b )
+  {
+    if constexpr ( bool( A::Flags & DirectAccessBit ) and bool( B::Flags & DirectAccessBit ) ) {
+      const auto extent = []( const auto& m ) {
+        const auto begin = reinterpret_cast<uintptr_t>( m.derived().data() );
+        const auto count = ( m.outerSize() - 1 ) * m.outerStride() + ( m.innerSize() - 1 ) * m.innerStride() + 1;
+        return std::pair { begin, begin + count * sizeof( *m.derived().data() ) };
+      };
+      const auto [a_begin, a_end] = extent( a );
+      const auto [b_begin, b_end] = extent( b );
+      return a.size() > 0 and b.size() > 0 and a_begin < b_end and b_begin < a_end;
+    } else {
+      return false;
+    }
+  }
+
+  // add input^T * deltas_ to grad_weights_, one batch entry at a time (overwrite: set instead of add)
+  template<bool overwrite, class Input>
+  void addGradients( const MatrixBase<Input>& input )
+  {
+    if constexpr ( parallel ) {
+      forEachColumnBlock<T, input_size, batch_size, output_size>( [&]( const Index first, auto block_width ) {
+        constexpr int count = decltype( block_width )::value;
+        auto grad = grad_weights_.template middleCols<count>( first );
+        if constexpr ( overwrite ) {
+          grad.setZero();
+        }
+        for ( unsigned int b = 0; b < batch_size; b++ ) {
+          grad.noalias() += input.row( b ).transpose() * deltas_.row( b ).template segment<count>( first );
+        }
+      } );
+      return;
+    }
+
+    if constexpr ( overwrite ) {
+      grad_weights_ = Matrix<T, input_size, output_size>::Zero();
+    }
+    for ( unsigned int b = 0; b < batch_size; b++ ) {
+      // for ( unsigned int j = 0; j < output_size; j++ ) {
+      //   // for ( unsigned int i = 0; i < input_size; i++ ) {
+      //   //   grad_weights_( i, j ) += input( b, i ) * deltas_( b, j );
+      //   // }
+      //   grad_weights_.col( j ) += input.row( b ) * deltas_( b, j );
+      // }
+      grad_weights_.noalias() += input.row( b ).transpose() * deltas_.row( b );
+      // grad_biases_.noalias() += deltas_.row( b );
+      // noalias is an eigen optimisation - otherwise becomes slower than for loops
+    }
+  }
+
+  // add this micro-batch's gradients to the sum (see GradientSum::accumulateGradients)
+  template<class Input>
+  void addToGradients( const MatrixBase<Input>& input )
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
+    addGradients<false>( input );
+    grad_biases_ += deltas_.colwise().sum();
+  }
+
+  void clearGradients()
+  {
+    grad_weights_.setZero();
+    grad_biases_.setZero();
+  }
+
 public:
   Layer() {}
 
@@ -69,54 +314,104 @@ public:
    */
   void initializeWeightsRandomly()
   {
-    weights_ = Matrix<T, input_size, output_size>::Random();
-    biases_ = Matrix<T, 1, output_size>::Random();
+    weights() = Matrix<T, input_size, output_size>::Random();
+    biases() = Matrix<T, 1, output_size>::Random();
   }
 
-  void initializeWeights( const Matrix<T, input_size, output_size>& weights )
-  {
-    weights_ = weights.replicate(1,1);
-  }
-
-  void initializeBiases( const Matrix<T, 1, output_size>& biases ) { biases_= biases.replicate(1,1); }
-
-  float sigmoid( int x ) { return 1/(1 + exp(-x)); }
   /*
-   * Function Name: apply
-   * Description: This function applys the input to the neuralnetwork.
-   *              The Matrix output_ will be updated.
+   * Function Name: initializeWeightsRandomly
+   * Description: Same as above, but draws from the caller's generator instead
+   *              of the C RNG, so concurrently trained networks stay
+   *              reproducible from their own seed.
    * Parameters:
-   * 			1. input is the input to the layer
+   *			1. rng is a standard uniform random bit generator
    */
-  void apply( const Matrix<T, batch_size, input_size>& input )
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
   {
-    unactivated_output_ = ( input * weights_ ).rowwise() + biases_;
-    output_ = unactivated_output_.cwiseMax( 0 );  
+    uniform_real_distribution<T> dist( -1, 1 );
+    weights() = Matrix<T, input_size, output_size>::NullaryExpr( [&] { return dist( rng ); } );
+    biases() = Matrix<T, 1, output_size>::NullaryExpr( [&] { return dist( rng ); } );
   }
 
-  void apply_leaky( const Matrix<T, batch_size, input_size>& input )
+  void initializeWeights( const Matrix<T, input_size, output_size>& weights )
   {
-    unactivated_output_ = ( input * weights_ ).rowwise() + biases_;
-    output_ = unactivated_output_.cwiseMax( 0.01 * unactivated_output_ );  
+    live().weights = weights.replicate(1,1);
   }
 
-  void apply_gelu( const Matrix<T, batch_size, input_size>& input )
+  void initializeBiases( const Matrix<T, 1, output_size>& biases ) { live().biases = biases.replicate(1,1); }
+
+  /*
+   * Function Name: applyWith
+   * Description: This function applys the input to the layer with the given
+   *              activation policy (see activation.hh). The Matrix output_
+   *              will be updated.
+   * Parameters:
+   * 			1. input is the input to the layer: any batch_size x input_size
+   * 			   Eigen expression, e.g. a Matrix or a Map over the caller's
+   * 			   memory (matrix_view.hh), read in place
+   */
+  template<class Act, class Input>
+  void applyWith( const MatrixBase<Input>& input )
   {
-    unactivated_output_ = ( input * weights_).rowwise() + biases_;
-    auto temp_output_ = unactivated_output_ / pow(2, 0.5);
-    for (unsigned int i = 0; i < unactivated_output_.rows(); i++) {
-      for (unsigned int j = 0; j < unactivated_output_.cols(); j++) {
-        output_(i, j) = unactivated_output_(i, j) * 0.5 * (1 + temp_output_(i, j));
-      }
+    LayerTimings::Scope timer { timings_.apply };
+    if constexpr ( parallel ) {
+      forEachColumnBlock<T, batch_size, input_size, output_size>( [&]( const Index first, auto block_width ) {
+        constexpr int count = decltype( block_width )::value;
+        auto z = unactivated_output_.template middleCols<count>( first );
+        z.noalias() = input * weights().template middleCols<count>( first );
+        z.rowwise() += biases().template middleCols<count>( first );
+        if constexpr ( activation::is_identity<Act> ) {
+          output_.template middleCols<count>( first ) = z;
+        } else {
+          output_.template middleCols<count>( first ).array() = Act::forward( z.array() );
+        }
+      } );
+      return;
+    }
+    unactivated_output_.noalias() = input * weights();
+    unactivated_output_.rowwise() += biases();
+    if constexpr ( activation::is_identity<Act> ) {
+      output_ = unactivated_output_;
+    } else {
+      output_.array() = Act::forward( unactivated_output_.array() );
     }
   }
 
-  void apply_without_activation( const Matrix<T, batch_size, input_size>& input )
+  /*
+   * Function Name: applyInto
+   * Description: Same as applyWith, but writes the activated output into the
+   *              caller's matrix (e.g. a Map over the caller's buffer) instead
+   *              of output_. For inference only: output_ and the
+   *              unactivated output that computeDeltas needs are not updated.
+   * Parameters:
+   * 			1. input is the input to the layer
+   * 			2. out is a batch_size x output_size matrix, Map or block to
+   * 			   write to (taken by const reference so that temporary views
+   * 			   can be passed, as Eigen recommends). It must not share
+   * 			   storage with input: the product is written into out as
+   * 			   it reads input.
+   */
+  template<class Act, class Input, class Out>
+  void applyInto( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
   {
-    unactivated_output_ = ( input * weights_ ).rowwise() + biases_;
-    output_ = unactivated_output_;
+    assert( not overlaps( input, out ) );
+    LayerTimings::Scope timer { timings_.apply };
+    applyAffine<Act>( input, weights(), biases(), const_cast<MatrixBase<Out>&>( out ) );
   }
 
+  /*
+   * Function Name: apply
+   * Description: This function applys the input to the layer with the
+   *              layer's activation. The Matrix output_ will be updated.
+   * Parameters:
+   * 			1. input is the input to the layer
+   */
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    applyWith<Activation>( input );
+  }
 
   /*
    * Function Name: print
@@ -134,8 +429,8 @@ public:
          << "output_size: " << output_size << endl
          << endl;
 
-    cout << "weights:" << endl << weights_.format( CleanFmt ) << endl << endl;
-    cout << "biases:" << endl << biases_.format( CleanFmt ) << endl << endl;
+    cout << "weights:" << endl << weights().format( CleanFmt ) << endl << endl;
+    cout << "biases:" << endl << biases().format( CleanFmt ) << endl << endl;
     cout << "unactivated_output:" << endl << unactivated_output_.format( CleanFmt ) << endl << endl;
     cout << "output:" << endl << output_.format( CleanFmt ) << endl << endl;
 
@@ -148,9 +443,9 @@ public:
   {
     cout << layer_num + layer_offset << endl;
     const IOFormat CleanFmt( 10, 0, ", ", "\n", "[", "]" );
-    cout << "weights:" << endl << weights_.format( CleanFmt ) << endl << endl;
+    cout << "weights:" << endl << weights().format( CleanFmt ) << endl << endl;
 
-    cout << "biases:" << endl << biases_.format( CleanFmt ) << endl << endl;
+    cout << "biases:" << endl << biases().format( CleanFmt ) << endl << endl;
 
   }
   
@@ -171,9 +466,9 @@ public:
     const unsigned int i = weight_num / output_size;
     const unsigned int j = weight_num % output_size;
     if ( i < input_size ) {
-      weights_( i, j ) += epsilon;
+      weights()( i, j ) += epsilon;
     } else {
-      biases_( 0, j ) += epsilon;
+      biases()( 0, j ) += epsilon;
     }
   }
 
@@ -189,14 +484,91 @@ public:
    * Description: This function decrements all parameters including weights in
    *		      Matrix weights_ and biases in Matrix biases_ by amount
    *              (epsilon * the gradient calculated at the corresponding location).
+   *              The gradients are used up: the next accumulateGradients
+   *              starts a new sum.
    * Parameters:
    *			1. epsilon is the constant to be multiplied to the amount to be
    *			   decremented
    */
   void modifyParamWholeLayer( T epsilon )
   {
-    weights_ -= grad_weights_ * epsilon;
-    biases_ -= grad_biases_ * epsilon;
+    LayerTimings::Scope timer { timings_.update };
+    weights() -= grad_weights_ * epsilon;
+    biases() -= grad_biases_ * epsilon;
+    this->endSum();
+  }
+
+  /*
+   * Function Name: tryStep
+   * Description: Like modifyParamWholeLayer, but writes the stepped parameters
+   *              into another parameter set (allocated by the first call)
+   *              and makes that one live, so the parameters from before the
+   *              step stay saved for rollback.
+   * Parameters:
+   *			1. epsilon is the constant to be multiplied to the amount to be
+   *			   decremented
+   */
+  void tryStep( T epsilon )
+  {
+    LayerTimings::Scope timer { timings_.update };
+    const unsigned char next = spare();
+    set( next ).weights = weights() - grad_weights_ * epsilon;
+    set( next ).biases = biases() - grad_biases_ * epsilon;
+    saved_ = live_;
+    live_ = next;
+    this->endSum();
+  }
+
+  /* save a copy of the live parameters for a later rollback (one copy of the layer) */
+  void snapshot()
+  {
+    const unsigned char next = spare();
+    set( next ) = live();
+    saved_ = next;
+  }
+
+  /* bring back, bit for bit, the parameters saved by the last tryStep or snapshot (no copy) */
+  void rollback()
+  {
+    assert( saved_ != no_set );
+    live_ = saved_;
+    saved_ = no_set;
+    shelved_ = no_set;
+  }
+
+  /* like rollback, but put the trial step aside so that unshelve can bring it back after another tryStep (no copy) */
+  void shelve()
+  {
+    assert( saved_ != no_set );
+    shelved_ = live_;
+    live_ = saved_;
+    saved_ = no_set;
+  }
+
+  /* keep the trial step put aside by shelve and drop the others (no copy) */
+  void unshelve()
+  {
+    assert( shelved_ != no_set );
+    live_ = shelved_;
+    saved_ = no_set;
+    shelved_ = no_set;
+  }
+
+  /* keep the live parameters and drop the saved and shelved ones (no copy) */
+  void commit()
+  {
+    saved_ = no_set;
+    shelved_ = no_set;
+  }
+
+  // bytes placeTrialSetsIn takes from the arena, at most
+  constexpr static size_t trial_set_bytes = 2 * sizeof( ParameterSet );
+
+  /* allocate the other parameter sets, when first used, from the arena holding the layer instead of the heap */
+  void placeTrialSetsIn( ParameterArena& arena )
+  {
+    assert( not trial_.sets );
+    trial_.arena = &arena;
   }
 
   /*
@@ -218,56 +590,130 @@ public:
     }
   }
 
-  const Matrix<T, batch_size, input_size> computeDeltas( Matrix<T, batch_size, output_size> nextLayerDeltas )
+  /*
+   * Function Name: setDeltasWith
+   * Description: This function computes the deltas of the layer's
+   *              pre-activation outputs in place in deltas_: the derivative
+   *              of the loss w.r.t. the layer's output, times the derivative
+   *              of the given activation policy. The layer must have been
+   *              applied with the same activation.
+   * Parameters:
+   *			1. outputDeltas is the derivative of the loss w.r.t. the layer's
+   *			   output, as any Eigen expression; given the next layer's
+   *			   inputDeltas(), the product is evaluated straight into
+   *			   deltas_, with no temporary
+   */
+  template<class Act, class OutputDeltas>
+  void setDeltasWith( const MatrixBase<OutputDeltas>& outputDeltas )
   {
-    // activated nodes is the matrix that stores 0/1 corresponding to whether the output node was activated
-    Matrix<T, batch_size, output_size> activated_nodes
-      = ( unactivated_output_.array() > 0 ).template cast<T>().matrix();
-    deltas_ = nextLayerDeltas.cwiseProduct( activated_nodes );
-    return deltas_ * weights_.transpose();
+    LayerTimings::Scope timer { timings_.computeDeltas };
+    deltas_.noalias() = outputDeltas;
+    if constexpr ( not activation::is_identity<Act> ) {
+      deltas_.array() *= Act::derivative( unactivated_output_.array(), output_.array() );
+    }
   }
 
-    const Matrix<T, batch_size, input_size> computeLeakyDeltas( Matrix<T, batch_size, output_size> nextLayerDeltas )
+  /*
+   * Function Name: setDeltasFrom
+   * Description: Same as setDeltasWith, given the next layer (already
+   *              holding its deltas) instead of its inputDeltas(). When the
+   *              next layer is wide, the product with its weights is split
+   *              by this layer's output column across ThreadPool::layers().
+   * Parameters:
+   *			1. next is the layer this one feeds
+   */
+  template<class Act, class Next>
+  void setDeltasFrom( const Next& next )
   {
-    // activated nodes is the matrix that stores 0/1 corresponding to whether the output node was activated
-    Matrix<T, batch_size, output_size> activated_nodes
-      = ( unactivated_output_.array() > 0 ).template cast<T>().matrix();
-    activated_nodes = 0.99 * activated_nodes;
-    activated_nodes.array() += 0.01;
-    deltas_ = nextLayerDeltas.cwiseProduct( activated_nodes );
-    return deltas_ * weights_.transpose();
+    constexpr unsigned int next_output_size = decay_t<decltype( next.weights() )>::ColsAtCompileTime;
+    if constexpr ( output_size * next_output_size >= parallel_layer_weights
+                   and fitsColumnBlock<T, batch_size, next_output_size>() ) {
+      LayerTimings::Scope timer { timings_.computeDeltas };
+      forEachColumnBlock<T, batch_size, next_output_size, output_size>( [&]( const Index first, auto block_width ) {
+        constexpr int count = decltype( block_width )::value;
+        auto deltas = deltas_.template middleCols<count>( first );
+        deltas.noalias() = next.deltas() * next.weights().template middleRows<count>( first ).transpose();
+        if constexpr ( not activation::is_identity<Act> ) {
+          deltas.array() *= Act::derivative( unactivated_output_.template middleCols<count>( first ).array(),
+                                             output_.template middleCols<count>( first ).array() );
+        }
+      } );
+    } else {
+      setDeltasWith<Act>( next.inputDeltas() );
+    }
   }
 
-  const Matrix<T, batch_size, input_size> computeDeltasLastLayer(
-    Matrix<T, batch_size, output_size> nextLayerDeltas )
+  /*
+   * Function Name: inputDeltas
+   * Description: This function returns the derivative of the loss w.r.t. the
+   *              layer's input (deltas times the transposed weights), as an
+   *              unevaluated product: it costs a GEMV/GEMM only where it is
+   *              assigned, and must be used before the layer changes.
+   */
+  auto inputDeltas() const { return deltas_ * weights().transpose(); }
+
+  /*
+   * Function Name: computeDeltasWith
+   * Description: This function computes the deltas of the layer (as
+   *              setDeltasWith) and returns the deltas of its input.
+   * Parameters:
+   *			1. nextLayerDeltas is the derivative of the loss w.r.t. the
+   *			   layer's output
+   */
+  template<class Act>
+  const Matrix<T, batch_size, input_size> computeDeltasWith( const Matrix<T, batch_size, output_size>& nextLayerDeltas )
   {
-    deltas_ = nextLayerDeltas;
-    return deltas_ * weights_.transpose();
+    setDeltasWith<Act>( nextLayerDeltas );
+    if constexpr ( parallel ) {
+      Matrix<T, batch_size, input_size> ret;
+      forEachColumnBlock<T, batch_size, output_size, input_size>( [&]( const Index first, auto block_width ) {
+        constexpr int count = decltype( block_width )::value;
+        ret.template middleCols<count>( first ).noalias()
+          = deltas_ * weights().template middleRows<count>( first ).transpose();
+      } );
+      return ret;
+    }
+    return inputDeltas();
   }
 
-  void evaluateGradients( const Matrix<T, batch_size, input_size>& input )
+  const Matrix<T, batch_size, input_size> computeDeltas( const Matrix<T, batch_size, output_size>& nextLayerDeltas )
   {
-    grad_weights_ = Matrix<T, input_size, output_size>::Zero();
+    return computeDeltasWith<Activation>( nextLayerDeltas );
+  }
+
+  /*
+   * Function Name: evaluateGradients
+   * Description: This function computes the gradients w.r.t. the weights and
+   *              biases from the deltas and the input of the last pass. It
+   *              overwrites any accumulated gradients, and counts as the first
+   *              micro-batch of a new sum (see accumulateGradients).
+   * Parameters:
+   *			1. input is the input the layer was applied to
+   */
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& input )
+  {
+    LayerTimings::Scope timer { timings_.evaluateGradients };
     // grad_biases_ = Matrix<T, 1, output_size>::Zero();
-    for ( unsigned int b = 0; b < batch_size; b++ ) {
-      // for ( unsigned int j = 0; j < output_size; j++ ) {
-      //   // for ( unsigned int i = 0; i < input_size; i++ ) {
-      //   //   grad_weights_( i, j ) += input( b, i ) * deltas_( b, j );
-      //   // }
-      //   grad_weights_.col( j ) += input.row( b ) * deltas_( b, j );
-      // }
-      grad_weights_.noalias() += input.row( b ).transpose() * deltas_.row( b );
-      // grad_biases_.noalias() += deltas_.row( b );
-      // noalias is an eigen optimisation - otherwise becomes slower than for loops
-    }
+    addGradients<true>( input );
     grad_biases_ = deltas_.colwise().sum();
+    this->startSum();
   }
 
-  const Matrix<T, input_size, output_size>& weights() const { return weights_; }
+  // accumulateGradients, zeroGradients, applyAccumulated and accumulatedBatches come from GradientSum
+
+  const Matrix<T, input_size, output_size>& weights() const { return live().weights; }
   const Matrix<T, batch_size, output_size>& output() const { return output_; }
-  const Matrix<T, 1, output_size>& biases() const { return biases_; }
+  const Matrix<T, 1, output_size>& biases() const { return live().biases; }
+  const Matrix<T, batch_size, output_size>& deltas() const { return deltas_; }
+  const Matrix<T, input_size, output_size>& grad_weights() const { return grad_weights_; }
+  const Matrix<T, 1, output_size>& grad_biases() const { return grad_biases_; }
 
   // accessors for mutable access to weights and biases
-  Matrix<T, input_size, output_size>& weights() { return weights_; }
-  Matrix<T, 1, output_size>& biases() { return biases_; }
+  Matrix<T, input_size, output_size>& weights() { return live().weights; }
+  Matrix<T, 1, output_size>& biases() { return live().biases; }
+
+  // per-phase timing records (see profile.hh)
+  const LayerTimings& timings() const { return timings_; }
+  LayerTimings& timings() { return timings_; }
 };
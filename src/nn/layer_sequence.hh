@@ -0,0 +1,291 @@
+/**
+ * File name: layer_sequence.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "activation.hh"
+#include "arena.hh"
+#include "eigen.hh"
+
+#include <cassert>
+#include <iostream>
+
+/*
+ * Class Name: LayerSequence
+ * Description: The part of the Network interface that visits the layers one
+ *              at a time, shared by SequentialNetwork (and so Network) and
+ *              ComposedNetwork: initialization, access to a layer by number,
+ *              the gradient sum and trial steps of every layer, and the
+ *              numerical gradient. Layers are numbered from 0, in the order
+ *              forEachLayer visits them.
+ *
+ *              Derived provides forEachLayer( f ), const and not, and the
+ *              forward and backward passes, whose hidden activation can be
+ *              overridden (apply<Hidden>, computeDeltas<Hidden>, see
+ *              activation::Own); apply_leaky, apply_gelu and
+ *              computeLeakyDeltas are shorthands for those.
+ *
+ * Inputs:
+ *			1. Derived is the network class
+ *			2. T specifies the type of variables in the network
+ */
+template<class Derived, class T>
+class LayerSequence
+{
+  Derived& derived() { return static_cast<Derived&>( *this ); }
+  const Derived& derived() const { return static_cast<const Derived&>( *this ); }
+
+  /* calls f on layer layerNum */
+  template<class F>
+  void withLayer( const unsigned int layerNum, F&& f )
+  {
+    unsigned int i = 0;
+    derived().forEachLayer( [&]( auto& layer ) {
+      if ( i++ == layerNum ) {
+        f( layer );
+      }
+    } );
+    assert( layerNum < i );
+  }
+
+  template<class F>
+  void withLayer( const unsigned int layerNum, F&& f ) const
+  {
+    unsigned int i = 0;
+    derived().forEachLayer( [&]( const auto& layer ) {
+      if ( i++ == layerNum ) {
+        f( layer );
+      }
+    } );
+    assert( layerNum < i );
+  }
+
+public:
+  /*
+   * FunctionName: initializeWeightsRandomly
+   * Description: This function assigns random values to all parameters in
+   *              the network (from the C RNG, or from the caller's generator
+   *              so that concurrently trained networks stay reproducible).
+   */
+  void initializeWeightsRandomly()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.initializeWeightsRandomly(); } );
+  }
+
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
+  {
+    derived().forEachLayer( [&]( auto& layer ) { layer.initializeWeightsRandomly( rng ); } );
+  }
+
+  void initializeWeights( const unsigned int layerNum,
+                          const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& weights )
+  {
+    withLayer( layerNum, [&]( auto& layer ) { layer.initializeWeights( weights ); } );
+  }
+
+  void initializeBiases( const unsigned int layerNum,
+                         const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& biases )
+  {
+    withLayer( layerNum, [&]( auto& layer ) { layer.initializeBiases( biases ); } );
+  }
+
+  /* run with LeakyReLU or GELU in place of the hidden layers' own activation (the last layer keeps its own) */
+  template<class Input>
+  void apply_leaky( const Eigen::MatrixBase<Input>& input )
+  {
+    derived().template apply<activation::LeakyReLU>( input );
+  }
+
+  template<class Input>
+  void apply_gelu( const Eigen::MatrixBase<Input>& input )
+  {
+    derived().template apply<activation::GELU>( input );
+  }
+
+  /* computeDeltas after apply_leaky */
+  void computeLeakyDeltas() { derived().template computeDeltas<activation::LeakyReLU>(); }
+
+  template<class Seed>
+  void computeLeakyDeltas( const Eigen::MatrixBase<Seed>& seed )
+  {
+    derived().template computeDeltas<activation::LeakyReLU>( seed );
+  }
+
+  /*
+   * Function Name: print
+   * Description: This function prints the basic info of every layer to
+   *              stdout.
+   * Parameters:
+   *			1. layerNum is the number printed for the first layer
+   */
+  void print( const unsigned int layerNum = 0 ) const
+  {
+    unsigned int i = layerNum;
+    derived().forEachLayer( [&]( const auto& layer ) { layer.print( i++ ); } );
+  }
+
+  void printWeights( int layer_offset, const unsigned int layerNum = 0 ) const
+  {
+    unsigned int i = layerNum;
+    derived().forEachLayer( [&]( const auto& layer ) { layer.printWeights( layer_offset, i++ ); } );
+  }
+
+  void printLayerOutput( const unsigned int layerNum ) const
+  {
+    withLayer( layerNum, []( const auto& layer ) { layer.printLayerOutput(); } );
+  }
+
+  /* getter of number of layers */
+  unsigned int getNumLayers() const
+  {
+    unsigned int n = 0;
+    derived().forEachLayer( [&]( const auto& ) { n++; } );
+    return n;
+  }
+
+  /* getter of number of parameters in a specific layer */
+  unsigned int getNumParams( const unsigned int layerNum ) const
+  {
+    unsigned int n = 0;
+    withLayer( layerNum, [&]( const auto& layer ) { n = layer.getNumParams(); } );
+    return n;
+  }
+
+  /* getter of input size of the specified layer */
+  unsigned int getLayerInputSize( const unsigned int layerNum ) const
+  {
+    unsigned int n = 0;
+    withLayer( layerNum, [&]( const auto& layer ) { n = layer.getInputSize(); } );
+    return n;
+  }
+
+  /* getter of output size of the specified layer */
+  unsigned int getLayerOutputSize( const unsigned int layerNum ) const
+  {
+    unsigned int n = 0;
+    withLayer( layerNum, [&]( const auto& layer ) { n = layer.getOutputSize(); } );
+    return n;
+  }
+
+  /*
+   * Function Name: modifyParamWholeLayer
+   * Description: This function decrements all parameters of the specified
+   *              layer by epsilon times their gradients.
+   * Parameters:
+   *			1. layerNum specifies which layer to be decremented
+   *			2. epsilon is the constant to be multiplied to the gradients
+   */
+  void modifyParamWholeLayer( const unsigned int layerNum, T epsilon )
+  {
+    withLayer( layerNum, [&]( auto& layer ) { layer.modifyParamWholeLayer( epsilon ); } );
+  }
+
+  /* the previously computed gradient of the specified param in the specified layer */
+  T getEvaluatedGradient( const unsigned int layerNum, const unsigned int paramNum )
+  {
+    T gradient {};
+    withLayer( layerNum, [&]( auto& layer ) { gradient = layer.getEvaluatedGradient( paramNum ); } );
+    return gradient;
+  }
+
+  /*
+   * Function Name: calculateNumericalGradient
+   * Description: This function estimates the gradient of one parameter by
+   *              central differences of the network's summed outputs, and
+   *              leaves the network as it found it (parameters and outputs).
+   * Parameters:
+   *			1. input is the input to the network
+   *			2. layerNum and weightNum specify the parameter (see
+   *			   Layer::perturbWeight)
+   *			3. epsilon is the size of the step
+   * Return Value: the gradient, averaged over the batch
+   */
+  template<class Input>
+  T calculateNumericalGradient( const Eigen::MatrixBase<Input>& input,
+                                const unsigned int layerNum,
+                                const unsigned int weightNum,
+                                const T epsilon = 1e-8 )
+  {
+    const auto perturb = [&]( const T amount ) {
+      withLayer( layerNum, [&]( auto& layer ) { layer.perturbWeight( weightNum, amount ); } );
+      derived().apply( input );
+    };
+
+    // f(X+epsilon)
+    perturb( epsilon );
+    const auto fXPlusEpsilon = derived().output();
+
+    // f(X-epsilon)
+    perturb( -2 * epsilon );
+    const auto fXMinusEpsilon = derived().output();
+
+    // f(X) restore network to original state
+    perturb( epsilon );
+
+    return ( ( fXPlusEpsilon - fXMinusEpsilon ) / ( 2 * epsilon ) ).sum() / fXPlusEpsilon.rows();
+  }
+
+  /* discard the accumulated gradients of every layer */
+  void zeroGradients()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.zeroGradients(); } );
+  }
+
+  /* step every layer by the mean of its accumulated gradients, and start a new sum */
+  void applyAccumulated( T epsilon )
+  {
+    derived().forEachLayer( [&]( auto& layer ) { layer.applyAccumulated( epsilon ); } );
+  }
+
+  /*
+   * Function Name: tryStep
+   * Description: This function steps every layer like modifyParamWholeLayer,
+   *              keeping the parameters from before the step saved so that
+   *              rollback() can return to them without a copy (see Layer).
+   * Parameters:
+   *			1. epsilon is the constant to be multiplied to the gradients
+   */
+  void tryStep( T epsilon )
+  {
+    derived().forEachLayer( [&]( auto& layer ) { layer.tryStep( epsilon ); } );
+  }
+
+  /* save the live parameters of every layer (one copy of the parameters) */
+  void snapshot()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.snapshot(); } );
+  }
+
+  /* return every layer to the parameters saved by tryStep or snapshot (no copy) */
+  void rollback()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.rollback(); } );
+  }
+
+  /* return every layer to the saved parameters, putting the trial step aside for unshelve (no copy) */
+  void shelve()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.shelve(); } );
+  }
+
+  /* keep the trial step every layer put aside with shelve (no copy) */
+  void unshelve()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.unshelve(); } );
+  }
+
+  /* keep the live parameters of every layer (no copy) */
+  void commit()
+  {
+    derived().forEachLayer( []( auto& layer ) { layer.commit(); } );
+  }
+
+  /* allocate every layer's other parameter sets from the arena holding the network (see Layer) */
+  void placeTrialSetsIn( ParameterArena& arena )
+  {
+    derived().forEachLayer( [&]( auto& layer ) { layer.placeTrialSetsIn( arena ); } );
+  }
+};
@@ -0,0 +1,398 @@
+/**
+ * File name: lookup_table.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "activation.hh"
+#include "eigen.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/* settings for LookupTable::compile and checkLookupTable */
+struct LookupTableOptions
+{
+  // max allowable |table - network| when merging segments, and at the probes of sampled segments
+  double tolerance = 1e-4;
+  // sampling does not split segments narrower than this fraction of the domain
+  double min_width = 1e-7;
+  // uniform segments sampling starts from, so that narrow features are not stepped over
+  unsigned int initial_segments = 64;
+  // points, spread uniformly over the domain, where checkLookupTable compares the table with the network
+  unsigned int check_points = 100000;
+};
+
+struct LookupTableReport
+{
+  uint64_t segments {};
+  // built from the breakpoints of a piecewise-linear (ReLU, LeakyReLU) network, rather than by sampling
+  bool exact {};
+  uint64_t points_checked {};
+  double max_abs_error {};
+  double mean_abs_error {};
+  // relative to |network output|, where that is at least 1e-6
+  double max_rel_error {};
+  double worst_input {};
+
+  void summary( std::ostream& out ) const
+  {
+    out << "segments: " << segments << ( exact ? " (from ReLU breakpoints)" : " (sampled)" ) << "\n";
+    out << "points checked: " << points_checked << "\n";
+    out << "max abs error: " << max_abs_error << " (at input " << worst_input << ")\n";
+    out << "mean abs error: " << mean_abs_error << "\n";
+    out << "max rel error: " << max_rel_error << "\n";
+  }
+};
+
+namespace lookup_table {
+
+template<class Act>
+constexpr bool is_piecewise_linear
+  = std::is_same_v<Act, activation::ReLU> or std::is_same_v<Act, activation::LeakyReLU>;
+
+/* a 1-input network's parameters in double precision, to compile it without the rounding of its own type */
+template<class Act>
+class Reference
+{
+  std::vector<Eigen::MatrixXd> weights_ {};
+  std::vector<Eigen::RowVectorXd> biases_ {};
+
+public:
+  template<class NetworkT>
+  explicit Reference( const NetworkT& nn )
+  {
+    nn.forEachLayer( [&]( const auto& layer ) {
+      weights_.push_back( layer.weights().template cast<double>() );
+      biases_.push_back( layer.biases().template cast<double>() );
+    } );
+    if ( weights_.front().rows() != 1 or weights_.back().cols() != 1 ) {
+      throw std::runtime_error( "LookupTable: the network must have one input and one output" );
+    }
+  }
+
+  size_t num_layers() const { return weights_.size(); }
+
+  /* the pre-activations of layer `layer` at each of xs (the outputs, for the last layer) */
+  Eigen::MatrixXd preActivations( const std::vector<double>& xs, const size_t layer ) const
+  {
+    Eigen::MatrixXd a = Eigen::Map<const Eigen::VectorXd>( xs.data(), xs.size() );
+    for ( size_t l = 0; l < layer; l++ ) {
+      Eigen::MatrixXd z = a * weights_[l];
+      z.rowwise() += biases_[l];
+      a = Act::forward( z.array() ).matrix();
+    }
+    Eigen::MatrixXd z = a * weights_[layer];
+    z.rowwise() += biases_[layer];
+    return z;
+  }
+
+  std::vector<double> outputs( const std::vector<double>& xs ) const
+  {
+    const Eigen::MatrixXd z = preActivations( xs, num_layers() - 1 );
+    return { z.data(), z.data() + z.size() };
+  }
+};
+
+}
+
+/*
+ * Class Name: LookupTable
+ * Description: A piecewise-linear function of one input, compiled from a
+ *              trained 1-input, 1-output network over a bounded domain
+ *              [lo, hi], to stand in for it at inference.
+ *
+ *              A network with ReLU or LeakyReLU hidden layers is itself
+ *              piecewise linear in its input, with a breakpoint wherever a
+ *              neuron's pre-activation changes sign. compile finds them
+ *              layer by layer: between two breakpoints of the layers before,
+ *              each pre-activation of the next layer is affine, so its zero
+ *              is found exactly. The table then matches the network up to
+ *              rounding. Segments are merged while the merged chord stays
+ *              within options.tolerance of the network at every breakpoint.
+ *
+ *              With a smooth activation (GELU) the segments are found by
+ *              sampling instead: a segment is split in two until the network
+ *              is within options.tolerance of its chord at three probes.
+ *
+ *              Evaluation finds the segment from a uniform bucket index over
+ *              the domain (about two buckets per segment, so usually no
+ *              search) and computes one multiply-add. Inputs outside the
+ *              domain use the first or last segment (linear extrapolation).
+ *
+ * Example: the 1->480->480->1 seconds/beat -> bpm network of
+ *          compose_tempo.cc, over 0.25 .. 2 s, becomes a table of a few
+ *          hundred segments (see compile_lookup_table.cc).
+ */
+template<class T>
+class LookupTable
+{
+  T lo_ {}, hi_ {};
+  T bucket_scale_ {};
+  // segment i covers inputs up to ends_[i]; the last end is a sentinel
+  std::vector<T> ends_ {};
+  std::vector<T> slopes_ {};
+  std::vector<T> intercepts_ {};
+  // first segment reaching into each bucket
+  std::vector<uint32_t> buckets_ {};
+  bool exact_ {};
+
+  /* merge consecutive segments while the chord stays within tolerance of every breakpoint it spans */
+  static void simplify( std::vector<double>& xs, std::vector<double>& ys, const double tolerance )
+  {
+    std::vector<double> kept_xs { xs.front() }, kept_ys { ys.front() };
+    size_t anchor = 0;
+    for ( size_t end = 2; end < xs.size(); end++ ) {
+      const double slope = ( ys[end] - ys[anchor] ) / ( xs[end] - xs[anchor] );
+      for ( size_t j = anchor + 1; j < end; j++ ) {
+        if ( std::abs( ys[anchor] + slope * ( xs[j] - xs[anchor] ) - ys[j] ) > tolerance ) {
+          anchor = end - 1;
+          kept_xs.push_back( xs[anchor] );
+          kept_ys.push_back( ys[anchor] );
+          break;
+        }
+      }
+    }
+    kept_xs.push_back( xs.back() );
+    kept_ys.push_back( ys.back() );
+    xs = std::move( kept_xs );
+    ys = std::move( kept_ys );
+  }
+
+  /* the breakpoints of a piecewise-linear network over [lo, hi] */
+  template<class Act>
+  static std::vector<double> breakpoints( const lookup_table::Reference<Act>& reference,
+                                          const double lo,
+                                          const double hi )
+  {
+    const double merge_width = ( hi - lo ) * 1e-12;
+    std::vector<double> xs { lo, hi };
+    for ( size_t layer = 0; layer + 1 < reference.num_layers(); layer++ ) {
+      const Eigen::MatrixXd z = reference.preActivations( xs, layer );
+      std::vector<double> next = xs;
+      for ( size_t i = 0; i + 1 < xs.size(); i++ ) {
+        for ( Eigen::Index n = 0; n < z.cols(); n++ ) {
+          const double z0 = z( i, n ), z1 = z( i + 1, n );
+          if ( ( z0 < 0 ) != ( z1 < 0 ) and z0 != z1 ) {
+            const double root = xs[i] + ( xs[i + 1] - xs[i] ) * z0 / ( z0 - z1 );
+            if ( root > xs[i] + merge_width and root < xs[i + 1] - merge_width ) {
+              next.push_back( root );
+            }
+          }
+        }
+      }
+      std::sort( next.begin(), next.end() );
+      next.erase( std::unique( next.begin(),
+                               next.end(),
+                               [&]( const double a, const double b ) { return b - a <= merge_width; } ),
+                  next.end() );
+      xs = std::move( next );
+    }
+    return xs;
+  }
+
+  /* split [xs.back(), q] until the network is within tolerance of each chord at its probes */
+  template<class Act>
+  static void sample( const lookup_table::Reference<Act>& reference,
+                      const double q,
+                      const double yq,
+                      const double min_width,
+                      const double tolerance,
+                      std::vector<double>& xs,
+                      std::vector<double>& ys )
+  {
+    const double p = xs.back(), yp = ys.back();
+    const std::vector<double> probes { p + ( q - p ) / 4, p + ( q - p ) / 2, p + 3 * ( q - p ) / 4 };
+    const std::vector<double> values = reference.outputs( probes );
+    bool accepted = q - p < min_width;
+    if ( not accepted ) {
+      accepted = true;
+      for ( size_t i = 0; i < probes.size(); i++ ) {
+        accepted = accepted and std::abs( yp + ( yq - yp ) * ( probes[i] - p ) / ( q - p ) - values[i] ) <= tolerance;
+      }
+    }
+
+    if ( accepted ) {
+      xs.push_back( q );
+      ys.push_back( yq );
+    } else {
+      sample( reference, probes[1], values[1], min_width, tolerance, xs, ys );
+      sample( reference, q, yq, min_width, tolerance, xs, ys );
+    }
+  }
+
+  void build( const std::vector<double>& xs, const std::vector<double>& ys )
+  {
+    const size_t num_segments = xs.size() - 1;
+    ends_.clear();
+    slopes_.clear();
+    intercepts_.clear();
+    for ( size_t i = 0; i < num_segments; i++ ) {
+      const double slope = ( ys[i + 1] - ys[i] ) / ( xs[i + 1] - xs[i] );
+      ends_.push_back( i + 1 < num_segments ? T( xs[i + 1] ) : std::numeric_limits<T>::max() );
+      slopes_.push_back( slope );
+      intercepts_.push_back( ys[i] - slope * xs[i] );
+    }
+
+    buckets_.resize( 2 * num_segments );
+    bucket_scale_ = buckets_.size() / ( hi_ - lo_ );
+    uint32_t segment = 0;
+    for ( size_t k = 0; k < buckets_.size(); k++ ) {
+      const T start = lo_ + k / bucket_scale_;
+      while ( start > ends_[segment] ) {
+        segment++;
+      }
+      buckets_[k] = segment;
+    }
+  }
+
+public:
+  LookupTable() {}
+
+  /*
+   * Function Name: compile
+   * Description: This function compiles a trained network into a table over
+   *              [lo, hi].
+   * Parameters:
+   *			1. Act is the hidden activation the network runs with
+   *			   (apply<Act>): activation::ReLU, activation::LeakyReLU or
+   *			   activation::GELU
+   *			2. nn is a Network with one input and one output
+   *			3. lo and hi bound the domain
+   *			4. options sets the tolerance (see LookupTableOptions)
+   */
+  template<class Act, class NetworkT>
+  static LookupTable compile( const NetworkT& nn, const T lo, const T hi, const LookupTableOptions& options = {} )
+  {
+    if ( not( lo < hi ) ) {
+      throw std::runtime_error( "LookupTable: empty domain" );
+    }
+
+    const lookup_table::Reference<Act> reference { nn };
+    LookupTable table;
+    table.lo_ = lo;
+    table.hi_ = hi;
+    table.exact_ = lookup_table::is_piecewise_linear<Act>;
+
+    std::vector<double> xs, ys;
+    if constexpr ( lookup_table::is_piecewise_linear<Act> ) {
+      xs = breakpoints( reference, lo, hi );
+      ys = reference.outputs( xs );
+      simplify( xs, ys, options.tolerance );
+    } else {
+      std::vector<double> grid;
+      for ( unsigned int i = 0; i <= options.initial_segments; i++ ) {
+        grid.push_back( lo + ( double( hi ) - lo ) * i / options.initial_segments );
+      }
+      const std::vector<double> values = reference.outputs( grid );
+      xs = { grid.front() };
+      ys = { values.front() };
+      for ( size_t i = 1; i < grid.size(); i++ ) {
+        sample( reference, grid[i], values[i], options.min_width * ( hi - lo ), options.tolerance, xs, ys );
+      }
+    }
+
+    table.build( xs, ys );
+    return table;
+  }
+
+  T operator()( const T x ) const
+  {
+    const T u = ( x - lo_ ) * bucket_scale_;
+    /* clamp before converting: a float too large for size_t (or infinite) makes the conversion undefined */
+    const size_t last = buckets_.size() - 1;
+    const size_t k = u > 0 ? ( u >= T( last ) ? last : size_t( u ) ) : 0;
+    uint32_t i = buckets_[k];
+    while ( x > ends_[i] ) {
+      i++;
+    }
+    return slopes_[i] * x + intercepts_[i];
+  }
+
+  /*
+   * Function Name: apply_into
+   * Description: This function evaluates the table at every coefficient of
+   *              input, and writes the results to the matching coefficients
+   *              of out (as Network::apply_into, for a batch of inputs).
+   */
+  template<class Input, class Out>
+  void apply_into( const Eigen::MatrixBase<Input>& input, const Eigen::MatrixBase<Out>& out ) const
+  {
+    Eigen::MatrixBase<Out>& result = const_cast<Eigen::MatrixBase<Out>&>( out );
+    for ( Eigen::Index j = 0; j < input.cols(); j++ ) {
+      for ( Eigen::Index i = 0; i < input.rows(); i++ ) {
+        result( i, j ) = ( *this )( input( i, j ) );
+      }
+    }
+  }
+
+  T lo() const { return lo_; }
+  T hi() const { return hi_; }
+  size_t segments() const { return slopes_.size(); }
+
+  T segmentMiddle( const size_t i ) const
+  {
+    const T start = i > 0 ? ends_[i - 1] : lo_;
+    const T end = i + 1 < ends_.size() ? ends_[i] : hi_;
+    return ( start + end ) / 2;
+  }
+  bool exact() const { return exact_; }
+};
+
+/*
+ * Function Name: checkLookupTable
+ * Description: This function compares a table with the network it was
+ *              compiled from, run as usual (in its own type, with Act), at
+ *              options.check_points inputs spread uniformly over the domain
+ *              and at the middle of every segment.
+ */
+template<class Act, class T, class NetworkT>
+LookupTableReport checkLookupTable( const LookupTable<T>& table,
+                                    NetworkT& nn,
+                                    const LookupTableOptions& options = {} )
+{
+  using Output = std::decay_t<decltype( nn.output() )>;
+  constexpr Eigen::Index batch_size = Output::RowsAtCompileTime;
+
+  std::vector<T> inputs;
+  for ( unsigned int i = 0; i < options.check_points; i++ ) {
+    inputs.push_back( table.lo() + ( table.hi() - table.lo() ) * ( i + T( 0.5 ) ) / options.check_points );
+  }
+  for ( size_t i = 0; i < table.segments(); i++ ) {
+    inputs.push_back( table.segmentMiddle( i ) );
+  }
+
+  LookupTableReport report;
+  report.segments = table.segments();
+  report.exact = table.exact();
+  Eigen::Matrix<T, batch_size, 1> batch;
+  for ( size_t first = 0; first < inputs.size(); first += batch_size ) {
+    const size_t count = std::min<size_t>( batch_size, inputs.size() - first );
+    for ( size_t i = 0; i < size_t( batch_size ); i++ ) {
+      batch( i ) = inputs[first + std::min( i, count - 1 )];
+    }
+    nn.template apply<Act>( batch );
+    for ( size_t i = 0; i < count; i++ ) {
+      const double expected = nn.output()( i, 0 );
+      const double error = std::abs( table( batch( i ) ) - expected );
+      report.points_checked++;
+      report.mean_abs_error += error;
+      if ( error > report.max_abs_error ) {
+        report.max_abs_error = error;
+        report.worst_input = batch( i );
+      }
+      if ( std::abs( expected ) >= 1e-6 ) {
+        report.max_rel_error = std::max( report.max_rel_error, error / std::abs( expected ) );
+      }
+    }
+  }
+  report.mean_abs_error /= std::max<uint64_t>( report.points_checked, 1 );
+  return report;
+}
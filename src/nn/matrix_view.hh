@@ -0,0 +1,70 @@
+/**
+ * File name: matrix_view.hh
+ * Last Update: October 2026
+ * Description: Eigen views of caller memory, for feeding a network without
+ *              copying its input into a Matrix first (and for receiving its
+ *              output the same way, with apply_into).
+ *
+ *              Every network's apply (Layer, Network, NeuralNetwork,
+ *              SequentialNetwork, MappedNetwork) accepts any Eigen matrix
+ *              expression of the right shape: a Matrix, a block of one, an
+ *              Eigen::Map or an Eigen::Ref. The views here map a span of
+ *              elements (e.g. from a TypedRingBuffer's readable_region() or an
+ *              EndlessBuffer's region()) as a batch_size x input_size matrix,
+ *              one row per batch entry, which is how such buffers lay out
+ *              consecutive samples.
+ */
+
+#pragma once
+
+#include "eigen.hh"
+#include "spans.hh"
+
+#include <stdexcept>
+#include <string>
+
+/* row-major, except for a single column (which Eigen requires to be column-major; the layout is the same) */
+template<unsigned int rows, unsigned int cols>
+constexpr int view_storage_order = ( cols == 1 and rows != 1 ) ? Eigen::ColMajor : Eigen::RowMajor;
+
+template<class T, unsigned int rows, unsigned int cols>
+using ConstMatrixView = Eigen::Map<const Eigen::Matrix<T, rows, cols, view_storage_order<rows, cols>>>;
+
+template<class T, unsigned int rows, unsigned int cols>
+using MatrixView = Eigen::Map<Eigen::Matrix<T, rows, cols, view_storage_order<rows, cols>>>;
+
+namespace matrix_view {
+
+template<unsigned int rows, unsigned int cols>
+void check_size( const size_t size )
+{
+  if ( size != rows * cols ) {
+    throw std::runtime_error( "matrix view of " + std::to_string( size ) + " elements as " + std::to_string( rows )
+                              + "x" + std::to_string( cols ) );
+  }
+}
+
+}
+
+/*
+ * Function Name: as_matrix
+ * Description: This function views rows * cols elements as a rows x cols
+ *              matrix (row by row), without copying them.
+ *              It throws if the span holds a different number of elements.
+ * Parameters:
+ *			1. elements is the memory to view, which must outlive the view
+ */
+template<unsigned int rows, unsigned int cols, class T>
+ConstMatrixView<T, rows, cols> as_matrix( const span_view<T> elements )
+{
+  matrix_view::check_size<rows, cols>( elements.size() );
+  return ConstMatrixView<T, rows, cols>( elements.data() );
+}
+
+/* same as above, but writable (e.g. as the output of apply_into) */
+template<unsigned int rows, unsigned int cols, class T>
+MatrixView<T, rows, cols> as_mutable_matrix( span<T> elements )
+{
+  matrix_view::check_size<rows, cols>( elements.size() );
+  return MatrixView<T, rows, cols>( elements.mutable_data() );
+}
@@ -4,9 +4,11 @@
  */
 #pragma once
 
+#include "arena.hh"
+#include "eigen.hh"
 #include "network.hh"
 
-#include <Eigen/Dense>
+#include <memory>
 #include <regex>
 #include <iostream>
 #include <fstream>
@@ -35,8 +37,28 @@ class NeuralNetwork
 {
 
 private:
+  using NetworkType = Network<T, batch_size, input_size, rest...>;
+
   float learning_rate = 0.001;
 
+  // when set, nn lives in this arena (on huge pages) instead of on the heap
+  std::unique_ptr<ParameterArena> arena_ {};
+
+  void allocate_network()
+  {
+    if ( not arena_ ) {
+      delete nn;
+      nn = new NetworkType();
+    } else {
+      if ( nn ) {
+        nn->~NetworkType();
+        arena_->clear();
+      }
+      nn = arena_->make<NetworkType>();
+      nn->placeTrialSetsIn( *arena_ );
+    }
+  }
+
   float compute_pd_loss_wrt_output( const float target, const float actual ) { return -2 * ( target - actual ); }
 
   float loss_function( const float target, const float actual )
@@ -56,6 +78,30 @@ private:
 public:
   Network<T, batch_size, input_size, rest...>* nn {};
 
+  NeuralNetwork() {}
+
+  /* with huge_pages set, initialize() places the whole Network, and the parameter sets of its trial steps, in a
+     ParameterArena on 2 MB pages */
+  explicit NeuralNetwork( const bool huge_pages )
+    : arena_( huge_pages ? std::make_unique<ParameterArena>( sizeof( NetworkType ) + NetworkType::trial_set_bytes )
+                         : nullptr )
+  {}
+
+  ~NeuralNetwork()
+  {
+    if ( arena_ ) {
+      if ( nn ) {
+        nn->~NetworkType();
+      }
+    } else {
+      delete nn;
+    }
+  }
+
+  /* owns nn, so disallow copying */
+  NeuralNetwork( const NeuralNetwork& other ) = delete;
+  NeuralNetwork& operator=( const NeuralNetwork& other ) = delete;
+
   // getters
   unsigned int get_num_of_layers() { return num_of_layers; }
 
@@ -65,6 +111,9 @@ public:
 
   float get_current_learning_rate() { return learning_rate; }
 
+  // the arena holding nn, or nullptr if nn is on the heap
+  const ParameterArena* arena() const { return arena_.get(); }
+
   const Matrix<T, batch_size, output_size>& get_output() { return nn->output(); }
 
   /*
@@ -78,11 +127,27 @@ public:
    */
   void initialize( float eta = 0.001 )
   {
-    nn = new Network<T, batch_size, input_size, rest...>();
+    allocate_network();
     nn->initializeWeightsRandomly();
     learning_rate = eta;
   }
 
+  /*
+   * Function Name: initialize
+   * Description: Same as above, but draws the initial parameters from the
+   *              caller's generator (see Layer::initializeWeightsRandomly).
+   * Parameters:
+   *			1. eta is the user-initialized learning rate
+   *			2. rng is a standard uniform random bit generator
+   */
+  template<class RNG>
+  void initialize( float eta, RNG& rng )
+  {
+    allocate_network();
+    nn->initializeWeightsRandomly( rng );
+    learning_rate = eta;
+  }
+
   /*
    * Function Name: init_params
    * Description: This function assigns the parameters including weights and
@@ -232,11 +297,27 @@ public:
    * Function Name: apply
    * Description: This function applys the user input to the neural network.
    * Parameters:
-   *			1. input is the input to the neural network
+   *			1. input is the input to the neural network: a Matrix, or a
+   *			   Map/Ref over the caller's memory (see matrix_view.hh)
    */
-  void apply( const Matrix<T, batch_size, input_size>& input ) { nn->apply( input ); }
-  
-  void apply_leaky( const Matrix<T, batch_size, input_size>& input ) { nn->apply_leaky( input ); }
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    nn->apply( input );
+  }
+
+  template<class Input>
+  void apply_leaky( const MatrixBase<Input>& input )
+  {
+    nn->apply_leaky( input );
+  }
+
+  /* apply, writing the output into out instead of get_output() (inference only, see Network) */
+  template<class Input, class Out>
+  void apply_into( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
+  {
+    nn->apply_into( input, out );
+  }
 
   /*
    * Function Name: gradient_descent
@@ -277,49 +358,46 @@ public:
         current_loss += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
       }
 
-      // 4/3 learning rate
-      float lr_4_3 = 4.0 / 3 * learning_rate;
-      // modifying weights and biases
-      for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-        nn->modifyParamWholeLayer( i, lr_4_3 * pd_loss_wrt_output );
-      }
-      // compute loss
-      nn->apply( input );
-      float loss_4_3 = 0;
-      for ( int i = 0; i < (int)output_size; i++ ) {
-        loss_4_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
-      }
+      // each trial step starts from the current parameters, which stay saved
+      // in another parameter set of the layers and come back bit-exact on
+      // rollback; the 2/3 step is shelved in a third set while the 4/3 step
+      // is tried, so whichever wins is kept without another sweep
 
       // 2/3 learning rate
       float lr_2_3 = 2.0 / 3 * learning_rate;
-      // modifying weights and biases
-      for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-        nn->modifyParamWholeLayer( i, ( -lr_4_3 + lr_2_3 ) * pd_loss_wrt_output );
-      }
+      nn->tryStep( lr_2_3 * pd_loss_wrt_output );
       // compute loss
       nn->apply( input );
       float loss_2_3 = 0;
       for ( int i = 0; i < (int)output_size; i++ ) {
         loss_2_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
       }
+      nn->shelve();
+
+      // 4/3 learning rate
+      float lr_4_3 = 4.0 / 3 * learning_rate;
+      nn->tryStep( lr_4_3 * pd_loss_wrt_output );
+      // compute loss
+      nn->apply( input );
+      float loss_4_3 = 0;
+      for ( int i = 0; i < (int)output_size; i++ ) {
+        loss_4_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
+      }
 
       float min_loss = min( min( current_loss, loss_4_3 ), loss_2_3 );
       if ( min_loss == current_loss ) {
         //  update learning rate
         learning_rate = lr_2_3;
-        // update params
-        for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-          nn->modifyParamWholeLayer( i, -lr_2_3 * pd_loss_wrt_output );
-        }
+        // back to the current params
+        nn->rollback();
       } else if ( min_loss == loss_4_3 ) {
         //  update learning rate
         learning_rate = lr_4_3;
-        // update params
-        for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-          nn->modifyParamWholeLayer( i, ( -lr_2_3 + lr_4_3 ) * pd_loss_wrt_output );
-        }
+        // keep the 4/3 step
+        nn->commit();
       } else {
-        //  no need
+        // keep the shelved 2/3 step
+        nn->unshelve();
       }
     }
   }
@@ -334,14 +412,15 @@ public:
     nn->evaluateGradients( input );
 
     if ( !dynamic ) {
-      Matrix<float, batch_size, output_size> pd_loss_wrt_output;
-      // assuming batch_size = 1
+      // the deltas are seeded with ones on every output, so the loss gradient is
+      // the sum of the per-output partial derivatives (assuming batch_size = 1)
+      float pd_loss_wrt_output = 0;
       for ( int i = 0; i < (int)output_size; i++ ) {
-        pd_loss_wrt_output(0, i) = compute_pd_loss_wrt_output( ground_truth_output( 0, i ), nn->output()( 0, i ) );
+        pd_loss_wrt_output += compute_pd_loss_wrt_output( ground_truth_output( 0, i ), nn->output()( 0, i ) );
       }
 
       for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-        nn->modifyParamWholeLayer( i, learning_rate * pd_loss_wrt_output(0, i) );
+        nn->modifyParamWholeLayer( i, learning_rate * pd_loss_wrt_output );
       }
       if(print_loss)
       {
@@ -350,9 +429,9 @@ public:
     } else {
       // original
       float current_loss = 0;
-      Matrix<float, batch_size, output_size> pd_loss_wrt_output;
+      float pd_loss_wrt_output = 0;
       for ( int i = 0; i < (int)output_size; i++ ) {
-        pd_loss_wrt_output(0, i) = compute_pd_loss_wrt_output( ground_truth_output( 0, i ), nn->output()( 0, i ) );
+        pd_loss_wrt_output += compute_pd_loss_wrt_output( ground_truth_output( 0, i ), nn->output()( 0, i ) );
         current_loss += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
         if(print_loss)
         {
@@ -361,31 +440,31 @@ public:
         }
       }
 
-      // 4/3 learning rate
-      float lr_4_3 = 4.0 / 3 * learning_rate;
-      // modifying weights and biases
-      for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-        nn->modifyParamWholeLayer( i, lr_4_3 * pd_loss_wrt_output(0, i) );
-      }
-      // compute loss
-      nn->apply_leaky( input );
-      float loss_4_3 = 0;
-      for ( int i = 0; i < (int)output_size; i++ ) {
-        loss_4_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
-      }
+      // each trial step starts from the current parameters, which stay saved
+      // in another parameter set of the layers and come back bit-exact on
+      // rollback; the 2/3 step is shelved in a third set while the 4/3 step
+      // is tried, so whichever wins is kept without another sweep
 
       // 2/3 learning rate
       float lr_2_3 = 2.0 / 3 * learning_rate;
-      // modifying weights and biases
-      for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-        nn->modifyParamWholeLayer( i, ( -lr_4_3 + lr_2_3 ) * pd_loss_wrt_output(0, i) );
-      }
+      nn->tryStep( lr_2_3 * pd_loss_wrt_output );
       // compute loss
       nn->apply_leaky( input );
       float loss_2_3 = 0;
       for ( int i = 0; i < (int)output_size; i++ ) {
         loss_2_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
       }
+      nn->shelve();
+
+      // 4/3 learning rate
+      float lr_4_3 = 4.0 / 3 * learning_rate;
+      nn->tryStep( lr_4_3 * pd_loss_wrt_output );
+      // compute loss
+      nn->apply_leaky( input );
+      float loss_4_3 = 0;
+      for ( int i = 0; i < (int)output_size; i++ ) {
+        loss_4_3 += loss_function( ground_truth_output( 0, i ), nn->output()( 0, i ) );
+      }
 
       float min_loss = min( min( current_loss, loss_4_3 ), loss_2_3 );
       if(print_loss)
@@ -395,19 +474,16 @@ public:
       if ( min_loss == current_loss ) {
         //  update learning rate
         learning_rate = lr_2_3;
-        // update params
-        for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-          nn->modifyParamWholeLayer( i, -lr_2_3 * pd_loss_wrt_output(0, i) );
-        }
+        // back to the current params
+        nn->rollback();
       } else if ( min_loss == loss_4_3 ) {
         //  update learning rate
         learning_rate = lr_4_3;
-        // update params
-        for ( int i = 0; i < (int)nn->getNumLayers(); i++ ) {
-          nn->modifyParamWholeLayer( i, ( -lr_2_3 + lr_4_3 ) * pd_loss_wrt_output(0, i) );
-        }
+        // keep the 4/3 step
+        nn->commit();
       } else {
-        //  no need
+        // keep the shelved 2/3 step
+        nn->unshelve();
       }
     }
   }
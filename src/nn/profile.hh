@@ -0,0 +1,219 @@
+/**
+ * File name: profile.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "perf_counters.hh"
+#include "summarize.hh"
+#include "timer.hh"
+
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* per-layer timing is compiled in only when NN_PROFILE is defined (cmake -DNN_PROFILE=ON) */
+#ifdef NN_PROFILE
+constexpr bool nn_profiling_enabled = true;
+#else
+constexpr bool nn_profiling_enabled = false;
+#endif
+
+/* with NN_PERF_COUNTERS also defined (cmake -DNN_PERF_COUNTERS=ON), each timed phase also counts hardware events */
+#ifdef NN_PERF_COUNTERS
+constexpr bool nn_perf_counters_enabled = nn_profiling_enabled;
+#else
+constexpr bool nn_perf_counters_enabled = false;
+#endif
+
+/*
+ * Class Name: PhaseRecord
+ * Description: The timing record of one phase of a Layer, plus the hardware
+ *              counts of the same calls when nn_perf_counters_enabled.
+ */
+struct PhaseRecord : Timer::Record
+{
+  PerfCounters::Record counters {};
+
+  void reset()
+  {
+    Timer::Record::reset();
+    counters.reset();
+  }
+};
+
+/*
+ * Class Name: PhaseScope
+ * Description: Times a scope into a PhaseRecord and, if counted, reads the
+ *              calling thread's hardware counters around it. The counter
+ *              reads are outside the timed interval, so they do not inflate
+ *              the times. Work handed to other threads (e.g. the layer
+ *              thread pool) is timed but not counted.
+ */
+template<bool counted>
+class PhaseScope
+{
+  RecordOnlyScopeTimer timer_;
+
+public:
+  explicit PhaseScope( PhaseRecord& record )
+    : timer_( record )
+  {}
+};
+
+template<>
+class PhaseScope<true>
+{
+  PerfScopeCounter counter_;
+  RecordOnlyScopeTimer timer_;
+
+public:
+  explicit PhaseScope( PhaseRecord& record )
+    : counter_( thread_perf_counters(), record.counters )
+    , timer_( record )
+  {}
+};
+
+/*
+ * Class Name: BasicLayerTimings
+ * Description: The timing records kept by every Layer, one per phase of a
+ *              training step. Layer methods open a Scope on the matching
+ *              record.
+ *              With profiling disabled the records and scopes are empty, so
+ *              the instrumentation compiles away.
+ */
+template<bool enabled>
+struct BasicLayerTimings;
+
+template<>
+struct BasicLayerTimings<true>
+{
+  using Record = PhaseRecord;
+  using Scope = PhaseScope<nn_perf_counters_enabled>;
+
+  Record apply {};
+  Record computeDeltas {};
+  Record evaluateGradients {};
+  Record update {};
+
+  void reset()
+  {
+    apply.reset();
+    computeDeltas.reset();
+    evaluateGradients.reset();
+    update.reset();
+  }
+};
+
+template<>
+struct BasicLayerTimings<false>
+{
+  struct Record
+  {};
+
+  struct Scope
+  {
+    Scope( Record& ) {}
+  };
+
+  Record apply {};
+  Record computeDeltas {};
+  Record evaluateGradients {};
+  Record update {};
+
+  void reset() {}
+};
+
+using LayerTimings = BasicLayerTimings<nn_profiling_enabled>;
+
+/*
+ * Class Name: NetworkProfile
+ * Description: Summarizable report of the per-layer timings of a Network (or
+ *              anything else with forEachLayer), listing for every layer and
+ *              phase its share of the total time spent in layers, and the
+ *              mean, min and max duration of one call (and, with
+ *              NN_PERF_COUNTERS, the hardware counts per call).
+ */
+template<class NetworkT>
+class NetworkProfile : public Summarizable
+{
+  NetworkT& network_;
+
+  static void print_record( std::ostream& out, const char* name, const Timer::Record& record, const uint64_t total )
+  {
+    out << "   " << name << ": " << std::string( 20 - strlen( name ), ' ' );
+    out << std::fixed << std::setw( 5 ) << std::setprecision( 1 ) << 100 * record.total_ns / double( total ) << "%";
+
+    if ( record.count > 0 ) {
+      out << "   [mean=";
+      Timer::pp_ns( out, record.total_ns / record.count );
+      out << "] [min=";
+      Timer::pp_ns( out, record.min_ns );
+      out << "] [max=";
+      Timer::pp_ns( out, record.max_ns );
+      out << "]";
+      record.print_percentiles( out );
+    }
+
+    out << " [count=" << record.count << "]\n";
+  }
+
+public:
+  explicit NetworkProfile( NetworkT& network )
+    : network_( network )
+  {}
+
+  void summary( std::ostream& out ) const override
+  {
+    out << "Per-layer timing summary\n------------------------\n\n";
+
+    if constexpr ( not nn_profiling_enabled ) {
+      out << "Per-layer profiling is disabled (build with -DNN_PROFILE=ON).\n";
+    } else {
+      uint64_t total = 0;
+      network_.forEachLayer( [&]( const auto& layer ) {
+        const auto& t = layer.timings();
+        total += t.apply.total_ns + t.computeDeltas.total_ns + t.evaluateGradients.total_ns + t.update.total_ns;
+      } );
+
+      out << "Total time in layers: ";
+      Timer::pp_ns( out, total );
+      out << "\n";
+
+      total = std::max<uint64_t>( total, 1 );
+      unsigned int layer_num = 0;
+      network_.forEachLayer( [&]( const auto& layer ) {
+        const auto& t = layer.timings();
+        out << "\nLayer " << layer_num++ << " (" << layer.getInputSize() << " -> " << layer.getOutputSize() << ")\n";
+        print_record( out, "apply", t.apply, total );
+        print_record( out, "computeDeltas", t.computeDeltas, total );
+        print_record( out, "evaluateGradients", t.evaluateGradients, total );
+        print_record( out, "update", t.update, total );
+      } );
+
+      if constexpr ( nn_perf_counters_enabled ) {
+        std::vector<std::pair<std::string, std::reference_wrapper<const PerfCounters::Record>>> counted;
+        layer_num = 0;
+        network_.forEachLayer( [&]( const auto& layer ) {
+          const auto& t = layer.timings();
+          const std::string prefix = "layer " + std::to_string( layer_num++ ) + " ";
+          counted.emplace_back( prefix + "apply", t.apply.counters );
+          counted.emplace_back( prefix + "computeDeltas", t.computeDeltas.counters );
+          counted.emplace_back( prefix + "evaluateGradients", t.evaluateGradients.counters );
+          counted.emplace_back( prefix + "update", t.update.counters );
+        } );
+        out << "\n";
+        thread_perf_counters().summary( out, counted );
+      }
+    }
+  }
+
+  void reset_summary() override
+  {
+    network_.forEachLayer( []( auto& layer ) { layer.timings().reset(); } );
+  }
+};
@@ -0,0 +1,191 @@
+/**
+ * File name: recurrent_network.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "gru_layer.hh"
+#include "network.hh"
+
+#include <cassert>
+
+/*
+ * Class Name: RecurrentNetwork
+ * Description: A GRULayer followed by a Network read-out of its state (ReLU
+ *              hidden layers, unactivated last layer, as in Network).
+ *
+ *              It can be used in two ways:
+ *              1. Like a Network over a window of window_size events (e.g.
+ *                 the 16 onsets the tempo networks read): apply( window )
+ *                 starts from a zero state, runs the events in order, and
+ *                 reads out the last state. computeDeltas and
+ *                 evaluateGradients then backpropagate through the whole
+ *                 window, so training loops and GradientChecker work
+ *                 unchanged.
+ *              2. Streaming, one event at a time, from a state that
+ *                 summarizes the whole history: apply_streaming( event )
+ *                 costs the same for every event, however long the
+ *                 history. step( event ) does the same but records the
+ *                 step, so the network can also be trained online, with
+ *                 backpropagation truncated to the last window_size events.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the network (usually float)
+ *			2. batch_size specifies the number of independent sequences
+ *			3. window_size specifies the events per window, and the steps
+ *			   kept for backpropagation through time
+ *			4. event_size specifies the size of one event
+ *			5. hidden_size specifies the size of the GRU state
+ *			6. head... specifies the output sizes of the read-out layers
+ *
+ * Example: RecurrentNetwork<float, 1, 16, 1, 32, 16, 1> reads the same
+ *          16-onset window as Network<float, 1, 16, ...>, and can instead
+ *          be fed one onset at a time.
+ */
+template<class T,
+         unsigned int batch_size,
+         unsigned int window_size,
+         unsigned int event_size,
+         unsigned int hidden_size,
+         unsigned int... head>
+class RecurrentNetwork
+{
+public:
+  GRULayer<T, batch_size, event_size, hidden_size, window_size> gru {};
+  Network<T, batch_size, hidden_size, head...> next {};
+
+  constexpr static unsigned int input_size = window_size * event_size;
+  constexpr static unsigned int output_size = decltype( next )::output_size;
+
+  template<class RNG>
+  void initializeWeightsRandomly( RNG& rng )
+  {
+    gru.initializeWeightsRandomly( rng );
+    next.initializeWeightsRandomly( rng );
+  }
+
+  /* start new sequences (streaming) */
+  void resetState() { gru.resetState(); }
+
+  /*
+   * Function Name: apply
+   * Description: This function runs a window of events through the GRU from
+   *              a zero state, and reads out the last state.
+   * Parameters:
+   *			1. input is batch_size x ( window_size * event_size ), the
+   *			   events in order, oldest first
+   */
+  template<class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    gru.resetState();
+    for ( unsigned int t = 0; t < window_size; t++ ) {
+      gru.apply( input.template middleCols<event_size>( t * event_size ) );
+    }
+    next.apply( gru.output() );
+  }
+
+  /* advance the state by one event and read it out, recording the step for training */
+  template<class Event>
+  void step( const MatrixBase<Event>& event )
+  {
+    gru.apply( event );
+    next.apply( gru.output() );
+  }
+
+  /* advance the state by one event and read it out (inference; nothing is recorded) */
+  template<class Event>
+  void apply_streaming( const MatrixBase<Event>& event )
+  {
+    gru.apply_streaming( event );
+    next.apply( gru.output() );
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return next.output(); }
+
+  /* backprop with the derivative of the loss w.r.t. each output being 1 / batch_size */
+  void computeDeltas() { computeDeltas( Matrix<T, batch_size, output_size>::Ones() / batch_size ); }
+
+  /* backprop through the read-out, then through the recorded steps of the GRU (truncated BPTT) */
+  template<class Seed>
+  void computeDeltas( const MatrixBase<Seed>& seed )
+  {
+    next.computeDeltas( seed );
+    gru.computeDeltas( next.inputDeltas() );
+  }
+
+  /* the GRU keeps the inputs it needs, so the window is not read again */
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& )
+  {
+    evaluateGradients();
+  }
+
+  void evaluateGradients()
+  {
+    gru.evaluateGradients();
+    next.evaluateGradients( gru.output() );
+  }
+
+  /* as in Network: add to the gradients summed since the last applyAccumulated */
+  void accumulateGradients()
+  {
+    gru.accumulateGradients();
+    next.accumulateGradients( gru.output() );
+  }
+
+  void zeroGradients()
+  {
+    gru.zeroGradients();
+    next.zeroGradients();
+  }
+
+  void applyAccumulated( T epsilon )
+  {
+    gru.applyAccumulated( epsilon );
+    next.applyAccumulated( epsilon );
+  }
+
+  void print( const unsigned int layerNum = 0 ) const
+  {
+    gru.print( layerNum );
+    next.print( layerNum + 1 );
+  }
+
+  unsigned int getNumLayers() const { return next.getNumLayers() + 1; }
+
+  unsigned int getNumParams( const unsigned int layerNum ) const
+  {
+    return layerNum > 0 ? next.getNumParams( layerNum - 1 ) : gru.getNumParams();
+  }
+
+  T getEvaluatedGradient( const unsigned int layerNum, const unsigned int paramNum )
+  {
+    return layerNum > 0 ? next.getEvaluatedGradient( layerNum - 1, paramNum ) : gru.getEvaluatedGradient( paramNum );
+  }
+
+  void modifyParamWholeLayer( const unsigned int layerNum, T epsilon )
+  {
+    if ( layerNum > 0 ) {
+      next.modifyParamWholeLayer( layerNum - 1, epsilon );
+    } else {
+      gru.modifyParamWholeLayer( epsilon );
+    }
+  }
+
+  /* f is called on the GRULayer, then on every Layer of the read-out */
+  template<class F>
+  void forEachLayer( F&& f )
+  {
+    f( gru );
+    next.forEachLayer( f );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f ) const
+  {
+    f( gru );
+    next.forEachLayer( f );
+  }
+};
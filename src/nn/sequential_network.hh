@@ -0,0 +1,236 @@
+/**
+ * File name: sequential_network.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "layer.hh"
+#include "layer_sequence.hh"
+
+/*
+ * Class Name: FullyConnected
+ * Description: The description of one layer of a SequentialNetwork: its
+ *              sizes and its activation policy (activation.hh).
+ */
+template<unsigned int input_size, unsigned int output_size, class Activation = activation::ReLU>
+struct FullyConnected
+{
+  using activation_type = Activation;
+  constexpr static unsigned int input = input_size;
+  constexpr static unsigned int output = output_size;
+};
+
+/*
+ * Class Name: SequentialNetwork
+ * Description: A recursive class template of layers, each given as a
+ *              FullyConnected with its own activation policy, so a network
+ *              can mix activations (e.g. GELU, then tanh, then an identity
+ *              output). Every layer's forward and backward pass is resolved
+ *              at compile time, and every layer, including the last, applies
+ *              its own activation. Network is the SequentialNetwork of ReLU
+ *              layers with an identity output layer.
+ *              apply<Hidden> and computeDeltas<Hidden> run every layer but
+ *              the last with Hidden instead (e.g. a ReLU network as a
+ *              LeakyReLU one, see Network::apply_leaky).
+ *              The layer-by-layer part of the interface (initialization,
+ *              access by layer number, gradient sums and trial steps) comes
+ *              from LayerSequence.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the network (usually float)
+ *			2. batch_size specifies the size of a batch (usually 1)
+ *			3. L0, rest... are the FullyConnected layers, the output of each
+ *			   being the input of the next
+ *
+ * Example: SequentialNetwork<float, 1, FullyConnected<16, 64, activation::GELU>,
+ *                                      FullyConnected<64, 64, activation::Tanh>,
+ *                                      FullyConnected<64, 1, activation::Identity>>
+ */
+template<class T, unsigned int batch_size, class L0, class... rest>
+class SequentialNetwork : public LayerSequence<SequentialNetwork<T, batch_size, L0, rest...>, T>
+{
+  template<class Hidden>
+  using activation0 = activation::hidden_or_own<Hidden, typename L0::activation_type>;
+
+public:
+  Layer<T, batch_size, L0::input, L0::output, typename L0::activation_type> layer0 {};
+  SequentialNetwork<T, batch_size, rest...> next {};
+
+  static_assert( L0::output == decltype( next )::input_size, "each layer's output must be the next layer's input" );
+
+  constexpr static unsigned int input_size = L0::input;
+  constexpr static unsigned int output_size = decltype( next )::output_size;
+
+  /*
+   * Function Name: apply
+   * Description: This function recursively applies the input to the network.
+   * Parameters:
+   *			1. Hidden, if given, replaces the activation of every layer but
+   *			   the last
+   *			2. input is any batch_size x input_size Eigen expression, e.g.
+   *			   a Map over the caller's memory (matrix_view.hh), read in place
+   */
+  template<class Hidden = activation::Own, class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    layer0.template applyWith<activation0<Hidden>>( input );
+    next.template apply<Hidden>( layer0.output() );
+  }
+
+  /*
+   * Function Name: apply_into
+   * Description: Same as apply, but the last layer writes the network's
+   *              output straight into out (e.g. a Map over the caller's
+   *              buffer) instead of into its own matrix. For inference only:
+   *              output() and computeDeltas do not see this pass.
+   */
+  template<class Hidden = activation::Own, class Input, class Out>
+  void apply_into( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
+  {
+    layer0.template applyWith<activation0<Hidden>>( input );
+    next.template apply_into<Hidden>( layer0.output(), out );
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return next.output(); }
+
+  /*
+   * Function Name: computeDeltas
+   * Description: This function recursively computes the deltas of every
+   *              layer, from the last to the first, with the derivative of
+   *              the loss w.r.t. each output being 1 / batch_size (or the
+   *              given seed, e.g. the inputDeltas() of a network fed by this
+   *              one). Each layer's deltas are written in place, straight
+   *              from the product of the next layer's deltas and weights, so
+   *              the backward pass makes no temporary matrices, and the deltas
+   *              of the input (which training does not need) are not computed.
+   *              Hidden must be the one the last apply ran with.
+   */
+  template<class Hidden = activation::Own>
+  void computeDeltas()
+  {
+    computeDeltas<Hidden>( Matrix<T, batch_size, output_size>::Ones() / batch_size );
+  }
+
+  template<class Hidden = activation::Own, class Seed>
+  void computeDeltas( const MatrixBase<Seed>& seed )
+  {
+    next.template computeDeltas<Hidden>( seed );
+    layer0.template setDeltasFrom<activation0<Hidden>>( next.layer0 );
+  }
+
+  /* the derivatives of the loss w.r.t. the input, after computeDeltas (unevaluated, see Layer::inputDeltas) */
+  auto inputDeltas() const { return layer0.inputDeltas(); }
+
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& input )
+  {
+    layer0.evaluateGradients( input );
+    next.evaluateGradients( layer0.output() );
+  }
+
+  /*
+   * Function Name: accumulateGradients
+   * Description: Same as evaluateGradients, but adds to the gradients summed
+   *              over the micro-batches since the last applyAccumulated, so
+   *              that K passes of batch_size train like one batch of
+   *              K * batch_size (see Layer::accumulateGradients).
+   */
+  template<class Input>
+  void accumulateGradients( const MatrixBase<Input>& input )
+  {
+    layer0.accumulateGradients( input );
+    next.accumulateGradients( layer0.output() );
+  }
+
+  /*
+   * Function Name: forEachLayer
+   * Description: This function calls f on every layer, from the first to the
+   *              last. f must accept any Layer type (e.g. a generic lambda).
+   */
+  template<class F>
+  void forEachLayer( F&& f )
+  {
+    f( layer0 );
+    next.forEachLayer( f );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f ) const
+  {
+    f( layer0 );
+    next.forEachLayer( f );
+  }
+
+  // bytes placeTrialSetsIn takes from the arena, at most
+  constexpr static size_t trial_set_bytes = decltype( layer0 )::trial_set_bytes + decltype( next )::trial_set_bytes;
+};
+
+/*
+ * Class Name: SequentialNetwork
+ * Description: This is the base case of the above recursive template.
+ */
+template<class T, unsigned int batch_size, class L0>
+class SequentialNetwork<T, batch_size, L0> : public LayerSequence<SequentialNetwork<T, batch_size, L0>, T>
+{
+public:
+  Layer<T, batch_size, L0::input, L0::output, typename L0::activation_type> layer0 {};
+
+  constexpr static unsigned int input_size = L0::input;
+  constexpr static unsigned int output_size = L0::output;
+
+  /* the last layer always applies its own activation */
+  template<class Hidden = activation::Own, class Input>
+  void apply( const MatrixBase<Input>& input )
+  {
+    layer0.apply( input );
+  }
+
+  template<class Hidden = activation::Own, class Input, class Out>
+  void apply_into( const MatrixBase<Input>& input, const MatrixBase<Out>& out )
+  {
+    layer0.template applyInto<typename L0::activation_type>( input, out );
+  }
+
+  const Matrix<T, batch_size, output_size>& output() const { return layer0.output(); }
+
+  template<class Hidden = activation::Own>
+  void computeDeltas()
+  {
+    computeDeltas( Matrix<T, batch_size, output_size>::Ones() / batch_size );
+  }
+
+  template<class Hidden = activation::Own, class Seed>
+  void computeDeltas( const MatrixBase<Seed>& seed )
+  {
+    layer0.template setDeltasWith<typename L0::activation_type>( seed );
+  }
+
+  auto inputDeltas() const { return layer0.inputDeltas(); }
+
+  template<class Input>
+  void evaluateGradients( const MatrixBase<Input>& input )
+  {
+    layer0.evaluateGradients( input );
+  }
+
+  template<class Input>
+  void accumulateGradients( const MatrixBase<Input>& input )
+  {
+    layer0.accumulateGradients( input );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f )
+  {
+    f( layer0 );
+  }
+
+  template<class F>
+  void forEachLayer( F&& f ) const
+  {
+    f( layer0 );
+  }
+
+  constexpr static size_t trial_set_bytes = decltype( layer0 )::trial_set_bytes;
+};
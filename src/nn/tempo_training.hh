@@ -0,0 +1,96 @@
+/**
+ * File name: tempo_training.hh
+ * Last Update: October 2026
+ * Description: Helpers shared by the tempo training tools (sweep and
+ *              distill_tempo): windows of beat times for a tempo, the draw of
+ *              a training tempo, a finiteness check that survives
+ *              -ffast-math, and worker threads pinned to CPUs.
+ */
+
+#pragma once
+
+#include "affinity.hh"
+#include "eigen.hh"
+#include "thread_pool.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <thread>
+#include <vector>
+
+// beat times in one window
+constexpr unsigned int tempo_window_size = 16;
+
+inline float get_rand( std::mt19937& rng, const float min, const float max )
+{
+  return std::uniform_real_distribution<float>( min, max )( rng );
+}
+
+/* the beat times of a window at tempo bpm, optionally jittered by up to 5% of a beat and shifted by up to a beat */
+inline Eigen::Matrix<float, 1, tempo_window_size> gen_time( const float tempo,
+                                                            const bool offset,
+                                                            const bool noise,
+                                                            std::mt19937& rng )
+{
+  Eigen::Matrix<float, 1, tempo_window_size> ret_mat;
+  float amt_offset = 0;
+  if ( offset ) {
+    amt_offset = get_rand( rng, 0.0, 60.0 / tempo );
+  }
+  for ( unsigned int i = 0; i < tempo_window_size; i++ ) {
+    ret_mat( i ) = ( 60.0 / tempo ) * i;
+    if ( noise ) {
+      ret_mat( i ) += get_rand( rng, -0.05, 0.05 ) * ( 60.0 / tempo );
+    }
+    ret_mat( i ) += amt_offset;
+  }
+  return ret_mat;
+}
+
+/* a training tempo: 30..50 bpm with probability 0.4, otherwise 30..240 bpm */
+inline float draw_tempo( std::mt19937& rng )
+{
+  return get_rand( rng, 0, 1 ) < 0.4 ? get_rand( rng, 30, 50 ) : get_rand( rng, 30, 240 );
+}
+
+/* isfinite() is folded away under -ffast-math, so look at the exponent bits instead */
+inline bool is_finite( const float x )
+{
+  uint32_t bits;
+  memcpy( &bits, &x, sizeof( bits ) );
+  return ( bits & 0x7f800000 ) != 0x7f800000;
+}
+
+/*
+ * run body( w ) on num_threads threads, thread w pinned to cpus[w % cpus.size()] (and its wide layers kept on it);
+ * rethrows a worker's error
+ */
+template<class Body>
+void run_pinned_workers( const unsigned int num_threads, const std::vector<unsigned int>& cpus, Body&& body )
+{
+  std::vector<std::exception_ptr> errors( num_threads );
+  std::vector<std::thread> workers;
+  for ( unsigned int w = 0; w < num_threads; w++ ) {
+    workers.emplace_back( [&, w] {
+      try {
+        pin_this_thread( cpus[w % cpus.size()] );
+        ThreadPool::run_inline_on_this_thread();
+        body( w );
+      } catch ( ... ) {
+        errors[w] = std::current_exception();
+      }
+    } );
+  }
+
+  for ( auto& worker : workers ) {
+    worker.join();
+  }
+
+  for ( const auto& error : errors ) {
+    if ( error ) {
+      std::rethrow_exception( error );
+    }
+  }
+}
@@ -0,0 +1,343 @@
+/**
+ * File name: weight_image.hh
+ * Last Update: October 2026
+ */
+
+#pragma once
+
+#include "activation.hh"
+#include "eigen.hh"
+#include "layer.hh"
+#include "mmap.hh"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+ * Binary weight image layout (native byte order):
+ *
+ *   char     magic[8]        "NNFWIMG1"
+ *   uint32_t scalar_size     sizeof(T) of the parameters
+ *   uint32_t num_sizes       number of layer sizes (layers + 1)
+ *   uint32_t sizes[num_sizes]
+ *   then, for each layer, starting on a 64-byte boundary:
+ *     weights (input x output, column-major as in Layer), padded to 64 bytes
+ *     biases (1 x output), padded to 64 bytes
+ *
+ * The parameters are stored exactly as they sit in memory, so a mapping of the
+ * file can be used in place without parsing.
+ */
+class WeightImage
+{
+public:
+  constexpr static std::array<char, 8> magic { 'N', 'N', 'F', 'W', 'I', 'M', 'G', '1' };
+  constexpr static size_t alignment = 64;
+
+  /* byte offsets of each layer's weights and biases, and the total size of an image */
+  struct Layout
+  {
+    std::vector<size_t> weights {};
+    std::vector<size_t> biases {};
+    size_t size {};
+  };
+
+  static size_t align_up( const size_t n ) { return ( n + alignment - 1 ) & ~( alignment - 1 ); }
+
+  static Layout layout( const std::vector<unsigned int>& sizes, const size_t scalar_size )
+  {
+    Layout ret;
+    size_t offset = align_up( magic.size() + 2 * sizeof( uint32_t ) + sizes.size() * sizeof( uint32_t ) );
+    for ( size_t i = 0; i + 1 < sizes.size(); i++ ) {
+      ret.weights.push_back( offset );
+      offset += align_up( size_t( sizes[i] ) * sizes[i + 1] * scalar_size );
+      ret.biases.push_back( offset );
+      offset += align_up( size_t( sizes[i + 1] ) * scalar_size );
+    }
+    ret.size = offset;
+    return ret;
+  }
+
+private:
+  ReadOnlyFile file_;
+  uint32_t scalar_size_ {};
+  std::vector<unsigned int> layer_sizes_ {};
+  Layout layout_ {};
+
+  void read_header()
+  {
+    const std::string_view contents = file_;
+    const auto read_u32 = [&]( const size_t offset ) {
+      if ( offset + sizeof( uint32_t ) > contents.size() ) {
+        throw std::runtime_error( "WeightImage: truncated header" );
+      }
+      uint32_t ret;
+      memcpy( &ret, contents.data() + offset, sizeof( ret ) );
+      return ret;
+    };
+
+    if ( contents.size() < magic.size() or memcmp( contents.data(), magic.data(), magic.size() ) ) {
+      throw std::runtime_error( "WeightImage: not a weight image (bad magic)" );
+    }
+
+    scalar_size_ = read_u32( magic.size() );
+    const uint32_t num_sizes = read_u32( magic.size() + sizeof( uint32_t ) );
+    if ( num_sizes < 2 ) {
+      throw std::runtime_error( "WeightImage: needs at least one layer" );
+    }
+    for ( uint32_t i = 0; i < num_sizes; i++ ) {
+      layer_sizes_.push_back( read_u32( magic.size() + ( 2 + i ) * sizeof( uint32_t ) ) );
+    }
+
+    layout_ = layout( layer_sizes_, scalar_size_ );
+    if ( contents.size() < layout_.size ) {
+      throw std::runtime_error( "WeightImage: file is " + std::to_string( contents.size() ) + " bytes, expected "
+                                + std::to_string( layout_.size ) );
+    }
+  }
+
+public:
+  /* map an image read-only and shared: every process mapping the same file shares its page-cache pages */
+  explicit WeightImage( const std::string& filename )
+    : file_( filename )
+  {
+    read_header();
+  }
+
+  const std::vector<unsigned int>& layer_sizes() const { return layer_sizes_; }
+  unsigned int num_layers() const { return layer_sizes_.size() - 1; }
+  size_t scalar_size() const { return scalar_size_; }
+  size_t size() const { return layout_.size; }
+
+  template<class T>
+  const T* weights( const unsigned int layer ) const
+  {
+    return reinterpret_cast<const T*>( file_.addr() + layout_.weights.at( layer ) );
+  }
+
+  template<class T>
+  const T* biases( const unsigned int layer ) const
+  {
+    return reinterpret_cast<const T*>( file_.addr() + layout_.biases.at( layer ) );
+  }
+
+  /* throws unless the image holds exactly these layer sizes with parameters of type T */
+  template<class T>
+  void check_shape( const std::vector<unsigned int>& sizes ) const
+  {
+    if ( scalar_size_ != sizeof( T ) or sizes != layer_sizes_ ) {
+      throw std::runtime_error( "WeightImage: image does not match the network's scalar type or layer sizes" );
+    }
+  }
+
+  /*
+   * Function Name: write
+   * Description: This function writes the parameters of each layer to an
+   *              image. The file is written under a temporary name and then
+   *              renamed, so a process mapping `filename` never sees a
+   *              partial image.
+   * Parameters:
+   *			1. filename is the image to (re)create
+   *			2. layers holds the (weights, biases) of each layer, in order
+   */
+  template<class T>
+  static void write( const std::string& filename,
+                     const std::vector<std::pair<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>,
+                                                 Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>>& layers )
+  {
+    if ( layers.empty() ) {
+      throw std::runtime_error( "WeightImage: no layers to write" );
+    }
+
+    std::vector<unsigned int> sizes { static_cast<unsigned int>( layers.front().first.rows() ) };
+    for ( const auto& [weights, biases] : layers ) {
+      if ( weights.rows() != sizes.back() or biases.rows() != 1 or biases.cols() != weights.cols() ) {
+        throw std::runtime_error( "WeightImage: layer shapes do not chain" );
+      }
+      sizes.push_back( weights.cols() );
+    }
+    const Layout image_layout = layout( sizes, sizeof( T ) );
+
+    std::string image( image_layout.size, 0 );
+    const auto write_u32 = [&]( const size_t offset, const uint32_t value ) {
+      memcpy( image.data() + offset, &value, sizeof( value ) );
+    };
+    memcpy( image.data(), magic.data(), magic.size() );
+    write_u32( magic.size(), sizeof( T ) );
+    write_u32( magic.size() + sizeof( uint32_t ), sizes.size() );
+    for ( size_t i = 0; i < sizes.size(); i++ ) {
+      write_u32( magic.size() + ( 2 + i ) * sizeof( uint32_t ), sizes[i] );
+    }
+    for ( size_t i = 0; i < layers.size(); i++ ) {
+      const auto& [weights, biases] = layers[i];
+      memcpy( image.data() + image_layout.weights[i], weights.data(), weights.size() * sizeof( T ) );
+      memcpy( image.data() + image_layout.biases[i], biases.data(), biases.size() * sizeof( T ) );
+    }
+
+    const std::string temp_filename = filename + ".tmp";
+    {
+      std::ofstream out { temp_filename, std::ios::binary | std::ios::trunc };
+      out.write( image.data(), image.size() );
+      if ( not out ) {
+        throw std::runtime_error( "WeightImage: could not write " + temp_filename );
+      }
+    }
+    if ( std::rename( temp_filename.c_str(), filename.c_str() ) ) {
+      throw std::runtime_error( "WeightImage: could not rename " + temp_filename + " to " + filename );
+    }
+  }
+};
+
+/* the layer sizes of a Network, read from its layers */
+template<class NetworkT>
+std::vector<unsigned int> networkLayerSizes( const NetworkT& network )
+{
+  std::vector<unsigned int> sizes;
+  network.forEachLayer( [&]( const auto& layer ) {
+    if ( sizes.empty() ) {
+      sizes.push_back( layer.weights().rows() );
+    }
+    sizes.push_back( layer.weights().cols() );
+  } );
+  return sizes;
+}
+
+/* write the parameters of a Network (or anything with forEachLayer) to a weight image */
+template<class NetworkT>
+void writeWeightImage( const NetworkT& network, const std::string& filename )
+{
+  using T = typename std::decay_t<decltype( network.output() )>::Scalar;
+  std::vector<std::pair<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>>
+    layers;
+  network.forEachLayer( [&]( const auto& layer ) { layers.emplace_back( layer.weights(), layer.biases() ); } );
+  WeightImage::write( filename, layers );
+}
+
+/* copy the parameters in an image into a (trainable) Network of the same shape */
+template<class NetworkT>
+void loadWeightImage( NetworkT& network, const WeightImage& image )
+{
+  using T = typename std::decay_t<decltype( network.output() )>::Scalar;
+  image.check_shape<T>( networkLayerSizes( network ) );
+
+  unsigned int layer_num = 0;
+  network.forEachLayer( [&]( auto& layer ) {
+    using Weights = std::decay_t<decltype( layer.weights() )>;
+    using Biases = std::decay_t<decltype( layer.biases() )>;
+    layer.weights() = Eigen::Map<const Weights>( image.weights<T>( layer_num ) );
+    layer.biases() = Eigen::Map<const Biases>( image.biases<T>( layer_num ) );
+    layer_num++;
+  } );
+}
+
+/*
+ * Class Name: MappedNetwork
+ * Description: An inference-only Network whose weights and biases are not
+ *              copied into the process: each layer reads its parameters
+ *              straight from a WeightImage through an Eigen::Map. N processes
+ *              serving the same image share one physical copy of the
+ *              parameters in the page cache, and loading is a page-table
+ *              operation instead of a parse.
+ *              Only the activations (batch_size x layer size per layer) are
+ *              private. As in Network, the last layer is not activated.
+ *              The image must outlive the MappedNetwork.
+ *
+ * Inputs:
+ *			1. T specifies the type of variables in the network (usually float)
+ *			2. batch_size specifies the size of a batch
+ *			3. sizes... specifies the input size followed by each layer's output size
+ */
+template<class T, unsigned int batch_size, unsigned int... sizes>
+class MappedNetwork
+{
+  constexpr static std::array<unsigned int, sizeof...( sizes )> layer_sizes_ { sizes... };
+  constexpr static unsigned int num_layers = sizeof...( sizes ) - 1;
+
+  static_assert( num_layers >= 1, "a network needs at least one layer" );
+
+public:
+  constexpr static unsigned int input_size = layer_sizes_.front();
+  constexpr static unsigned int output_size = layer_sizes_.back();
+
+private:
+  const WeightImage* image_;
+
+  // the type of a tuple of one matrix per layer output (unevaluated: only its return type is used)
+  template<unsigned int input, unsigned int... outputs>
+  static std::tuple<Eigen::Matrix<T, batch_size, outputs>...> layer_outputs();
+
+  // the output of each layer
+  decltype( layer_outputs<sizes...>() ) outputs_ {};
+
+  /* the last layer writes into final_output, the others into outputs_ (activated with Hidden, or ReLU) */
+  template<unsigned int layer, class Hidden, class Input, class Out>
+  void apply_layer( const Input& input, Out& final_output )
+  {
+    constexpr unsigned int in = layer_sizes_[layer];
+    constexpr unsigned int out = layer_sizes_[layer + 1];
+    const Eigen::Map<const Eigen::Matrix<T, in, out>, Eigen::AlignedMax> weights( image_->weights<T>( layer ) );
+    const Eigen::Map<const Eigen::Matrix<T, 1, out>, Eigen::AlignedMax> biases( image_->biases<T>( layer ) );
+
+    if constexpr ( layer + 1 < num_layers ) {
+      auto& output = std::get<layer>( outputs_ );
+      applyAffine<activation::hidden_or_own<Hidden, activation::ReLU>>( input, weights, biases, output );
+      apply_layer<layer + 1, Hidden>( output, final_output );
+    } else {
+      applyAffine<activation::Identity>( input, weights, biases, final_output );
+    }
+  }
+
+public:
+  /* throws if the image does not hold a network of this shape */
+  explicit MappedNetwork( const WeightImage& image )
+    : image_( &image )
+  {
+    image.check_shape<T>( { sizes... } );
+  }
+
+  /* read the parameters from another image of the same shape from now on */
+  void bind( const WeightImage& image )
+  {
+    image.check_shape<T>( { sizes... } );
+    image_ = &image;
+  }
+
+  MappedNetwork( const MappedNetwork& other ) = default;
+  MappedNetwork& operator=( const MappedNetwork& other ) = default;
+
+  /*
+   * input is any batch_size x input_size Eigen expression, e.g. a Map over the caller's memory (matrix_view.hh);
+   * Hidden, if given, replaces ReLU as the hidden activation, as in Network::apply
+   */
+  template<class Hidden = activation::Own, class Input>
+  void apply( const Eigen::MatrixBase<Input>& input )
+  {
+    apply_layer<0, Hidden>( input, std::get<num_layers - 1>( outputs_ ) );
+  }
+
+  template<class Input>
+  void apply_leaky( const Eigen::MatrixBase<Input>& input )
+  {
+    apply<activation::LeakyReLU>( input );
+  }
+
+  /* same as apply, but writes the output into out (e.g. a Map over the caller's buffer) instead of output() */
+  template<class Hidden = activation::Own, class Input, class Out>
+  void apply_into( const Eigen::MatrixBase<Input>& input, const Eigen::MatrixBase<Out>& out )
+  {
+    apply_layer<0, Hidden>( input, const_cast<Eigen::MatrixBase<Out>&>( out ) );
+  }
+
+  const Eigen::Matrix<T, batch_size, output_size>& output() const { return std::get<num_layers - 1>( outputs_ ); }
+
+  unsigned int getNumLayers() const { return num_layers; }
+
+  const WeightImage& image() const { return *image_; }
+};
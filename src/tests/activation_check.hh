@@ -0,0 +1,20 @@
+#pragma once
+
+#include "eigen.hh"
+
+#include <iostream>
+
+/* an activation policy's derivative matches central differences (step h) of its forward pass at z, within bound */
+template<class Activation>
+bool check_derivative( const char* name, const Eigen::ArrayXd& z, const double h, const double bound )
+{
+  using Eigen::ArrayXd;
+
+  const ArrayXd a = Activation::forward( z );
+  const ArrayXd numerical
+    = ( Activation::forward( ArrayXd( z + h ) ) - Activation::forward( ArrayXd( z - h ) ) ) / ( 2 * h );
+  const ArrayXd formula = Activation::derivative( z, a );
+  const double error = ( formula - numerical ).abs().maxCoeff();
+  std::cout << name << ": max derivative error " << error << " (bound " << bound << ")" << std::endl;
+  return error <= bound;
+}
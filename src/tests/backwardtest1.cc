@@ -0,0 +1,88 @@
+#include "eigen.hh"
+#include "network.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 3;
+constexpr size_t input_size = 5;
+// max allowable difference from the deltas of the by-value backward pass (rounding only)
+constexpr double deltas_epsilon = 1e-14;
+// max allowable error of the input deltas against a central difference
+constexpr double input_deltas_epsilon = 1e-7;
+
+using Net = Network<double, batch_size, input_size, 7, 6, 4, 2>;
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto net = make_unique<Net>();
+  net->initializeWeightsRandomly( rng );
+
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  const Matrix<double, batch_size, input_size> input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* the in-place backward pass gives the deltas of chaining Layer::computeDeltas by value */
+  auto reference = make_unique<Net>( *net );
+  reference->apply( input );
+  const Matrix<double, batch_size, 4> d3 = reference->next.next.next.layer0.computeDeltasWith<activation::Identity>(
+    Matrix<double, batch_size, 2>::Ones() / batch_size );
+  const Matrix<double, batch_size, 6> d2 = reference->next.next.layer0.computeDeltas( d3 );
+  const Matrix<double, batch_size, 7> d1 = reference->next.layer0.computeDeltas( d2 );
+  const Matrix<double, batch_size, input_size> d0 = reference->layer0.computeDeltas( d1 );
+
+  net->apply( input );
+  net->computeDeltas();
+  const auto diff = []( const auto& x, const auto& y ) { return ( x - y ).cwiseAbs().maxCoeff(); };
+  const auto& last = net->next.next.next.layer0;
+  const auto& reference_last = reference->next.next.next.layer0;
+  const double deltas_diff = max( { diff( net->layer0.deltas(), reference->layer0.deltas() ),
+                                    diff( net->next.layer0.deltas(), reference->next.layer0.deltas() ),
+                                    diff( net->next.next.layer0.deltas(), reference->next.next.layer0.deltas() ),
+                                    diff( last.deltas(), reference_last.deltas() ) } );
+
+  /* inputDeltas, evaluated on request, is the derivative of the mean output w.r.t. each input */
+  const Matrix<double, batch_size, input_size> input_deltas = net->inputDeltas();
+  const double input_deltas_diff = diff( input_deltas, d0 );
+
+  const double h = 1e-6;
+  double max_error = 0;
+  for ( unsigned int b = 0; b < batch_size; b++ ) {
+    for ( unsigned int i = 0; i < input_size; i++ ) {
+      Matrix<double, batch_size, input_size> perturbed = input;
+      perturbed( b, i ) += h;
+      net->apply( perturbed );
+      const double plus = net->output().sum();
+      perturbed( b, i ) -= 2 * h;
+      net->apply( perturbed );
+      const double minus = net->output().sum();
+      const double numerical = ( plus - minus ) / ( 2 * h ) / batch_size;
+      max_error = max( max_error, abs( numerical - input_deltas( b, i ) ) );
+    }
+  }
+
+  cout << "max diff from by-value deltas " << deltas_diff << ", input deltas " << input_deltas_diff
+       << "; max input delta error " << max_error << endl;
+
+  if ( not( deltas_diff < deltas_epsilon ) or not( input_deltas_diff < deltas_epsilon )
+       or not( max_error < input_deltas_epsilon ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
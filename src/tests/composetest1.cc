@@ -0,0 +1,69 @@
+#include "composed_network.hh"
+#include "eigen.hh"
+#include "gradient_check.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 3;
+constexpr size_t input_size = 8;
+// max allowable absolute difference between the composed, hand-chained and folded outputs
+constexpr double output_epsilon = 1e-12;
+
+using NetA = Network<double, batch_size, input_size, 6, 3>;
+using NetB = Network<double, batch_size, 3, 5, 4, 2>;
+using Composed = ComposedNetwork<NetA, NetB>;
+
+static_assert( is_same_v<Composed::Folded, Network<double, batch_size, input_size, 6, 5, 4, 2>> );
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto composed = make_unique<Composed>();
+  composed->initializeWeightsRandomly( rng );
+
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  const Matrix<double, batch_size, input_size> input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* the composition equals running the two networks one after the other */
+  auto a = make_unique<NetA>( composed->a );
+  auto b = make_unique<NetB>( composed->b );
+  a->apply( input );
+  b->apply( a->output() );
+  composed->apply( input );
+  const double chained_diff = ( composed->output() - b->output() ).cwiseAbs().maxCoeff();
+
+  /* the folded network has one layer fewer and computes the same function */
+  auto folded = make_unique<Composed::Folded>();
+  composed->exportFolded( *folded );
+  folded->apply( input );
+  const double folded_diff = ( composed->output() - folded->output() ).cwiseAbs().maxCoeff();
+
+  cout << "layers: composed " << composed->getNumLayers() << ", folded " << folded->getNumLayers() << endl;
+  cout << "max diff: chained " << chained_diff << ", folded " << folded_diff << endl;
+
+  /* backprop through the join matches numerical gradients of every parameter */
+  const GradientCheckResult result = checkGradients( *composed, input );
+  result.summary( cout );
+
+  if ( folded->getNumLayers() + 1 != composed->getNumLayers() or chained_diff > output_epsilon
+       or folded_diff > output_epsilon or not result.passed() ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,142 @@
+#include "convolutional_network.hh"
+#include "eigen.hh"
+#include "gradient_check.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int batch_size = 3;
+constexpr unsigned int window_size = 12;
+constexpr unsigned int event_size = 2;
+constexpr unsigned int out_channels = 4;
+constexpr unsigned int kernel_size = 3;
+// max allowable difference between two ways of computing the same output (rounding only)
+constexpr double output_epsilon = 1e-12;
+// max allowable difference between input deltas and central differences
+constexpr double input_delta_epsilon = 1e-6;
+
+using Contiguous
+  = ConvolutionalNetwork<double, batch_size, Conv1D<window_size, event_size, out_channels, kernel_size>, 5, 1>;
+using Dilated = ConvolutionalNetwork<double,
+                                     batch_size,
+                                     Conv1D<window_size, event_size, out_channels, kernel_size, 2, 3, activation::Tanh>,
+                                     5,
+                                     1>;
+
+/* the convolution computed from its definition, one output at a time */
+template<class Net, class Input, class F>
+double max_diff_from_definition( const Net& net,
+                                 const Input& input,
+                                 const unsigned int stride,
+                                 const unsigned int dilation,
+                                 F&& activation )
+{
+  const auto& conv = net.conv;
+  double max_diff = 0;
+  for ( unsigned int b = 0; b < batch_size; b++ ) {
+    for ( unsigned int t = 0; t < conv.output_length; t++ ) {
+      for ( unsigned int o = 0; o < out_channels; o++ ) {
+        double z = conv.biases()( 0, o );
+        for ( unsigned int k = 0; k < kernel_size; k++ ) {
+          for ( unsigned int c = 0; c < event_size; c++ ) {
+            z += input( b, ( t * stride + k * dilation ) * event_size + c ) * conv.weights()( k * event_size + c, o );
+          }
+        }
+        max_diff = max( max_diff, abs( activation( z ) - conv.output()( b, t * out_channels + o ) ) );
+      }
+    }
+  }
+  return max_diff;
+}
+
+/* the largest difference between inputDeltas() and central differences of the mean output */
+template<class Net, class Input>
+double max_input_delta_diff( Net& net, Input input )
+{
+  net.apply( input );
+  net.computeDeltas();
+  const Matrix<double, batch_size, Net::input_size> deltas = net.inputDeltas();
+
+  constexpr double h = 1e-5;
+  double max_diff = 0;
+  for ( unsigned int b = 0; b < batch_size; b++ ) {
+    for ( unsigned int i = 0; i < Net::input_size; i++ ) {
+      input( b, i ) += h;
+      net.apply( input );
+      const double up = net.output().sum() / batch_size;
+      input( b, i ) -= 2 * h;
+      net.apply( input );
+      const double down = net.output().sum() / batch_size;
+      input( b, i ) += h;
+      max_diff = max( max_diff, abs( ( up - down ) / ( 2 * h ) - deltas( b, i ) ) );
+    }
+  }
+  return max_diff;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  auto contiguous = make_unique<Contiguous>();
+  auto dilated = make_unique<Dilated>();
+  contiguous->initializeWeightsRandomly( rng );
+  dilated->initializeWeightsRandomly( rng );
+
+  const Matrix<double, batch_size, Contiguous::input_size> window
+    = Matrix<double, batch_size, Contiguous::input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* the output is the convolution, with and without stride and dilation */
+  contiguous->apply( window );
+  dilated->apply( window );
+  const double contiguous_diff
+    = max_diff_from_definition( *contiguous, window, 1, 1, []( double z ) { return max( z, 0.0 ); } );
+  const double dilated_diff = max_diff_from_definition( *dilated, window, 2, 3, []( double z ) { return tanh( z ); } );
+
+  /* gradients of the shared kernels match numerical gradients */
+  const GradientCheckResult contiguous_result = checkGradients( *contiguous, window );
+  contiguous_result.summary( cout );
+  const GradientCheckResult dilated_result = checkGradients( *dilated, window );
+  dilated_result.summary( cout );
+
+  const double contiguous_input_diff = max_input_delta_diff( *contiguous, window );
+  const double dilated_input_diff = max_input_delta_diff( *dilated, window );
+
+  /* moving the window along one event at a time gives the same output as applying each window */
+  const Matrix<double, batch_size, event_size * window_size * 3> stream
+    = Matrix<double, batch_size, event_size * window_size * 3>::NullaryExpr( [&] { return input_dist( rng ); } );
+  double shifted_diff = 0;
+  auto reference = make_unique<Contiguous>( *contiguous );
+  contiguous->apply( stream.leftCols<Contiguous::input_size>() );
+  for ( unsigned int t = 1; t + window_size <= 3 * window_size; t++ ) {
+    contiguous->apply_shifted( stream.middleCols<event_size>( ( t + window_size - 1 ) * event_size ) );
+    reference->apply( stream.middleCols<Contiguous::input_size>( t * event_size ) );
+    shifted_diff = max( shifted_diff, ( contiguous->output() - reference->output() ).cwiseAbs().maxCoeff() );
+  }
+
+  cout << "max diff from definition: contiguous " << contiguous_diff << ", dilated " << dilated_diff
+       << "; input deltas: contiguous " << contiguous_input_diff << ", dilated " << dilated_input_diff
+       << "; shifted " << shifted_diff << endl;
+
+  if ( not contiguous_result.passed() or not dilated_result.passed() or not( contiguous_diff < output_epsilon )
+       or not( dilated_diff < output_epsilon ) or not( contiguous_input_diff < input_delta_epsilon )
+       or not( dilated_input_diff < input_delta_epsilon ) or not( shifted_diff < output_epsilon ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,122 @@
+#include "distill.hh"
+#include "eigen.hh"
+#include "network.hh"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unistd.h>
+
+using namespace std;
+using namespace Eigen;
+using namespace distill;
+
+// max allowable difference (bpm) between a student run on scaled data and its folded copy (float rounding only:
+// the folded first layer subtracts the input means, so it loses a few bits)
+constexpr float fold_epsilon = 1e-2;
+
+using Student = Network<float, 1, input_size, 8, 1>;
+
+/* the scaled student and its folded copy give the same bpm on raw windows */
+float test_fold( mt19937& rng, const Samples& samples )
+{
+  const Normalization norm = compute_normalization( samples, 0.5 );
+  auto scaled = make_unique<Student>();
+  scaled->initializeWeightsRandomly( rng );
+  auto folded = make_unique<Student>();
+  set_params( *folded, fold_normalization( get_params( *scaled ), norm ) );
+
+  float max_diff = 0;
+  for ( Index i = 0; i < samples.inputs.rows(); i++ ) {
+    scaled->apply_leaky( ( samples.inputs.row( i ) - norm.input_mean ).cwiseQuotient( norm.input_std ) );
+    const float expected = scaled->output()( 0, 0 ) * norm.target_std + norm.target_mean;
+    folded->apply_leaky( samples.inputs.row( i ) );
+    max_diff = max( max_diff, abs( folded->output()( 0, 0 ) - expected ) );
+  }
+  return max_diff;
+}
+
+/* every window lands in exactly one part, and the parts keep their labels */
+bool test_split( const Samples& samples )
+{
+  const auto [train, validation] = split_validation( samples );
+  const Index n = samples.inputs.rows();
+  if ( train.inputs.rows() + validation.inputs.rows() != n or validation.inputs.rows() != n / validation_stride ) {
+    return false;
+  }
+
+  for ( Index i = 0; i < n; i++ ) {
+    const Samples& part = i % validation_stride == 0 ? validation : train;
+    const Index row = i % validation_stride == 0 ? i / validation_stride : i - i / validation_stride - 1;
+    if ( part.inputs.row( row ) != samples.inputs.row( i ) or part.truth( row ) != samples.truth( i )
+         or part.teacher( row ) != samples.teacher( i ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* the cache returns what was written, and only for the same teacher weights and data */
+bool test_cache( const Samples& samples, const DistillOptions& options )
+{
+  const string prefix = "/tmp/nnfun_distilltest1_" + to_string( getpid() );
+  const string weights_file = prefix + "_weights.txt";
+  const string cache_file = prefix + "_cache.bin";
+  ofstream { weights_file } << "0\nweights:\n[1, 2]\n";
+
+  const CacheHeader header = make_cache_header( "teacher", weights_file, options );
+  write_cache( cache_file, header, samples );
+  Samples loaded;
+  const bool round_trip = load_cache( cache_file, header, loaded ) and loaded.inputs == samples.inputs
+                          and loaded.truth == samples.truth and loaded.teacher == samples.teacher;
+
+  /* same size, different weights */
+  ofstream { weights_file } << "0\nweights:\n[1, 3]\n";
+  Samples stale;
+  const bool weights_keyed = not load_cache( cache_file, make_cache_header( "teacher", weights_file, options ), stale );
+
+  DistillOptions other_data = options;
+  other_data.data_seed++;
+  const bool data_keyed = not load_cache( cache_file, make_cache_header( "teacher", weights_file, other_data ), stale );
+
+  unlink( weights_file.c_str() );
+  unlink( cache_file.c_str() );
+
+  cout << "cache round trip " << round_trip << ", keyed on weights " << weights_keyed << ", on data " << data_keyed
+       << endl;
+  return round_trip and weights_keyed and data_keyed;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  DistillOptions options;
+  options.samples = 1000;
+  options.offset = true;
+
+  Samples samples;
+  generate_samples( samples, options );
+  samples.teacher = samples.truth + VectorXf::NullaryExpr( options.samples, [&] { return get_rand( rng, -1, 1 ); } );
+
+  const float fold_diff = test_fold( rng, samples );
+  const bool split_ok = test_split( samples );
+  const bool cache_ok = test_cache( samples, options );
+
+  cout << "max diff of the folded student " << fold_diff << " bpm, split " << split_ok << endl;
+
+  if ( not( fold_diff < fold_epsilon ) or not split_ok or not cache_ok ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
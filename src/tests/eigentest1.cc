@@ -1,4 +1,5 @@
-#include <Eigen/Dense>
+#include "eigen.hh"
+
 #include <cstdlib>
 #include <iostream>
 
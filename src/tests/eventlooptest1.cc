@@ -0,0 +1,142 @@
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/* an edge-triggered rule whose callback reads one byte per call still gets every byte */
+bool test_partial_reads()
+{
+  auto pipe = make_pipe();
+  FileDescriptor& reader = pipe.first;
+  FileDescriptor& writer = pipe.second;
+  reader.set_blocking( false );
+
+  EventLoop loop;
+  string received;
+  bool cancelled = false;
+  loop.add_rule(
+    "read one byte",
+    reader,
+    Direction::In,
+    [&] {
+      char c;
+      if ( reader.read( { &c, 1 } ) == 1 ) {
+        received.push_back( c );
+      }
+    },
+    [] { return true; },
+    [&] { cancelled = true; } );
+
+  const string sent = "onsets arrive in bursts";
+  writer.write( sent );
+  writer.close();
+
+  unsigned int calls = 0;
+  while ( loop.wait_next_event( 1000 ) != EventLoop::Result::Exit and calls++ < 1000 ) {}
+
+  cout << "received \"" << received << "\" in " << loop.wakeups() << " wakeups, cancelled " << cancelled << endl;
+  return received == sent and cancelled;
+}
+
+/* a rule that stays interested in a readable fd but never reads it is caught */
+bool test_busy_wait_detection()
+{
+  auto [reader, writer] = make_pipe();
+  reader.set_blocking( false );
+  writer.write( "x" );
+
+  EventLoop loop;
+  loop.add_rule( "never reads", reader, Direction::In, [] {} );
+
+  try {
+    for ( unsigned int i = 0; i < 10; i++ ) {
+      loop.wait_next_event( 1000 );
+    }
+  } catch ( const runtime_error& e ) {
+    cout << "caught: " << e.what() << endl;
+    return true;
+  }
+  return false;
+}
+
+/* write_some stops at a full non-blocking pipe and says so; write still refuses to return short of progress */
+bool test_write_some()
+{
+  auto [reader, writer] = make_pipe();
+  writer.set_blocking( false );
+
+  const string chunk( 4096, 'x' );
+  size_t written = 0;
+  for ( size_t n = 1; n > 0; written += n ) {
+    n = writer.write_some( chunk );
+  }
+  const bool blocked = writer.write_blocked();
+
+  bool write_threw = false;
+  try {
+    writer.write( chunk );
+  } catch ( const runtime_error& ) {
+    write_threw = true;
+  }
+
+  string drained( written, 0 );
+  const size_t n = reader.read( { drained.data(), drained.size() } );
+  const bool writable_again = writer.write_some( chunk ) > 0 and not writer.write_blocked();
+
+  cout << "write_some filled the pipe with " << written << " bytes; blocked " << blocked
+       << ", write threw " << write_threw << ", writable after reading " << n << " bytes " << writable_again
+       << endl;
+  return written > 0 and blocked and write_threw and n > 0 and writable_again;
+}
+
+/* closing an fd with a rule in each direction drops both, and leaves its number free for a new fd's rules */
+bool test_close_with_two_rules()
+{
+  auto [socket, peer] = LocalStreamSocket::make_pair();
+  socket.set_blocking( false );
+
+  EventLoop loop;
+  unsigned int cancelled = 0;
+  loop.add_rule(
+    "read", socket, Direction::In, [] {}, [] { return false; }, [&] { cancelled++; } );
+  loop.add_rule(
+    "write", socket, Direction::Out, [] {}, [] { return false; }, [&] { cancelled++; } );
+  loop.wait_next_event( 0 );
+
+  socket.close();
+  auto [reader, writer] = make_pipe(); /* likely reuses the closed number */
+  reader.set_blocking( false );
+  const bool exited = loop.wait_next_event( 0 ) == EventLoop::Result::Exit;
+
+  string received;
+  loop.add_rule( "read pipe", reader, Direction::In, [&] {
+    char c;
+    if ( reader.read( { &c, 1 } ) == 1 ) {
+      received.push_back( c );
+    }
+  } );
+  writer.write( "x" );
+  loop.wait_next_event( 1000 );
+
+  cout << "closed fd: " << cancelled << " rules cancelled, exited " << exited << ", new fd "
+       << ( reader.fd_num() == socket.fd_num() ? "reused" : "did not reuse" ) << " its number and read \""
+       << received << "\"" << endl;
+  return cancelled == 2 and exited and received == "x";
+}
+
+int main()
+{
+  try {
+    if ( not test_partial_reads() or not test_busy_wait_detection() or not test_write_some()
+         or not test_close_with_two_rules() ) {
+      throw runtime_error( "test failure" );
+    }
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,96 @@
+#include "activation.hh"
+#include "activation_check.hh"
+#include "eigen.hh"
+#include "fast_math.hh"
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+using namespace std;
+using namespace Eigen;
+
+/* every float in [-30, 30] with spacing 1/4096, plus some far out */
+ArrayXf test_points()
+{
+  ArrayXf points( 60 * 4096 + 1 + 4 );
+  for ( int i = 0; i <= 60 * 4096; i++ ) {
+    points( i ) = -30 + i / 4096.0f;
+  }
+  points.tail( 4 ) << -1e4f, -100.0f, 100.0f, 1e4f;
+  return points;
+}
+
+long double exact_gelu( const long double x )
+{
+  return 0.5L * x * ( 1 + erfl( x / sqrtl( 2 ) ) );
+}
+
+long double tanh_gelu_derivative( const long double x )
+{
+  const long double k = sqrtl( 2 / M_PIl ), c = 0.044715L;
+  const long double t = tanhl( k * ( x + c * x * x * x ) );
+  return 0.5L * ( 1 + t ) + 0.5L * x * ( 1 - t * t ) * k * ( 1 + 3 * c * x * x );
+}
+
+/* checks the vectorized (array) result and the scalar functor against the exact function (absolute error, relative
+   once the function exceeds 1 in magnitude) */
+template<class Array>
+bool check( const char* name,
+            const ArrayXf& x,
+            const Array& approx,
+            const function<float( float )>& scalar,
+            const function<long double( long double )>& exact,
+            const double bound )
+{
+  double max_error = 0;
+  for ( Index i = 0; i < x.size(); i++ ) {
+    const long double reference = exact( x( i ) );
+    const double scale = max<double>( 1, fabsl( reference ) );
+    max_error = max<double>( max_error, fabsl( approx( i ) - reference ) / scale );
+    max_error = max<double>( max_error, fabsl( scalar( x( i ) ) - reference ) / scale );
+  }
+  cout << name << ": max error " << max_error << " (bound " << bound << ")" << endl;
+  return max_error <= bound;
+}
+
+/* derivatives are checked against central differences on a grid that misses 0 */
+constexpr double derivative_step = 1e-5;
+
+int main()
+{
+  try {
+    const ArrayXf x = test_points();
+    const ArrayXd derivative_points = ArrayXd::LinSpaced( 161, -8.05, 7.95 );
+    const ArrayXf tanh_x = fast_math::tanh( x ), sigmoid_x = fast_math::sigmoid( x ), gelu_x = fast_math::gelu( x ),
+                  gelu_derivative_x = fast_math::gelu_derivative( x ), softplus_x = fast_math::softplus( x );
+
+    using fast_math::detail::gelu;
+    using fast_math::detail::gelu_derivative;
+    using fast_math::detail::sigmoid;
+    using fast_math::detail::softplus;
+
+    const bool passed
+      = check(
+          "tanh", x, tanh_x, []( float v ) { return fast_math::detail::tanh( v ); }, []( long double v ) { return tanhl( v ); }, 1e-4 )
+        and check(
+          "sigmoid", x, sigmoid_x, []( float v ) { return sigmoid( v ); }, []( long double v ) { return 1 / ( 1 + expl( -v ) ); }, 5e-5 )
+        and check( "gelu", x, gelu_x, []( float v ) { return gelu( v ); }, exact_gelu, 1e-3 )
+        and check(
+          "gelu_derivative", x, gelu_derivative_x, []( float v ) { return gelu_derivative( v ); }, tanh_gelu_derivative, 2e-3 )
+        and check(
+          "softplus", x, softplus_x, []( float v ) { return softplus( v ); }, []( long double v ) { return log1pl( expl( v ) ); }, 1e-6 )
+        and check_derivative<activation::FastGELU>( "FastGELU", derivative_points, derivative_step, 2e-3 )
+        and check_derivative<activation::FastTanh>( "FastTanh", derivative_points, derivative_step, 2e-3 )
+        and check_derivative<activation::FastSigmoid>( "FastSigmoid", derivative_points, derivative_step, 1e-3 )
+        and check_derivative<activation::Softplus>( "Softplus", derivative_points, derivative_step, 1e-5 );
+
+    if ( not passed ) {
+      throw runtime_error( "test failure" );
+    }
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,85 @@
+#include "eigen.hh"
+#include "gradient_check.hh"
+#include "network.hh"
+#include "timer.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 1;
+// epsilon for computation of numerical gradients
+constexpr double grad_epsilon = 1e-5;
+// max allowable absolute difference in numerical and backprop gradients
+constexpr double compare_epsilon = 1e-5;
+// max allowable percentage difference in numerical and backprop gradients
+constexpr double percentage_error_epsilon = 1e-3;
+// parameters sampled per layer, and random directions covering all parameters
+constexpr unsigned int samples_per_layer = 32;
+constexpr unsigned int num_directions = 4;
+// worker threads, each with its own copy of the network (a fixed few, whatever the machine's size)
+constexpr unsigned int num_threads = 2;
+
+/* sampled and directional gradient checks of a production-sized network, in double */
+template<class NetworkT, unsigned int input_size>
+bool check_shape( const char* name )
+{
+  const uint64_t start = Timer::timestamp_ns();
+
+  mt19937 rng( 0 );
+  auto nn = make_unique<NetworkT>();
+  nn->initializeWeightsRandomly( rng );
+
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  const Matrix<double, batch_size, input_size> input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  GradientCheckOptions options;
+  options.epsilon = grad_epsilon;
+  options.abs_tolerance = compare_epsilon;
+  options.rel_tolerance = percentage_error_epsilon;
+  options.samples_per_layer = samples_per_layer;
+  options.directions = num_directions;
+  options.threads = num_threads;
+  const GradientCheckResult result = checkGradients( *nn, input, options );
+
+  cout << name << ": ";
+  result.summary( cout );
+  cout << "Took ";
+  Timer::pp_ns( cout, Timer::timestamp_ns() - start );
+  cout << "\n\n";
+
+  return result.passed();
+}
+
+void program_body()
+{
+  cout << "Params: grad_epsilon " << grad_epsilon << ", compare_epsilon " << compare_epsilon
+       << ", percentage_error_epsilon " << percentage_error_epsilon << endl
+       << endl;
+
+  bool passed = true;
+
+  /* tempo network from eighteen_outputs.cc */
+  passed &= check_shape<Network<double, batch_size, 16, 16, 1, 2500, 2500, 2>, 16>( "16-16-1-2500-2500-2" );
+  /* largest shape of the speed table */
+  passed &= check_shape<Network<double, batch_size, 1, 2048, 2048, 1>, 1>( "1-2048-2048-1" );
+
+  if ( not passed ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
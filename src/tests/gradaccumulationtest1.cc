@@ -0,0 +1,128 @@
+#include "eigen.hh"
+#include "network.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int micro_batch_size = 2;
+constexpr unsigned int num_micro_batches = 3;
+constexpr unsigned int batch_size = micro_batch_size * num_micro_batches;
+constexpr unsigned int input_size = 5;
+constexpr double learning_rate = 0.1;
+// max allowable difference between the parameters after accumulated and whole-batch steps (rounding only)
+constexpr double param_epsilon = 1e-12;
+
+using Micro = Network<double, micro_batch_size, input_size, 7, 4, 2>;
+using Whole = Network<double, batch_size, input_size, 7, 4, 2>;
+
+template<class A, class B>
+double max_param_diff( const A& a, const B& b )
+{
+  return max( { ( a.layer0.weights() - b.layer0.weights() ).cwiseAbs().maxCoeff(),
+                ( a.layer0.biases() - b.layer0.biases() ).cwiseAbs().maxCoeff(),
+                ( a.next.layer0.weights() - b.next.layer0.weights() ).cwiseAbs().maxCoeff(),
+                ( a.next.layer0.biases() - b.next.layer0.biases() ).cwiseAbs().maxCoeff(),
+                ( a.next.next.layer0.weights() - b.next.next.layer0.weights() ).cwiseAbs().maxCoeff(),
+                ( a.next.next.layer0.biases() - b.next.next.layer0.biases() ).cwiseAbs().maxCoeff() } );
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  uniform_real_distribution<double> input_dist( -1, 1 );
+
+  auto micro = make_unique<Micro>();
+  auto whole = make_unique<Whole>();
+  micro->initializeWeightsRandomly( rng );
+  whole->layer0.weights() = micro->layer0.weights();
+  whole->layer0.biases() = micro->layer0.biases();
+  whole->next.layer0.weights() = micro->next.layer0.weights();
+  whole->next.layer0.biases() = micro->next.layer0.biases();
+  whole->next.next.layer0.weights() = micro->next.next.layer0.weights();
+  whole->next.next.layer0.biases() = micro->next.next.layer0.biases();
+
+  /* a micro-batch whose gradients are discarded does not count */
+  const Matrix<double, micro_batch_size, input_size> discarded
+    = Matrix<double, micro_batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+  micro->apply( discarded );
+  micro->computeDeltas();
+  micro->accumulateGradients( discarded );
+  micro->zeroGradients();
+
+  /* K micro-batches, accumulated, step like one batch of all of them (twice, so the sum restarts) */
+  double max_diff = 0;
+  bool counted = true;
+  for ( unsigned int step = 0; step < 2; step++ ) {
+    const Matrix<double, batch_size, input_size> input
+      = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+    for ( unsigned int k = 0; k < num_micro_batches; k++ ) {
+      const auto micro_input = input.middleRows<micro_batch_size>( k * micro_batch_size );
+      micro->apply( micro_input );
+      micro->computeDeltas();
+      micro->accumulateGradients( micro_input );
+    }
+    counted = counted and micro->layer0.accumulatedBatches() == num_micro_batches;
+    micro->applyAccumulated( learning_rate );
+
+    whole->apply( input );
+    whole->computeDeltas();
+    whole->evaluateGradients( input );
+    for ( unsigned int i = 0; i < whole->getNumLayers(); i++ ) {
+      whole->modifyParamWholeLayer( i, learning_rate );
+    }
+
+    max_diff = max( max_diff, max_param_diff( *micro, *whole ) );
+  }
+
+  /* a plain evaluateGradients + modifyParamWholeLayer step ends the sum: the next accumulation starts afresh */
+  auto reference = make_unique<Micro>( *micro );
+  const Matrix<double, batch_size, input_size> mixed_input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+  for ( auto* net : { micro.get(), reference.get() } ) {
+    const auto plain_input = mixed_input.topRows<micro_batch_size>();
+    net->apply( plain_input );
+    net->computeDeltas();
+    net->evaluateGradients( plain_input );
+    for ( unsigned int i = 0; i < net->getNumLayers(); i++ ) {
+      net->modifyParamWholeLayer( i, learning_rate );
+    }
+  }
+  const bool sum_ended = micro->layer0.accumulatedBatches() == 0;
+  reference->zeroGradients();
+  for ( auto* net : { micro.get(), reference.get() } ) {
+    for ( unsigned int k = 1; k < num_micro_batches; k++ ) {
+      const auto micro_input = mixed_input.middleRows<micro_batch_size>( k * micro_batch_size );
+      net->apply( micro_input );
+      net->computeDeltas();
+      net->accumulateGradients( micro_input );
+    }
+  }
+  counted = counted and micro->layer0.accumulatedBatches() == num_micro_batches - 1;
+  micro->applyAccumulated( learning_rate );
+  reference->applyAccumulated( learning_rate );
+  const double mixed_diff = max_param_diff( *micro, *reference );
+
+  cout << "max parameter diff from whole-batch steps " << max_diff << ", micro-batches counted " << counted
+       << ", sum ended by a plain step " << sum_ended << ", diff after a plain step " << mixed_diff << endl;
+
+  if ( not( max_diff < param_epsilon ) or not counted or not sum_ended or not( mixed_diff < param_epsilon ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,122 @@
+#include "eigen.hh"
+#include "gradient_check.hh"
+#include "network.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 2;
+constexpr size_t input_size = 8;
+// epsilon for computation of numerical gradients
+constexpr double grad_epsilon = 1e-5;
+// max allowable difference between the checker's and calculateNumericalGradient's worst error (rounding only)
+constexpr double agreement_epsilon = 1e-8;
+constexpr unsigned int samples_per_layer = 5;
+constexpr unsigned int num_directions = 8;
+constexpr unsigned int num_threads = 3;
+
+// in float, a parameter's finite difference rounds to about ulp(output) / epsilon, so it gets an absolute tolerance
+constexpr double float_grad_epsilon = 1e-4;
+constexpr double float_abs_tolerance = 1e-3;
+
+using SmallNetwork = Network<double, batch_size, input_size, 12, 12, 3>;
+using WideFloatNetwork = Network<float, batch_size, input_size, 256, 256, 3>;
+
+/* the largest difference between backprop and Network::calculateNumericalGradient, over every parameter */
+double reference_max_diff( SmallNetwork& nn, const Matrix<double, batch_size, input_size>& input )
+{
+  nn.apply( input );
+  nn.computeDeltas();
+  nn.evaluateGradients( input );
+
+  double max_diff = 0;
+  for ( unsigned int layer = 0; layer < nn.getNumLayers(); layer++ ) {
+    for ( unsigned int param = 0; param < nn.getNumParams( layer ); param++ ) {
+      const double formula = nn.getEvaluatedGradient( layer, param );
+      const double numerical = nn.calculateNumericalGradient( input, layer, param, grad_epsilon );
+      max_diff = max( max_diff, abs( formula - numerical ) );
+    }
+  }
+  return max_diff;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto nn = make_unique<SmallNetwork>();
+  nn->initializeWeightsRandomly( rng );
+  const Matrix<double, batch_size, input_size> input = Matrix<double, batch_size, input_size>::Random();
+
+  unsigned int num_params = 0;
+  for ( unsigned int layer = 0; layer < nn->getNumLayers(); layer++ ) {
+    num_params += nn->getNumParams( layer );
+  }
+
+  /* every parameter, and random directions, over several threads: the same worst error as the serial reference */
+  GradientCheckOptions options;
+  options.epsilon = grad_epsilon;
+  options.directions = num_directions;
+  options.threads = num_threads;
+  options.verbose = false;
+  const GradientCheckResult full = checkGradients( *nn, input, options );
+  const double reference = reference_max_diff( *nn, input );
+
+  /* a sample of each layer */
+  options.samples_per_layer = samples_per_layer;
+  options.directions = 0;
+  const GradientCheckResult sampled = checkGradients( *nn, input, options );
+
+  /* with no tolerance at all, rounding alone fails checks */
+  options.abs_tolerance = 0;
+  options.rel_tolerance = 0;
+  const GradientCheckResult strict = checkGradients( *nn, input, options );
+
+  /* a wide float network (scaled like a trained one): sampled parameters pass, directions are refused */
+  auto wide = make_unique<WideFloatNetwork>();
+  wide->initializeWeightsRandomly( rng );
+  wide->forEachLayer( []( auto& layer ) { layer.weights() /= sqrt( float( layer.getInputSize() ) ); } );
+  const Matrix<float, batch_size, input_size> float_input = input.cast<float>();
+  GradientCheckOptions float_options;
+  float_options.epsilon = float_grad_epsilon;
+  float_options.abs_tolerance = float_abs_tolerance;
+  float_options.samples_per_layer = samples_per_layer;
+  float_options.threads = num_threads;
+  const GradientCheckResult wide_float = checkGradients( *wide, float_input, float_options );
+  bool float_directions_refused = false;
+  try {
+    float_options.directions = num_directions;
+    checkGradients( *wide, float_input, float_options );
+  } catch ( const runtime_error& e ) {
+    cout << "float directions: " << e.what() << "\n";
+    float_directions_refused = true;
+  }
+
+  full.summary( cout );
+  cout << "calculateNumericalGradient maxDiff: " << reference << "\n";
+  sampled.summary( cout );
+  cout << "with no tolerance: " << strict.failures << " failures" << endl;
+  wide_float.summary( cout );
+
+  if ( not full.passed() or full.params_checked != num_params or full.directions_checked != num_directions
+       or not( abs( full.max_abs_diff - reference ) < agreement_epsilon ) or not sampled.passed()
+       or sampled.params_checked != samples_per_layer * nn->getNumLayers() or strict.passed()
+       or not wide_float.passed() or wide_float.params_checked != samples_per_layer * wide->getNumLayers()
+       or not float_directions_refused ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,189 @@
+#include "eigen.hh"
+#include "inference_server.hh"
+#include "network.hh"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Eigen;
+using namespace inference;
+
+template<unsigned int batch_size>
+using TinyNetwork = Network<float, batch_size, input_size, 8, output_size>;
+using Batched = BatchedModel<TinyNetwork, 1, 2, 4>;
+
+constexpr uint64_t batch_deadline_ns = 20'000'000;
+constexpr uint64_t poll_ns = 1'000'000;
+// max allowable relative difference between a batched reply and the same request run alone (rounding only)
+constexpr float epsilon = 1e-5;
+
+/*
+ * Class Name: TestClient
+ * Description: The client end of a connection, non-blocking, so that the
+ *              server can run on the same thread.
+ */
+struct TestClient
+{
+  LocalStreamSocket socket;
+  string unsent {};
+  string received {};
+  vector<Request> sent {};
+
+  explicit TestClient( LocalStreamSocket&& s )
+    : socket( move( s ) )
+  {
+    socket.set_blocking( false );
+  }
+
+  void send( const Request& request )
+  {
+    sent.push_back( request );
+    unsent.append( reinterpret_cast<const char*>( &request ), sizeof( request ) );
+    flush();
+  }
+
+  void flush() { unsent.erase( 0, socket.write_some( unsent ) ); }
+
+  void receive()
+  {
+    string buffer( 64 * 1024, 0 );
+    received.append( buffer.data(), socket.read( { buffer.data(), buffer.size() } ) );
+  }
+
+  size_t num_responses() const { return received.size() / sizeof( Response ); }
+
+  Response response( const size_t i ) const
+  {
+    Response r;
+    memcpy( &r, received.data() + i * sizeof( Response ), sizeof( Response ) );
+    return r;
+  }
+};
+
+Request make_request( const unsigned int i )
+{
+  Request request;
+  for ( unsigned int j = 0; j < input_size; j++ ) {
+    request.input[j] = ( 0.25 + ( i % 97 ) / 97.0 ) * j;
+  }
+  return request;
+}
+
+/* the largest relative difference between the client's responses and its requests run alone */
+float max_reply_diff( TinyNetwork<1>& reference, const TestClient& client )
+{
+  float max_diff = 0;
+  for ( size_t i = 0; i < client.num_responses(); i++ ) {
+    reference.apply( Map<const Matrix<float, 1, input_size>>( client.sent.at( i ).input.data() ) );
+    const float expected = reference.output()( 0, 0 );
+    max_diff = max( max_diff, abs( expected - client.response( i ).output[0] ) / max( 1.0f, abs( expected ) ) );
+  }
+  return max_diff;
+}
+
+/* run the server until the client has n responses (or give up) */
+void serve_until( InferenceServer<Batched>& server, TestClient& client, const size_t n )
+{
+  for ( unsigned int i = 0; i < 1000 and client.num_responses() < n; i++ ) {
+    client.flush();
+    server.poll_once( poll_ns );
+    client.receive();
+  }
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto reference = make_unique<TinyNetwork<1>>();
+  reference->initializeWeightsRandomly( rng );
+  Batched batched { [&]( auto batch_size ) {
+    auto network = make_unique<TinyNetwork<batch_size>>();
+    copy_parameters( *reference, *network );
+    return network;
+  } };
+
+  const string path = "/tmp/nnfun_inferenceservertest1_" + to_string( getpid() ) + ".sock";
+  LocalStreamSocket listener;
+  listener.bind( path );
+  listener.listen();
+  InferenceServer<Batched> server { batched, move( listener ), batch_deadline_ns };
+
+  /* a full batch is run as soon as it is queued */
+  LocalStreamSocket connecting;
+  connecting.connect( path );
+  unlink( path.c_str() );
+  TestClient client { move( connecting ) };
+  for ( unsigned int i = 0; i < Batched::max_batch_size; i++ ) {
+    client.send( make_request( i ) );
+  }
+  serve_until( server, client, Batched::max_batch_size );
+  const bool full_batch_ok = client.num_responses() == Batched::max_batch_size and server.stats().batches == 1
+                             and server.stats().deadline_batches == 0;
+
+  /* a partial batch waits for the deadline */
+  for ( unsigned int i = 0; i < 3; i++ ) {
+    client.send( make_request( 10 + i ) );
+  }
+  server.poll_once( 0 );
+  server.poll_once( 0 );
+  client.receive();
+  const bool waited = client.num_responses() == Batched::max_batch_size and server.queued() == 3;
+  serve_until( server, client, Batched::max_batch_size + 3 );
+  const bool deadline_ok = waited and client.num_responses() == Batched::max_batch_size + 3
+                           and server.stats().deadline_batches == 1;
+
+  /* a client that stops reading does not hold up the others */
+  auto [slow_server_end, slow_client_end] = LocalStreamSocket::make_pair();
+  const int small_buffer = 4096;
+  const int fd = slow_server_end.fd_num();
+  CheckSystemCall( "setsockopt", setsockopt( fd, SOL_SOCKET, SO_SNDBUF, &small_buffer, sizeof( small_buffer ) ) );
+  server.add_client( move( slow_server_end ) );
+  TestClient slow { move( slow_client_end ) };
+  constexpr unsigned int slow_requests = 20000;
+  for ( unsigned int i = 0; i < slow_requests; i++ ) {
+    slow.send( make_request( i ) );
+    if ( slow.unsent.size() > 64 * 1024 ) {
+      server.poll_once( 0 );
+    }
+  }
+  for ( unsigned int i = 0; i < 1000 and ( not slow.unsent.empty() or server.queued() > 0 ); i++ ) {
+    slow.flush();
+    server.poll_once( poll_ns );
+  }
+
+  client.send( make_request( 99 ) );
+  serve_until( server, client, Batched::max_batch_size + 4 );
+  const size_t backlog = server.buffered_output();
+  const bool not_held_up = client.num_responses() == Batched::max_batch_size + 4 and backlog > 0;
+
+  /* the slow client still gets all its replies, in order, once it reads */
+  serve_until( server, slow, slow_requests );
+  const bool slow_ok = slow.num_responses() == slow_requests and server.buffered_output() == 0;
+
+  const float diff = max( max_reply_diff( *reference, client ), max_reply_diff( *reference, slow ) );
+
+  cout << "full batch " << full_batch_ok << ", deadline batch " << deadline_ok << ", other client answered with "
+       << backlog << " bytes buffered for the slow one " << not_held_up << ", slow client got "
+       << slow.num_responses() << " replies " << slow_ok << "; " << server.stats().requests << " requests in "
+       << server.stats().batches << " batches; max diff from unbatched " << diff << endl;
+
+  if ( not full_batch_ok or not deadline_ok or not not_held_up or not slow_ok or not( diff < epsilon ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,91 @@
+#include "eigen.hh"
+#include "lookup_table.hh"
+#include "network.hh"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int batch_size = 4;
+constexpr float lo = -4;
+constexpr float hi = 4;
+// max allowable difference between a table from breakpoints and its network (float rounding only)
+constexpr double exact_epsilon = 1e-5;
+constexpr double merge_tolerance = 1e-2;
+constexpr double sample_tolerance = 1e-4;
+
+using Net = Network<float, batch_size, 1, 24, 24, 1>;
+
+template<class Act>
+LookupTableReport compile_and_check( Net& nn, const LookupTableOptions& options )
+{
+  const LookupTable<float> table = LookupTable<float>::compile<Act>( nn, lo, hi, options );
+  const LookupTableReport report = checkLookupTable<Act>( table, nn, options );
+  report.summary( cout );
+
+  /* a batch evaluated into a caller's buffer matches the table point by point */
+  const Matrix<float, 3, 2> inputs = Matrix<float, 6, 1>::LinSpaced( lo - 0.1, hi + 0.1 ).reshaped( 3, 2 );
+  Matrix<float, 3, 2> outputs;
+  table.apply_into( inputs, outputs );
+  for ( Index i = 0; i < inputs.size(); i++ ) {
+    if ( outputs( i ) != table( inputs( i ) ) ) {
+      throw runtime_error( "test failure" );
+    }
+  }
+
+  /* inputs far outside the range (beyond what size_t holds) extend the end segments */
+  for ( const float far : { 1e30f, -1e30f } ) {
+    const double step = double( table( 2 * far ) ) - table( far );
+    const double next_step = double( table( 4 * far ) ) - table( 2 * far );
+    if ( not( abs( next_step - 2 * step ) <= 1e-3 * abs( next_step ) ) ) {
+      throw runtime_error( "test failure" );
+    }
+  }
+  table( numeric_limits<float>::infinity() );
+  table( -numeric_limits<float>::infinity() );
+  return report;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto nn = make_unique<Net>();
+  nn->initializeWeightsRandomly( rng );
+
+  /* ReLU and LeakyReLU networks compile exactly (tolerance 0: no segments merged) */
+  LookupTableOptions options;
+  options.tolerance = 0;
+  const LookupTableReport relu = compile_and_check<activation::ReLU>( *nn, options );
+  const LookupTableReport leaky = compile_and_check<activation::LeakyReLU>( *nn, options );
+
+  /* merging segments within a tolerance keeps the error within it */
+  options.tolerance = merge_tolerance;
+  const LookupTableReport merged = compile_and_check<activation::ReLU>( *nn, options );
+
+  /* GELU networks are sampled to the tolerance */
+  options.tolerance = sample_tolerance;
+  options.initial_segments = 4;
+  const LookupTableReport gelu = compile_and_check<activation::GELU>( *nn, options );
+
+  if ( not relu.exact or not( relu.max_abs_error < exact_epsilon ) or not( leaky.max_abs_error < exact_epsilon )
+       or not( merged.segments < relu.segments ) or not( merged.max_abs_error < merge_tolerance + exact_epsilon )
+       or gelu.exact or not( gelu.max_abs_error < 2 * sample_tolerance ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,140 @@
+#include "eigen.hh"
+#include "matrix_view.hh"
+#include "network.hh"
+#include "sequential_network.hh"
+#include "typed_ring_buffer.hh"
+#include "weight_image.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int batch_size = 4;
+constexpr unsigned int input_size = 16;
+constexpr unsigned int output_size = 3;
+// max allowable difference between a pass over a view and one over a copy (row-major vs column-major input)
+constexpr float epsilon = 1e-5;
+const string image_filename = "matrixviewtest1.nnw";
+
+using Net = Network<float, batch_size, input_size, 24, output_size>;
+using Mapped = MappedNetwork<float, batch_size, input_size, 24, output_size>;
+using TanhOutput = SequentialNetwork<float,
+                                     batch_size,
+                                     FullyConnected<input_size, 24, activation::GELU>,
+                                     FullyConnected<24, output_size, activation::Tanh>>;
+
+template<class A, class B>
+float max_diff( const MatrixBase<A>& a, const MatrixBase<B>& b )
+{
+  return ( a - b ).cwiseAbs().maxCoeff();
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  uniform_real_distribution<float> input_dist( -1, 1 );
+
+  /* a batch of samples in ring storage, wrapping around its end */
+  TypedRingBuffer<float> ring { 4096 };
+  ring.push( ring.capacity() - 10 );
+  ring.pop( ring.capacity() - 10 );
+  span<float> writable = ring.writable_region();
+  for ( unsigned int i = 0; i < batch_size * input_size; i++ ) {
+    writable[i] = input_dist( rng );
+  }
+  ring.push( batch_size * input_size );
+
+  const auto view = as_matrix<batch_size, input_size>( ring.readable_region() );
+
+  /* the copy a caller would otherwise make */
+  Matrix<float, batch_size, input_size> copy;
+  for ( unsigned int b = 0; b < batch_size; b++ ) {
+    for ( unsigned int i = 0; i < input_size; i++ ) {
+      copy( b, i ) = ring.readable_region()[b * input_size + i];
+    }
+  }
+
+  auto net = make_unique<Net>();
+  net->initializeWeightsRandomly( rng );
+  net->apply( copy );
+  const Matrix<float, batch_size, output_size> expected = net->output();
+
+  /* the network reads the ring buffer in place */
+  net->apply( view );
+  const float view_diff = max_diff( net->output(), expected );
+
+  /* and writes its output into the caller's buffer */
+  vector<float> results( batch_size * output_size );
+  net->apply_into( view, as_mutable_matrix<batch_size, output_size>( span<float>( results.data(), results.size() ) ) );
+  const float into_diff = max_diff( ConstMatrixView<float, batch_size, output_size>( results.data() ), expected );
+
+  /* a block of a wider matrix is read in place too */
+  Matrix<float, batch_size, input_size + 1> wider;
+  wider << Matrix<float, batch_size, 1>::Zero(), copy;
+  net->apply( wider.rightCols<input_size>() );
+  const float block_diff = max_diff( net->output(), expected );
+
+  /* a single sample, viewed as a 1 x input_size matrix */
+  auto single = make_unique<Network<float, 1, input_size, 24, output_size>>();
+  single->initializeWeightsRandomly( rng );
+  single->apply( copy.row( 2 ) );
+  const Matrix<float, 1, output_size> single_expected = single->output();
+  single->apply( as_matrix<1, input_size>( ring.readable_region().substr( 2 * input_size, input_size ) ) );
+  const float single_diff = max_diff( single->output(), single_expected );
+
+  /* MappedNetwork, from an image of net */
+  writeWeightImage( *net, image_filename );
+  const WeightImage image { image_filename };
+  auto mapped = make_unique<Mapped>( image );
+  mapped->apply( view );
+  const float mapped_diff = max_diff( mapped->output(), expected );
+  Matrix<float, batch_size, output_size, RowMajor> mapped_results;
+  mapped->apply_into( view, mapped_results );
+  const float mapped_into_diff = max_diff( mapped_results, expected );
+  remove( image_filename.c_str() );
+
+  /* apply_into applies the activation of a SequentialNetwork's last layer */
+  auto tanh_output = make_unique<TanhOutput>();
+  tanh_output->initializeWeightsRandomly( rng );
+  tanh_output->apply( copy );
+  Matrix<float, batch_size, output_size> tanh_results;
+  tanh_output->apply_into( view, tanh_results );
+  const float sequential_diff = max_diff( tanh_results, tanh_output->output() );
+
+  /* a span of the wrong size is refused */
+  bool size_checked = false;
+  try {
+    as_matrix<batch_size, input_size>( ring.readable_region().substr( 0, input_size ) );
+  } catch ( const runtime_error& e ) {
+    size_checked = true;
+  }
+
+  cout << "max diff from a copy: view " << view_diff << ", into " << into_diff << ", block " << block_diff
+       << ", single " << single_diff << ", mapped " << mapped_diff << ", mapped into " << mapped_into_diff
+       << ", sequential " << sequential_diff << "; size checked " << size_checked << endl;
+
+  for ( const float diff :
+        { view_diff, into_diff, block_diff, single_diff, mapped_diff, mapped_into_diff, sequential_diff } ) {
+    if ( not( diff < epsilon ) ) {
+      throw runtime_error( "test failure: view differs from copy" );
+    }
+  }
+  if ( not size_checked ) {
+    throw runtime_error( "test failure: size not checked" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
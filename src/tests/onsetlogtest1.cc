@@ -0,0 +1,155 @@
+#include "onset_log.hh"
+#include "tempo_stream.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace tempo_stream;
+
+const vector<float> tempos { 60, 97.5, 143, 0 };
+// more records than OnsetLogWriter buffers, so the log is written in several pieces
+constexpr unsigned int onsets_per_stream = 40000;
+// max allowable difference (seconds) between a replayed window and the onset times it should hold (float rounding)
+constexpr float window_epsilon = 1e-6;
+
+/* beat k of stream s, in ns after the first onset (a stream of unknown tempo plays at 120 bpm) */
+uint64_t beat_ns( const size_t stream, const uint64_t k )
+{
+  const double tempo = tempos[stream] > 0 ? tempos[stream] : 120;
+  return llround( k * 60e9 / tempo ) + stream; /* offset so no two streams' onsets coincide */
+}
+
+struct Beat
+{
+  uint64_t time_ns;
+  uint32_t stream;
+  uint64_t k;
+};
+
+/* the onsets of all streams, in the order they happen */
+vector<Beat> make_beats()
+{
+  vector<Beat> beats;
+  for ( size_t s = 0; s < tempos.size(); s++ ) {
+    for ( uint64_t k = 0; k < onsets_per_stream; k++ ) {
+      beats.push_back( { beat_ns( s, k ), uint32_t( s ), k } );
+    }
+  }
+  sort( beats.begin(), beats.end(), []( const Beat& a, const Beat& b ) { return a.time_ns < b.time_ns; } );
+  return beats;
+}
+
+/* the log keeps the streams' tempos, and every onset's stream and (relative) time, in order */
+bool check_log( const OnsetLog& log, const vector<Beat>& beats )
+{
+  if ( log.num_streams() != tempos.size() or log.size() != beats.size() ) {
+    return false;
+  }
+  for ( size_t s = 0; s < tempos.size(); s++ ) {
+    if ( log.tempo( s ) != tempos[s] ) {
+      return false;
+    }
+  }
+
+  /* times are relative to when the writer was opened, so compare them from the first onset */
+  for ( size_t i = 0; i < beats.size(); i++ ) {
+    const onset_log::Onset onset = log[i];
+    if ( onset.stream != beats[i].stream or onset.time_ns - log[0].time_ns != beats[i].time_ns ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* replaying the log fills each stream's window after window_size onsets, with the window of its last onsets */
+bool check_replay( const OnsetLog& log, const vector<Beat>& beats )
+{
+  OnsetReplayer replayer { log.num_streams(), Timer::timestamp_ns() };
+  size_t windows = 0;
+  float max_diff = 0;
+  for ( size_t i = 0; i < log.size(); i++ ) {
+    const Beat& beat = beats[i];
+    const bool full = replayer.feed( log[i], Timer::timestamp_ns() );
+    if ( full != ( beat.k + 1 >= window_size ) ) {
+      return false;
+    }
+    if ( not full ) {
+      continue;
+    }
+
+    windows++;
+    const Eigen::Matrix<float, 1, window_size> window = replayer.parser( beat.stream ).window();
+    const uint64_t first = beat_ns( beat.stream, beat.k + 1 - window_size );
+    for ( unsigned int j = 0; j < window_size; j++ ) {
+      const float expected = ( beat_ns( beat.stream, beat.k + 1 - window_size + j ) - first ) / 1e9;
+      max_diff = max( max_diff, abs( window( j ) - expected ) );
+    }
+  }
+
+  cout << "replayed " << windows << " windows, max diff " << max_diff << " s" << endl;
+  return windows == tempos.size() * ( onsets_per_stream - window_size + 1 ) and max_diff < window_epsilon;
+}
+
+void program_body()
+{
+  const string filename = "/tmp/nnfun_onsetlogtest1_" + to_string( getpid() ) + ".log";
+  const vector<Beat> beats = make_beats();
+
+  uint64_t num_records;
+  {
+    OnsetLogWriter writer { filename, tempos };
+    const uint64_t start = Timer::timestamp_ns();
+    for ( const Beat& beat : beats ) {
+      writer.record( beat.stream, start + beat.time_ns );
+      if ( writer.wants_flush() ) {
+        writer.flush();
+      }
+    }
+    num_records = writer.num_records();
+  }
+
+  bool log_ok, replay_ok;
+  {
+    const OnsetLog log { filename };
+    log_ok = num_records == beats.size() and check_log( log, beats );
+    replay_ok = check_replay( log, beats );
+  }
+
+  /* a truncated last record is ignored */
+  ofstream( filename, ios::app ).write( "\1\2\3\4\5", 5 );
+  const bool truncated_ok = OnsetLog { filename }.size() == beats.size();
+
+  /* a file that is not an onset log is refused */
+  ofstream( filename, ios::trunc ) << "not a log";
+  bool refused = false;
+  try {
+    const OnsetLog log { filename };
+  } catch ( const runtime_error& ) {
+    refused = true;
+  }
+  unlink( filename.c_str() );
+
+  cout << "log read back " << log_ok << ", replay " << replay_ok << ", truncated record ignored " << truncated_ok
+       << ", other file refused " << refused << endl;
+
+  if ( not log_ok or not replay_ok or not truncated_ok or not refused ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
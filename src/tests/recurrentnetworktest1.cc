@@ -0,0 +1,167 @@
+#include "eigen.hh"
+#include "gradient_check.hh"
+#include "recurrent_network.hh"
+
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int batch_size = 2;
+constexpr unsigned int window_size = 6;
+constexpr unsigned int event_size = 2;
+// max allowable difference between streaming and window outputs (rounding only)
+constexpr double streaming_epsilon = 1e-12;
+// step of the central differences, and the max allowable difference from them
+constexpr double finite_difference_step = 1e-6;
+constexpr double gradient_epsilon = 1e-7;
+
+using Recurrent = RecurrentNetwork<double, batch_size, window_size, event_size, 5, 4, 1>;
+
+/* online training, one event at a time, to output the first coordinate of the event `lag` events ago */
+double remembered_loss_ratio()
+{
+  constexpr unsigned int lag = 3;
+  constexpr unsigned int num_events = 20000;
+  constexpr unsigned int report_events = 1000;
+
+  mt19937 rng( 1 );
+  uniform_real_distribution<double> event_dist( -1, 1 );
+  auto net = make_unique<RecurrentNetwork<double, 1, 8, 1, 16, 1>>();
+  net->initializeWeightsRandomly( rng );
+
+  deque<double> history;
+  double first_loss = 0, last_loss = 0;
+  for ( unsigned int n = 0; n < num_events; n++ ) {
+    const Matrix<double, 1, 1> event = Matrix<double, 1, 1>::Constant( event_dist( rng ) );
+    history.push_back( event( 0, 0 ) );
+    net->step( event );
+    if ( history.size() <= lag ) {
+      continue;
+    }
+    const double error = net->output()( 0, 0 ) - history.front();
+    history.pop_front();
+
+    if ( n < report_events ) {
+      first_loss += error * error;
+    } else if ( n >= num_events - report_events ) {
+      last_loss += error * error;
+    }
+    net->computeDeltas( Matrix<double, 1, 1>::Constant( error ) );
+    net->evaluateGradients();
+    for ( unsigned int i = 0; i < net->getNumLayers(); i++ ) {
+      net->modifyParamWholeLayer( i, 0.05 );
+    }
+  }
+  cout << "online training, mean squared error of the first " << report_events << " events "
+       << first_loss / report_events << ", of the last " << report_events << " " << last_loss / report_events
+       << endl;
+  return last_loss / first_loss;
+}
+
+/* the largest difference between the GRU's truncated BPTT gradients and central differences of the loss over the
+   window's events, fed one at a time from the state of `before` */
+template<class GRU>
+double truncated_gradient_diff( const Recurrent& before,
+                                const Matrix<double, batch_size, Recurrent::input_size>& window,
+                                const GRU& trained )
+{
+  const auto loss = [&]( const unsigned int param, const double step ) {
+    auto net = make_unique<Recurrent>( before );
+    net->gru.perturbWeight( param, step );
+    for ( unsigned int t = 0; t < window_size; t++ ) {
+      net->apply_streaming( window.middleCols<event_size>( t * event_size ) );
+    }
+    return net->output().sum() / batch_size;
+  };
+
+  double max_diff = 0;
+  for ( unsigned int i = 0; i < trained.getNumParams(); i++ ) {
+    const double numerical
+      = ( loss( i, finite_difference_step ) - loss( i, -finite_difference_step ) ) / ( 2 * finite_difference_step );
+    max_diff = max( max_diff, abs( numerical - trained.getEvaluatedGradient( i ) ) );
+  }
+  return max_diff;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto net = make_unique<Recurrent>();
+  net->initializeWeightsRandomly( rng );
+
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  const Matrix<double, batch_size, Recurrent::input_size> window
+    = Matrix<double, batch_size, Recurrent::input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* backprop through time over the window matches numerical gradients of every parameter */
+  const GradientCheckResult result = checkGradients( *net, window );
+  result.summary( cout );
+
+  /* feeding the window one event at a time gives the same output, with or without recording */
+  net->apply( window );
+  const Matrix<double, batch_size, 1> window_output = net->output();
+  net->resetState();
+  for ( unsigned int t = 0; t < window_size; t++ ) {
+    net->apply_streaming( window.middleCols<event_size>( t * event_size ) );
+  }
+  const double streaming_diff = ( net->output() - window_output ).cwiseAbs().maxCoeff();
+  net->resetState();
+  for ( unsigned int t = 0; t < window_size; t++ ) {
+    net->step( window.middleCols<event_size>( t * event_size ) );
+  }
+  const double step_diff = ( net->output() - window_output ).cwiseAbs().maxCoeff();
+
+  /* and the recorded steps give the window's gradients */
+  auto windowed = make_unique<Recurrent>( *net );
+  windowed->apply( window );
+  windowed->computeDeltas();
+  windowed->evaluateGradients( window );
+  net->computeDeltas();
+  net->evaluateGradients();
+  const double gradient_diff = ( net->gru.grad_weights() - windowed->gru.grad_weights() ).cwiseAbs().maxCoeff();
+
+  /* a long stream keeps only window_size steps: its gradients are those of the last window_size events, from the
+     state before them held constant */
+  for ( unsigned int t = 0; t < 3 * window_size; t++ ) {
+    net->step( window.middleCols<event_size>( ( t % window_size ) * event_size ) );
+  }
+  const auto before_window = make_unique<Recurrent>( *net );
+  for ( unsigned int t = 0; t < window_size; t++ ) {
+    net->step( window.middleCols<event_size>( t * event_size ) );
+  }
+  net->computeDeltas();
+  net->evaluateGradients();
+  const bool truncated = net->gru.numSteps() == 5 * window_size;
+  const double truncated_diff = truncated_gradient_diff( *before_window, window, net->gru );
+
+  /* streaming without recording forgets the recorded steps */
+  net->apply_streaming( window.middleCols<event_size>( 0 ) );
+  const bool forgotten = net->gru.numSteps() == 0;
+
+  cout << "max diff from window: streaming " << streaming_diff << ", recorded " << step_diff << ", gradients "
+       << gradient_diff << "; truncated " << truncated << " (max diff from numerical gradients " << truncated_diff
+       << "), recorded steps forgotten by apply_streaming " << forgotten << endl;
+
+  const double loss_ratio = remembered_loss_ratio();
+
+  if ( not result.passed() or not( streaming_diff < streaming_epsilon ) or not( step_diff < streaming_epsilon )
+       or not( gradient_diff < streaming_epsilon ) or not truncated or not( truncated_diff < gradient_epsilon )
+       or not forgotten or not( loss_ratio < 0.05 ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
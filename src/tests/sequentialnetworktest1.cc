@@ -0,0 +1,84 @@
+#include "activation_check.hh"
+#include "eigen.hh"
+#include "gradient_check.hh"
+#include "network.hh"
+#include "sequential_network.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 3;
+constexpr size_t input_size = 8;
+// max allowable error of an activation's derivative against a finite difference
+constexpr double derivative_epsilon = 1e-7;
+
+using Mixed = SequentialNetwork<double,
+                                batch_size,
+                                FullyConnected<input_size, 8, activation::GELU>,
+                                FullyConnected<8, 6, activation::Tanh>,
+                                FullyConnected<6, 5, activation::Sigmoid>,
+                                FullyConnected<5, 4, activation::LeakyReLU>,
+                                FullyConnected<4, 2, activation::Identity>>;
+
+using ReLUSequential = SequentialNetwork<double,
+                                         batch_size,
+                                         FullyConnected<input_size, 6, activation::ReLU>,
+                                         FullyConnected<6, 3, activation::Identity>>;
+
+void program_body()
+{
+  /* every policy's derivative matches a central difference of its forward pass (away from kinks) */
+  const ArrayXd z = ArrayXd::LinSpaced( 81, -4.05, 3.95 );
+  const double h = 1e-6;
+  if ( not check_derivative<activation::ReLU>( "ReLU", z, h, derivative_epsilon )
+       or not check_derivative<activation::LeakyReLU>( "LeakyReLU", z, h, derivative_epsilon )
+       or not check_derivative<activation::GELU>( "GELU", z, h, derivative_epsilon )
+       or not check_derivative<activation::Tanh>( "Tanh", z, h, derivative_epsilon )
+       or not check_derivative<activation::Sigmoid>( "Sigmoid", z, h, derivative_epsilon )
+       or not check_derivative<activation::Identity>( "Identity", z, h, derivative_epsilon ) ) {
+    throw runtime_error( "test failure: activation derivative" );
+  }
+
+  mt19937 rng( 0 );
+  uniform_real_distribution<double> input_dist( -1, 1 );
+  const Matrix<double, batch_size, input_size> input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* backprop through mixed activations matches numerical gradients of every parameter */
+  auto mixed = make_unique<Mixed>();
+  mixed->initializeWeightsRandomly( rng );
+  const GradientCheckResult result = checkGradients( *mixed, input );
+  result.summary( cout );
+
+  /* ReLU hidden layers and an identity output are the same function as Network */
+  auto sequential = make_unique<ReLUSequential>();
+  auto network = make_unique<Network<double, batch_size, input_size, 6, 3>>();
+  sequential->initializeWeightsRandomly( rng );
+  network->layer0.weights() = sequential->layer0.weights();
+  network->layer0.biases() = sequential->layer0.biases();
+  network->next.layer0.weights() = sequential->next.layer0.weights();
+  network->next.layer0.biases() = sequential->next.layer0.biases();
+  sequential->apply( input );
+  network->apply( input );
+  const double network_diff = ( sequential->output() - network->output() ).cwiseAbs().maxCoeff();
+  cout << "max diff from Network: " << network_diff << endl;
+
+  if ( not result.passed() or network_diff != 0 ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
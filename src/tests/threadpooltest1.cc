@@ -0,0 +1,154 @@
+#include "eigen.hh"
+#include "network.hh"
+#include "thread_pool.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int pool_size = 4;
+constexpr unsigned int batch_size = 2;
+constexpr unsigned int input_size = 8;
+// at least parallel_layer_weights weights in the middle layer, and not a multiple of column_block
+constexpr unsigned int width = 1040;
+// max allowable relative difference between the wide layer and the same products in one piece (rounding only)
+constexpr double epsilon = 1e-9;
+
+// the middle layer is split across the pool
+using Wide = Network<double, batch_size, input_size, width, width, 1>;
+
+// as many weights, but too deep for fitsColumnBlock: it must build, and compute its products in one piece
+constexpr unsigned int deep_size = 4096;
+constexpr unsigned int deep_outputs = parallel_layer_weights / deep_size;
+using Deep = Layer<double, 1, deep_size, deep_outputs>;
+
+/* the number of tasks that did not run exactly once, over many parallel_for calls */
+unsigned int count_wrong_tasks( ThreadPool& pool, const unsigned int calls )
+{
+  unsigned int wrong = 0;
+  for ( unsigned int call = 0; call < calls; call++ ) {
+    const unsigned int num_tasks = 1 + call % 13;
+    vector<atomic<unsigned int>> runs( num_tasks );
+    pool.parallel_for( num_tasks, [&]( const unsigned int task ) { runs[task]++; } );
+    for ( const auto& r : runs ) {
+      wrong += r != 1;
+    }
+  }
+  return wrong;
+}
+
+/* the number of tasks that ran on another thread than the caller's: from a task, and from a run-inline thread */
+unsigned int count_moved_tasks( ThreadPool& pool )
+{
+  atomic<unsigned int> moved { 0 };
+  pool.parallel_for( pool_size, [&]( const unsigned int ) {
+    const thread::id outer = this_thread::get_id();
+    pool.parallel_for( pool_size, [&]( const unsigned int ) { moved += this_thread::get_id() != outer; } );
+  } );
+
+  thread inline_caller { [&] {
+    ThreadPool::run_inline_on_this_thread();
+    const thread::id caller = this_thread::get_id();
+    pool.parallel_for( pool_size, [&]( const unsigned int ) { moved += this_thread::get_id() != caller; } );
+  } };
+  inline_caller.join();
+  return moved;
+}
+
+double relative_diff( const MatrixXd& a, const MatrixXd& b )
+{
+  return ( a - b ).cwiseAbs().maxCoeff() / max( 1.0, b.cwiseAbs().maxCoeff() );
+}
+
+void program_body()
+{
+  /* the pool runs every task exactly once, also with calls from several threads at a time */
+  ThreadPool pool { pool_size };
+  const unsigned int wrong_tasks = count_wrong_tasks( pool, 1000 );
+  unsigned int concurrent_wrong_tasks = 0;
+  {
+    vector<unsigned int> wrong( 3 );
+    vector<thread> callers;
+    for ( unsigned int i = 0; i < wrong.size(); i++ ) {
+      callers.emplace_back( [&, i] { wrong[i] = count_wrong_tasks( pool, 300 ); } );
+    }
+    for ( auto& caller : callers ) {
+      caller.join();
+    }
+    for ( const unsigned int w : wrong ) {
+      concurrent_wrong_tasks += w;
+    }
+  }
+  const unsigned int moved_tasks = count_moved_tasks( pool );
+
+  /* a wide layer split across the layers' pool matches the same products computed in one piece */
+  setenv( "NN_LAYER_THREADS", to_string( pool_size ).c_str(), 1 );
+  mt19937 rng( 0 );
+  auto nn = make_unique<Wide>();
+  nn->initializeWeightsRandomly( rng );
+  nn->next.layer0.weights() /= width;
+  const MatrixXd input = MatrixXd::Random( batch_size, input_size );
+
+  nn->apply( input );
+  nn->computeDeltas();
+  nn->evaluateGradients( input );
+
+  const auto& l0 = nn->layer0;
+  const auto& l1 = nn->next.layer0;
+  const auto& l2 = nn->next.next.layer0;
+  const MatrixXd z0 = ( input * l0.weights() ).rowwise() + l0.biases();
+  const MatrixXd a0 = z0.cwiseMax( 0 );
+  const MatrixXd z1 = ( a0 * l1.weights() ).rowwise() + l1.biases();
+  const MatrixXd a1 = z1.cwiseMax( 0 );
+  const MatrixXd out = ( a1 * l2.weights() ).rowwise() + l2.biases();
+
+  const MatrixXd d2 = MatrixXd::Ones( batch_size, 1 ) / batch_size;
+  const MatrixXd d1 = ( d2 * l2.weights().transpose() ).array() * ( z1.array() > 0 ).cast<double>();
+  const MatrixXd d0 = ( d1 * l1.weights().transpose() ).array() * ( z0.array() > 0 ).cast<double>();
+
+  const double output_diff = max( relative_diff( l1.output(), a1 ), relative_diff( nn->output(), out ) );
+  const double delta_diff = max( relative_diff( l1.deltas(), d1 ), relative_diff( l0.deltas(), d0 ) );
+  const double gradient_diff = max( relative_diff( l1.grad_weights(), a0.transpose() * d1 ),
+                                    relative_diff( l1.grad_biases(), d1.colwise().sum() ) );
+
+  auto deep = make_unique<Deep>();
+  deep->initializeWeightsRandomly( rng );
+  const MatrixXd deep_input = MatrixXd::Random( 1, deep_size );
+  deep->apply( deep_input );
+  const MatrixXd deep_input_deltas = deep->computeDeltas( Matrix<double, 1, deep_outputs>::Ones() );
+  deep->evaluateGradients( deep_input );
+
+  const MatrixXd deep_z = ( deep_input * deep->weights() ).rowwise() + deep->biases();
+  const MatrixXd deep_d = ( deep_z.array() > 0 ).cast<double>();
+  const double deep_diff = max( { relative_diff( deep->output(), deep_z.cwiseMax( 0 ) ),
+                                  relative_diff( deep_input_deltas, deep_d * deep->weights().transpose() ),
+                                  relative_diff( deep->grad_weights(), deep_input.transpose() * deep_d ) } );
+
+  cout << "pool of " << pool.size() << " threads: " << wrong_tasks << " wrong tasks, " << concurrent_wrong_tasks
+       << " with concurrent callers, " << moved_tasks << " moved off a task or run-inline thread; layers' pool of "
+       << ThreadPool::layers().size() << " threads: output diff " << output_diff << ", delta diff " << delta_diff
+       << ", gradient diff " << gradient_diff << "; unsplit deep layer diff " << deep_diff << endl;
+
+  if ( wrong_tasks != 0 or concurrent_wrong_tasks != 0 or moved_tasks != 0 or ThreadPool::layers().size() != pool_size
+       or not( output_diff < epsilon ) or not( delta_diff < epsilon ) or not( gradient_diff < epsilon )
+       or not( deep_diff < epsilon ) ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,80 @@
+#include "timer.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/* every duration lands in a bucket whose range contains it, and buckets are contiguous */
+bool test_buckets()
+{
+  for ( const uint64_t value : vector<uint64_t> { 0, 1, 15, 16, 17, 31, 32, 1000, 123456789, UINT64_MAX } ) {
+    const size_t index = Timer::Histogram::bucket( value );
+    const uint64_t lowest = index == 0 ? 0 : Timer::Histogram::bucket_max( index - 1 ) + 1;
+    if ( index >= Timer::Histogram::num_buckets or value < lowest or value > Timer::Histogram::bucket_max( index ) ) {
+      cout << "value " << value << " is outside its bucket " << index << endl;
+      return false;
+    }
+  }
+  return Timer::Histogram::bucket_max( Timer::Histogram::num_buckets - 1 ) == UINT64_MAX;
+}
+
+/* percentiles of a known distribution are within a bucket's width (1/16) of the exact ones */
+bool test_percentiles()
+{
+  mt19937 rng( 0 );
+  lognormal_distribution<double> dist( 10, 1.5 );
+
+  Timer::Record record {};
+  record.enable_histogram();
+  vector<uint64_t> values;
+  for ( unsigned int i = 0; i < 100000; i++ ) {
+    values.push_back( dist( rng ) );
+    record.log( values.back() );
+  }
+  sort( values.begin(), values.end() );
+
+  for ( const double q : { 0.5, 0.9, 0.99, 0.999 } ) {
+    const uint64_t exact = values.at( size_t( ceil( q * values.size() ) ) - 1 );
+    const uint64_t estimate = record.percentile( q );
+    cout << "p" << q * 100 << ": exact " << exact << ", histogram " << estimate << endl;
+    if ( estimate < exact or estimate > exact + exact / Timer::Histogram::sub_buckets ) {
+      return false;
+    }
+  }
+  return record.percentile( 1 ) == values.back();
+}
+
+/* merging per-thread records gives the same percentiles as logging everything into one */
+bool test_merge()
+{
+  Timer::Record all {}, even {}, odd {};
+  all.enable_histogram();
+  even.enable_histogram();
+  odd.enable_histogram();
+  for ( uint64_t i = 1; i <= 10000; i++ ) {
+    all.log( i * 37 );
+    ( i % 2 ? odd : even ).log( i * 37 );
+  }
+  even.merge( odd );
+
+  return even.count == all.count and even.total_ns == all.total_ns and even.min_ns == all.min_ns
+         and even.max_ns == all.max_ns and even.percentile( 0.5 ) == all.percentile( 0.5 )
+         and even.percentile( 0.99 ) == all.percentile( 0.99 );
+}
+
+int main()
+{
+  try {
+    if ( not test_buckets() or not test_percentiles() or not test_merge() ) {
+      throw runtime_error( "test failure" );
+    }
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,223 @@
+#include "timer.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+using Category = Timer::Category;
+
+/* a nested scope's time counts toward its parent's inclusive time but not its exclusive time */
+bool test_nesting()
+{
+  Timer timer;
+  timer.start<Category::WaitingForEvent>( 1000 );
+  timer.start<Category::Nonblock>( 1100 );
+  timer.stop<Category::Nonblock>( 1400 );
+  timer.start<Category::Nonblock>( 1500 );
+  timer.stop<Category::Nonblock>( 1600 );
+  timer.stop<Category::WaitingForEvent>( 2000 );
+
+  const Timer::Record& outer = timer.record( Category::WaitingForEvent );
+  const Timer::Record& inner = timer.record( Category::Nonblock );
+  cout << "outer: " << outer.total_ns << " ns inclusive, " << timer.exclusive_ns( Category::WaitingForEvent )
+       << " ns exclusive; inner: " << inner.total_ns << " ns in " << inner.count << " scopes" << endl;
+
+  return outer.count == 1 and outer.total_ns == 1000 and timer.exclusive_ns( Category::WaitingForEvent ) == 600
+         and inner.count == 2 and inner.total_ns == 400 and timer.exclusive_ns( Category::Nonblock ) == 400
+         and timer.depth() == 0;
+}
+
+/* scopes must close in the order they opened */
+bool test_mismatched_stop()
+{
+  Timer timer;
+  timer.start<Category::WaitingForEvent>();
+  timer.start<Category::Nonblock>();
+  try {
+    timer.stop<Category::WaitingForEvent>();
+  } catch ( const runtime_error& e ) {
+    cout << "caught: " << e.what() << endl;
+    return true;
+  }
+  return false;
+}
+
+/* each thread times into its own timer, and the registry merges them all */
+bool test_threads()
+{
+  constexpr unsigned int num_threads = 4, scopes_per_thread = 1000;
+
+  reset_global_timer();
+  vector<thread> threads;
+  for ( unsigned int i = 0; i < num_threads; i++ ) {
+    threads.emplace_back( [] {
+      for ( unsigned int j = 0; j < scopes_per_thread; j++ ) {
+        GlobalScopeTimer<Category::WaitingForEvent> outer;
+        GlobalScopeTimer<Category::Nonblock> inner;
+      }
+    } );
+  }
+  for ( auto& t : threads ) {
+    t.join();
+  }
+
+  global_timer_summary( cout );
+  const Timer merged = merged_global_timer();
+  return merged.record( Category::WaitingForEvent ).count == num_threads * scopes_per_thread
+         and merged.record( Category::Nonblock ).count == num_threads * scopes_per_thread
+         and merged.record( Category::Nonblock ).histogram->count() == num_threads * scopes_per_thread;
+}
+
+/* a thread that starts after another exited takes over its entry, and the exited thread's records are kept */
+bool test_reuse_after_exit()
+{
+  reset_global_timer();
+  const ThreadTimer* first = nullptr;
+  const ThreadTimer* second = nullptr;
+  thread( [&] {
+    GlobalScopeTimer<Category::Nonblock> scope;
+    first = &this_thread_timer();
+  } ).join();
+  thread( [&] {
+    GlobalScopeTimer<Category::Nonblock> scope;
+    second = &this_thread_timer();
+  } ).join();
+
+  const Timer merged = merged_global_timer();
+  cout << "entries of two threads in a row: " << first << ", " << second << endl;
+  return first == second and merged.record( Category::Nonblock ).count == 2;
+}
+
+/* resetting while another thread is timing leaves that thread's timer consistent (it resets itself). A scope open
+   across the last reset is still logged, so the outer scope can have one more record than the inner one. */
+bool test_reset_while_running()
+{
+  atomic<bool> done { false };
+  uint64_t scopes = 0;
+  thread worker( [&] {
+    while ( not done.load() ) {
+      GlobalScopeTimer<Category::WaitingForEvent> outer;
+      GlobalScopeTimer<Category::Nonblock> inner;
+      scopes++;
+    }
+  } );
+  for ( unsigned int i = 0; i < 100; i++ ) {
+    reset_global_timer();
+    this_thread::yield();
+  }
+  done = true;
+  worker.join();
+
+  const Timer merged = merged_global_timer();
+  const uint64_t outer = merged.record( Category::WaitingForEvent ).count;
+  const uint64_t inner = merged.record( Category::Nonblock ).count;
+  cout << "after resets during " << scopes << " scopes: " << outer << " outer, " << inner << " inner" << endl;
+  return inner <= outer and outer <= inner + 1 and outer <= scopes;
+}
+
+/* merging while another thread is timing reads a snapshot that thread published between two starts or stops, so
+   the inner scope has at most one more record than the outer one */
+bool test_merge_while_running()
+{
+  reset_global_timer();
+  atomic<bool> started { false }, done { false };
+  thread worker( [&] {
+    while ( not done.load() ) {
+      {
+        GlobalScopeTimer<Category::WaitingForEvent> outer;
+        GlobalScopeTimer<Category::Nonblock> inner;
+      }
+      started = true;
+    }
+  } );
+  while ( not started.load() ) {
+    this_thread::yield();
+  }
+
+  /* a merge that finds the worker outside its inner scope does not wait for it, but it answers on its next stop */
+  bool consistent = true, answered = false;
+  uint64_t outer = 0, inner = 0;
+  for ( unsigned int i = 0; i < 100; i++ ) {
+    const Timer merged = merged_global_timer();
+    outer = merged.record( Category::WaitingForEvent ).count;
+    inner = merged.record( Category::Nonblock ).count;
+    consistent = consistent and outer <= inner and inner <= outer + 1;
+    answered = answered or outer > 0;
+    this_thread::sleep_for( chrono::microseconds( 100 ) ); /* let the worker run, also on a single CPU */
+  }
+  global_timer_summary( cout );
+  done = true;
+  worker.join();
+
+  cout << "merged while running: " << outer << " outer, " << inner << " inner, consistent " << consistent << endl;
+  return consistent and answered;
+}
+
+/* threads blocked in a wait, or not timing anything, are not waited for by merges or by a reset behind them */
+bool test_merge_while_blocked()
+{
+  mutex m;
+  condition_variable cv;
+  bool release = false;
+  const auto block = [&] {
+    unique_lock lock { m };
+    cv.wait( lock, [&] { return release; } );
+  };
+
+  thread waiting( [&] {
+    GlobalScopeTimer<Category::WaitingForEvent> wait;
+    block();
+  } );
+  thread untimed( [&] {
+    {
+      GlobalScopeTimer<Category::Nonblock> scope;
+    }
+    block();
+  } );
+  this_thread::sleep_for( chrono::milliseconds( 10 ) );
+
+  const uint64_t start = Timer::timestamp_ns();
+  thread merging( [] {
+    for ( unsigned int i = 0; i < 10; i++ ) {
+      merged_global_timer();
+    }
+  } );
+  for ( unsigned int i = 0; i < 10; i++ ) {
+    reset_global_timer();
+  }
+  merging.join();
+  const uint64_t elapsed = Timer::timestamp_ns() - start;
+
+  {
+    const lock_guard lock { m };
+    release = true;
+  }
+  cv.notify_all();
+  waiting.join();
+  untimed.join();
+
+  cout << "10 merges and 10 resets beside blocked threads took ";
+  Timer::pp_ns( cout, elapsed );
+  cout << endl;
+  return elapsed < 10'000'000;
+}
+
+int main()
+{
+  try {
+    if ( not test_nesting() or not test_mismatched_stop() or not test_threads() or not test_reuse_after_exit()
+         or not test_reset_while_running()
+         or not test_merge_while_running() or not test_merge_while_blocked() ) {
+      throw runtime_error( "test failure" );
+    }
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
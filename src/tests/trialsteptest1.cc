@@ -0,0 +1,113 @@
+#include "eigen.hh"
+#include "network.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr unsigned int batch_size = 6;
+constexpr unsigned int input_size = 5;
+constexpr double learning_rate = 0.1;
+// max allowable difference between the parameters after a committed trial step and a plain step (rounding only)
+constexpr double param_epsilon = 1e-12;
+
+using Net = Network<double, batch_size, input_size, 7, 4, 2>;
+
+// weights and gradients, and no second parameter set until a tryStep or snapshot asks for one
+static_assert( sizeof( Layer<float, 1, 256, 256> ) < 3 * 256 * 256 * sizeof( float ) );
+
+/* every weight and bias of the network, layer by layer */
+vector<double> parameters( const Net& net )
+{
+  vector<double> params;
+  net.forEachLayer( [&]( const auto& layer ) {
+    for ( const double weight : layer.weights().reshaped() ) {
+      params.push_back( weight );
+    }
+    for ( const double bias : layer.biases().reshaped() ) {
+      params.push_back( bias );
+    }
+  } );
+  return params;
+}
+
+double max_param_diff( const Net& a, const Net& b )
+{
+  const vector<double> x = parameters( a ), y = parameters( b );
+  double diff = 0;
+  for ( size_t i = 0; i < x.size(); i++ ) {
+    diff = max( diff, abs( x[i] - y[i] ) );
+  }
+  return diff;
+}
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  uniform_real_distribution<double> input_dist( -1, 1 );
+
+  auto nn = make_unique<Net>();
+  nn->initializeWeightsRandomly( rng );
+  const Matrix<double, batch_size, input_size> input
+    = Matrix<double, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+  nn->apply( input );
+  nn->computeDeltas();
+  nn->evaluateGradients( input );
+
+  /* a trial step rolls back bit for bit, also in a copy taken during the trial; a committed one is a plain step */
+  const auto before = make_unique<Net>( *nn );
+  const auto stepped = make_unique<Net>( *nn );
+  for ( unsigned int i = 0; i < stepped->getNumLayers(); i++ ) {
+    stepped->modifyParamWholeLayer( i, learning_rate );
+  }
+  nn->tryStep( 2 * learning_rate );
+  const auto trial_copy = make_unique<Net>( *nn );
+  nn->rollback();
+  trial_copy->rollback();
+  const bool rolled_back
+    = parameters( *nn ) == parameters( *before ) and parameters( *trial_copy ) == parameters( *before );
+  nn->tryStep( learning_rate );
+  nn->commit();
+  const double trial_diff = max_param_diff( *nn, *stepped );
+
+  /* a shelved trial step comes back after another one was tried */
+  nn->tryStep( learning_rate );
+  const auto shelved_step = make_unique<Net>( *nn );
+  nn->shelve();
+  const bool shelved = parameters( *nn ) == parameters( *stepped );
+  nn->tryStep( 2 * learning_rate );
+  nn->unshelve();
+  const bool unshelved = shelved and parameters( *nn ) == parameters( *shelved_step );
+
+  /* a network in an arena takes its trial steps' parameter sets from the arena */
+  ParameterArena arena { sizeof( Net ) + Net::trial_set_bytes };
+  Net* placed = arena.make<Net>( *before );
+  placed->placeTrialSetsIn( arena );
+  placed->tryStep( learning_rate );
+  const bool in_arena = arena.used() == sizeof( Net ) + Net::trial_set_bytes;
+  placed->~Net();
+
+  cout << "trial step rolled back " << rolled_back << ", committed trial step diff " << trial_diff
+       << ", shelved step kept " << unshelved << ", trial sets in arena " << in_arena << endl;
+
+  if ( not rolled_back or not( trial_diff < param_epsilon ) or not unshelved or not in_arena ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
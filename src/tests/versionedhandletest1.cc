@@ -0,0 +1,86 @@
+#include "versioned_handle.hh"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+constexpr unsigned int num_readers = 4;
+constexpr uint64_t num_versions = 2000;
+constexpr size_t value_size = 256;
+
+/* every element of version n is n, so a reader that sees a mix was given freed or half-built memory */
+struct Value
+{
+  vector<uint64_t> elements;
+};
+
+void program_body()
+{
+  VersionedHandle<Value> handle { make_unique<const Value>( Value { vector<uint64_t>( value_size, 1 ) } ) };
+  atomic<bool> stop { false };
+  atomic<uint64_t> errors { 0 }, reads { 0 };
+
+  vector<thread> readers;
+  for ( unsigned int r = 0; r < num_readers; r++ ) {
+    readers.emplace_back( [&] {
+      VersionedHandle<Value>::Reader reader { handle };
+      uint64_t last_version = 0;
+      uint64_t num_reads = 0;
+      while ( not stop.load() ) {
+        auto current = reader.read();
+        const uint64_t version = current.version();
+        /* versions only move forward */
+        if ( version < last_version ) {
+          errors++;
+        }
+        last_version = version;
+        for ( const auto element : current->elements ) {
+          if ( element != version ) {
+            errors++;
+            break;
+          }
+        }
+        num_reads++;
+      }
+      reads += num_reads;
+    } );
+  }
+
+  for ( uint64_t v = 2; v <= num_versions; v++ ) {
+    if ( handle.publish( make_unique<const Value>( Value { vector<uint64_t>( value_size, v ) } ) ) != v ) {
+      errors++;
+    }
+    if ( v % 64 == 0 ) {
+      this_thread::yield();
+    }
+  }
+
+  stop = true;
+  for ( auto& reader : readers ) {
+    reader.join();
+  }
+  handle.synchronize();
+
+  cout << "versions " << handle.version() << ", reclaimed " << handle.num_reclaimed() << ", reads " << reads
+       << ", errors " << errors << endl;
+
+  /* every version but the current one has been freed */
+  if ( errors != 0 or handle.version() != num_versions or handle.num_reclaimed() != num_versions - 1 ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
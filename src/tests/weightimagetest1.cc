@@ -0,0 +1,76 @@
+#include "eigen.hh"
+#include "network.hh"
+#include "weight_image.hh"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr size_t batch_size = 4;
+constexpr size_t input_size = 7;
+const string image_filename = "weightimagetest1.nnw";
+
+using Net = Network<float, batch_size, input_size, 33, 5, 3>;
+using Mapped = MappedNetwork<float, batch_size, input_size, 33, 5, 3>;
+
+void program_body()
+{
+  mt19937 rng( 0 );
+  auto net = make_unique<Net>();
+  net->initializeWeightsRandomly( rng );
+  writeWeightImage( *net, image_filename );
+
+  const WeightImage image { image_filename };
+  auto mapped = make_unique<Mapped>( image );
+
+  uniform_real_distribution<float> input_dist( -1, 1 );
+  const Matrix<float, batch_size, input_size> input
+    = Matrix<float, batch_size, input_size>::NullaryExpr( [&] { return input_dist( rng ); } );
+
+  /* the mapped network computes exactly what the network it was written from does */
+  net->apply( input );
+  mapped->apply( input );
+  const bool relu_equal = net->output() == mapped->output();
+
+  net->apply_leaky( input );
+  mapped->apply_leaky( input );
+  const bool leaky_equal = net->output() == mapped->output();
+
+  /* and the image loads back into a trainable network */
+  auto loaded = make_unique<Net>();
+  loadWeightImage( *loaded, image );
+  loaded->apply( input );
+  net->apply( input );
+  const bool loaded_equal = net->output() == loaded->output();
+
+  /* a network of another shape is refused */
+  bool shape_checked = false;
+  try {
+    MappedNetwork<float, batch_size, input_size, 33, 6, 3> wrong { image };
+  } catch ( const runtime_error& e ) {
+    shape_checked = true;
+  }
+
+  remove( image_filename.c_str() );
+
+  cout << "image size " << image.size() << " bytes, relu " << relu_equal << ", leaky " << leaky_equal << ", loaded "
+       << loaded_equal << ", shape checked " << shape_checked << endl;
+
+  if ( not relu_equal or not leaky_equal or not loaded_equal or not shape_checked ) {
+    throw runtime_error( "test failure" );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+    return EXIT_SUCCESS;
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,40 @@
+#include "affinity.hh"
+#include "exception.hh"
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+vector<unsigned int> available_cpus()
+{
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  CheckSystemCall( "sched_getaffinity", sched_getaffinity( 0, sizeof( set ), &set ) );
+
+  vector<unsigned int> ret;
+  for ( unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+    if ( CPU_ISSET( cpu, &set ) ) {
+      ret.push_back( cpu );
+    }
+  }
+
+  if ( ret.empty() ) {
+    throw runtime_error( "available_cpus: empty affinity mask" );
+  }
+
+  return ret;
+}
+
+void pin_this_thread( const unsigned int cpu )
+{
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  CPU_SET( cpu, &set );
+
+  /* pthread functions return the error number instead of setting errno */
+  const int ret = pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+  if ( ret != 0 ) {
+    throw unix_error( "pthread_setaffinity_np", ret );
+  }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <vector>
+
+//! CPUs this process is allowed to run on, in ascending order
+std::vector<unsigned int> available_cpus();
+
+//! Restrict the calling thread to a single CPU
+void pin_this_thread( const unsigned int cpu );
@@ -0,0 +1,66 @@
+#include "arena.hh"
+#include "exception.hh"
+
+#include <cstdint>
+#include <sys/mman.h>
+
+using namespace std;
+
+namespace {
+
+size_t round_up( const size_t n, const size_t multiple )
+{
+  return ( n + multiple - 1 ) / multiple * multiple;
+}
+
+}
+
+MMap_Region ParameterArena::map( const size_t capacity, Backing& backing )
+{
+  const size_t length = round_up( capacity, huge_page_size );
+
+  try {
+    MMap_Region ret { nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1 };
+    backing = Backing::HugeTLB;
+    return ret;
+  } catch ( const unix_error& ) {
+    /* no huge pages reserved; fall back to transparent huge pages below */
+  }
+
+  /* THP only backs 2 MB-aligned ranges, so map one extra huge page to align the start */
+  MMap_Region ret { nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1 };
+  backing = ( madvise( ret.addr(), ret.length(), MADV_HUGEPAGE ) == 0 ) ? Backing::TransparentHugePages
+                                                                       : Backing::SmallPages;
+  return ret;
+}
+
+ParameterArena::ParameterArena( const size_t capacity )
+  : backing_( Backing::SmallPages )
+  , region_( map( capacity, backing_ ) )
+  , begin_( reinterpret_cast<char*>(
+      round_up( reinterpret_cast<uintptr_t>( region_.addr() ), backing_ == Backing::HugeTLB ? 1 : huge_page_size ) ) )
+  , capacity_( region_.length() - ( begin_ - region_.addr() ) )
+{}
+
+void* ParameterArena::allocate( const size_t size, const size_t align )
+{
+  const size_t offset = round_up( reinterpret_cast<uintptr_t>( begin_ + used_ ), align ) - uintptr_t( begin_ );
+  if ( offset + size > capacity_ ) {
+    throw bad_alloc();
+  }
+
+  used_ = offset + size;
+  return begin_ + offset;
+}
+
+const char* ParameterArena::backing_name() const
+{
+  switch ( backing_ ) {
+    case Backing::HugeTLB:
+      return "explicit huge pages (MAP_HUGETLB)";
+    case Backing::TransparentHugePages:
+      return "transparent huge pages (MADV_HUGEPAGE)";
+    default:
+      return "4 KB pages";
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "mmap.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/*
+ * Class Name: ParameterArena
+ * Description: A bump allocator over one anonymous mapping, meant to hold a
+ *              whole fixed-size Network (weights, gradients and activations)
+ *              on 2 MB pages instead of 4 KB ones.
+ *              The mapping is first tried with MAP_HUGETLB (needs reserved
+ *              pages in /proc/sys/vm/nr_hugepages). Failing that, an ordinary
+ *              mapping aligned to 2 MB is advised with MADV_HUGEPAGE so that
+ *              transparent huge pages can back it. Every allocation is 64-byte
+ *              aligned. Memory is released only when the arena is destroyed,
+ *              and objects created in it must be destroyed by the caller.
+ */
+class ParameterArena
+{
+public:
+  enum class Backing
+  {
+    HugeTLB,              /* explicit huge pages (MAP_HUGETLB) */
+    TransparentHugePages, /* ordinary mapping with MADV_HUGEPAGE */
+    SmallPages            /* neither was available */
+  };
+
+  constexpr static size_t huge_page_size = 2 * 1024 * 1024;
+  constexpr static size_t alignment = 64;
+
+private:
+  Backing backing_;
+  MMap_Region region_;
+  char* begin_;
+  size_t capacity_;
+  size_t used_ {};
+
+  static MMap_Region map( const size_t capacity, Backing& backing );
+
+public:
+  /* reserve room for at least `capacity` bytes */
+  explicit ParameterArena( const size_t capacity );
+
+  /* Disallow copying */
+  ParameterArena( const ParameterArena& other ) = delete;
+  ParameterArena& operator=( const ParameterArena& other ) = delete;
+
+  /* returns `size` bytes aligned to `align` (a power of two); throws std::bad_alloc when full */
+  void* allocate( const size_t size, const size_t align = alignment );
+
+  /* construct a T in the arena */
+  template<class T, class... Args>
+  T* make( Args&&... args )
+  {
+    return new ( allocate( sizeof( T ), std::max( alignof( T ), alignment ) ) ) T( std::forward<Args>( args )... );
+  }
+
+  /* forget every allocation, to reuse the arena once the objects in it are destroyed */
+  void clear() { used_ = 0; }
+
+  Backing backing() const { return backing_; }
+  const char* backing_name() const;
+
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return used_; }
+};
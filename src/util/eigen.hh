@@ -0,0 +1,13 @@
+#pragma once
+
+/* Eigen, for every file that uses it. GCC 12 reports false positives in Eigen 3.4's fixed-size kernels and its
+   AVX-512 intrinsic headers (-Wuninitialized, -Wmaybe-uninitialized, -Waggressive-loop-optimizations; GCC bug
+   105593). Those warnings are silenced here, in Eigen's headers only: our own code keeps them as errors. */
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Waggressive-loop-optimizations"
+#include <Eigen/Dense>
+#include <unsupported/Eigen/SpecialFunctions>
+#pragma GCC diagnostic pop
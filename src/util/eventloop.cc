@@ -0,0 +1,271 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <iomanip>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+
+EventLoop::BasicRule::BasicRule( const size_t s_category_id, const InterestT& s_interest, const CallbackT& s_callback )
+  : category_id( s_category_id )
+  , interest( s_interest )
+  , callback( s_callback )
+{}
+
+EventLoop::FDRule::FDRule( BasicRule&& base,
+                           FileDescriptor&& s_fd,
+                           const Direction s_direction,
+                           const CallbackT& s_cancel )
+  : BasicRule( base )
+  , fd( move( s_fd ) )
+  , direction( s_direction )
+  , cancel( s_cancel )
+{}
+
+unsigned int EventLoop::FDRule::service_count() const
+{
+  return direction == Direction::In ? fd.read_count() : fd.write_count();
+}
+
+EventLoop::EventLoop()
+  : _epoll_fd( CheckSystemCall( "epoll_create1", epoll_create1( EPOLL_CLOEXEC ) ) )
+{
+  _events.resize( 256 );
+}
+
+size_t EventLoop::add_category( const string& name )
+{
+  _rule_categories.push_back( { name } );
+  _rule_categories.back().timer.enable_histogram();
+  return _rule_categories.size() - 1;
+}
+
+void EventLoop::RuleHandle::cancel()
+{
+  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
+  if ( rule_shared_ptr ) {
+    rule_shared_ptr->cancel_requested = true;
+  }
+}
+
+//! (re)register an fd with epoll for the directions its rules want, edge-triggered
+void EventLoop::update_watch( const int fd_num )
+{
+  auto& watch = _watches.at( fd_num );
+
+  if ( not( watch.in or watch.out ) ) {
+    if ( watch.registered ) {
+      CheckSystemCall( "epoll_ctl(DEL)", epoll_ctl( _epoll_fd.fd_num(), EPOLL_CTL_DEL, fd_num, nullptr ) );
+    }
+    _watches.erase( fd_num );
+    return;
+  }
+
+  epoll_event event {};
+  event.events = EPOLLET | EPOLLRDHUP;
+  if ( watch.in ) {
+    event.events |= EPOLLIN;
+  }
+  if ( watch.out ) {
+    event.events |= EPOLLOUT;
+  }
+  event.data.fd = fd_num;
+  CheckSystemCall( "epoll_ctl",
+                   epoll_ctl( _epoll_fd.fd_num(), watch.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd_num, &event ) );
+  watch.registered = true;
+}
+
+EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
+                                           FileDescriptor& fd,
+                                           const Direction direction,
+                                           const CallbackT& callback,
+                                           const InterestT& interest,
+                                           const CallbackT& cancel )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  auto rule = make_shared<FDRule>(
+    BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel );
+
+  auto& slot = direction == Direction::In ? _watches[fd.fd_num()].in : _watches[fd.fd_num()].out;
+  if ( slot ) {
+    throw runtime_error( "EventLoop: fd " + to_string( fd.fd_num() ) + " already has a rule for this direction" );
+  }
+  slot = rule;
+  update_watch( fd.fd_num() );
+
+  /* the fd may already be ready, and no edge will come for that; let the first callback find out */
+  rule->ready = true;
+
+  _fd_rules.push_back( rule );
+  return rule;
+}
+
+EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
+                                           const CallbackT& callback,
+                                           const InterestT& interest )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  _non_fd_rules.push_back( make_shared<BasicRule>( category_id, interest, callback ) );
+  return _non_fd_rules.back();
+}
+
+void EventLoop::remove_rule( const shared_ptr<FDRule>& rule )
+{
+  const int fd_num = rule->fd.fd_num();
+  if ( rule->fd.closed() ) {
+    /*
+     * closing the fd already removed it from the epoll set, and its number may belong to another fd by now: forget
+     * the watch, with the rule for the other direction (which is removed from _fd_rules in turn), without epoll_ctl
+     */
+    const auto watch = _watches.find( fd_num );
+    if ( watch != _watches.end() and ( watch->second.in == rule or watch->second.out == rule ) ) {
+      _watches.erase( watch );
+    }
+  } else {
+    auto& watch = _watches.at( fd_num );
+    ( rule->direction == Direction::In ? watch.in : watch.out ).reset();
+    update_watch( fd_num );
+  }
+  rule->cancel();
+}
+
+EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+{
+  /* remove cancelled rules, and rules whose fd is closed or (for reading) at EOF */
+  bool something_to_do = false;
+  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) {
+    auto& rule = **it;
+    if ( rule.cancel_requested or rule.fd.closed() or ( rule.direction == Direction::In and rule.fd.eof() ) ) {
+      remove_rule( *it );
+      it = _fd_rules.erase( it );
+      continue;
+    }
+    something_to_do |= rule.ready and rule.interest();
+    ++it;
+  }
+
+  for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
+    if ( ( *it )->cancel_requested ) {
+      it = _non_fd_rules.erase( it );
+      continue;
+    }
+    something_to_do |= ( *it )->interest();
+    ++it;
+  }
+
+  if ( _fd_rules.empty() and _non_fd_rules.empty() ) {
+    return Result::Exit;
+  }
+
+  /* wait for new edges, but do not block while some rule already has work */
+  int num_events;
+  {
+    GlobalScopeTimer<Timer::Category::WaitingForEvent> timer;
+    num_events = CheckSystemCall(
+      "epoll_wait",
+      epoll_wait( _epoll_fd.fd_num(), _events.data(), _events.size(), something_to_do ? 0 : timeout_ms ) );
+  }
+  _wakeups++;
+  _epoll_events += num_events;
+
+  for ( int i = 0; i < num_events; i++ ) {
+    const auto watch = _watches.find( _events[i].data.fd );
+    if ( watch == _watches.end() ) {
+      continue;
+    }
+    const uint32_t events = _events[i].events;
+    if ( watch->second.in and ( events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) ) {
+      watch->second.in->ready = true;
+    }
+    if ( watch->second.out and ( events & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) ) ) {
+      watch->second.out->ready = true;
+    }
+  }
+  if ( size_t( num_events ) == _events.size() ) {
+    _events.resize( _events.size() * 2 );
+  }
+
+  /*
+   * service each ready, interested rule; rules that are still ready afterwards (their callback did
+   * not find the fd blocked) get another round in this wakeup instead of costing another epoll_wait
+   */
+  bool serviced = false;
+  for ( unsigned int round = 0; round < max_rounds_per_wakeup; round++ ) {
+    bool still_ready = false;
+
+    for ( const auto& rule_ptr : _fd_rules ) {
+      auto& rule = *rule_ptr;
+      if ( not rule.ready or rule.cancel_requested or not rule.interest() ) {
+        continue;
+      }
+
+      const unsigned int count_before = rule.service_count();
+      {
+        RecordScopeTimer<Timer::Category::Nonblock> record_timer { _rule_categories.at( rule.category_id ).timer };
+        rule.callback();
+      }
+      _callbacks++;
+      serviced = true;
+
+      if ( rule.direction == Direction::In ? rule.fd.read_blocked() : rule.fd.write_blocked() ) {
+        rule.ready = false;
+      } else if ( rule.fd.closed() or rule.fd.eof() or rule.cancel_requested ) {
+        continue;
+      } else if ( count_before == rule.service_count() and rule.interest() ) {
+        throw runtime_error( "EventLoop: busy wait detected: rule \"" + _rule_categories.at( rule.category_id ).name
+                             + "\" is still interested but did not "
+                             + ( rule.direction == Direction::In ? "read fd." : "write fd." ) );
+      } else {
+        still_ready = true;
+      }
+    }
+
+    if ( not still_ready ) {
+      break;
+    }
+  }
+
+  for ( const auto& rule : _non_fd_rules ) {
+    if ( rule->cancel_requested or not rule->interest() ) {
+      continue;
+    }
+    RecordScopeTimer<Timer::Category::Nonblock> record_timer { _rule_categories.at( rule->category_id ).timer };
+    rule->callback();
+    _callbacks++;
+    serviced = true;
+  }
+
+  return serviced ? Result::Success : Result::Timeout;
+}
+
+void EventLoop::summary( ostream& out ) const
+{
+  out << "EventLoop: " << _wakeups << " wakeups, " << _epoll_events << " epoll events, " << _callbacks
+      << " callbacks";
+  if ( _wakeups ) {
+    out << " (" << fixed << setprecision( 2 ) << double( _callbacks ) / _wakeups << " callbacks/wakeup)";
+  }
+  out << "\n";
+
+  for ( const auto& category : _rule_categories ) {
+    if ( category.timer.count == 0 ) {
+      continue;
+    }
+    out << "   " << left << setw( 28 ) << category.name << right << setw( 10 ) << category.timer.count
+        << " calls, mean ";
+    Timer::pp_ns( out, category.timer.total_ns / category.timer.count );
+    out << ", p99 ";
+    Timer::pp_ns( out, category.timer.percentile( 0.99 ) );
+    out << ", max ";
+    Timer::pp_ns( out, category.timer.max_ns );
+    out << "\n";
+  }
+  out << defaultfloat;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
+
+#include "file_descriptor.hh"
+#include "timer.hh"
+
+//! Waits for events on file descriptors and executes corresponding callbacks.
+class EventLoop
+{
+public:
+  //! Indicates interest in reading (In) or writing (Out) a polled fd.
+  enum class Direction : uint32_t
+  {
+    In = EPOLLIN,  //!< Callback will be triggered when the fd is readable.
+    Out = EPOLLOUT //!< Callback will be triggered when the fd is writable.
+  };
+
+  //! Returned by each call to EventLoop::wait_next_event.
+  enum class Result
+  {
+    Success, //!< At least one rule was serviced.
+    Timeout, //!< No rule was ready before the timeout.
+    Exit     //!< All rules have been canceled or were uninterested; make no further calls.
+  };
+
+  using CallbackT = std::function<void( void )>;
+  using InterestT = std::function<bool( void )>;
+
+private:
+  struct RuleCategory
+  {
+    std::string name;
+    Timer::Record timer {};
+  };
+
+  struct BasicRule
+  {
+    size_t category_id;
+    InterestT interest;
+    CallbackT callback;
+    bool cancel_requested {};
+
+    BasicRule( const size_t s_category_id, const InterestT& s_interest, const CallbackT& s_callback );
+  };
+
+  struct FDRule : public BasicRule
+  {
+    FileDescriptor fd;   //!< FileDescriptor to monitor for activity.
+    Direction direction; //!< Direction::In for reading from fd, Direction::Out for writing to fd.
+    CallbackT cancel;    //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+    bool ready {};       //!< An edge was seen and the callback has not yet found the fd not ready.
+
+    FDRule( BasicRule&& base, FileDescriptor&& s_fd, const Direction s_direction, const CallbackT& s_cancel );
+
+    //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
+    //! \details This function is used internally by EventLoop; you will not need to call it
+    unsigned int service_count() const;
+  };
+
+  //! The rules watching one fd (epoll watches each fd once, for both directions)
+  struct Watch
+  {
+    std::shared_ptr<FDRule> in {};
+    std::shared_ptr<FDRule> out {};
+    bool registered {}; //!< Whether the fd is in the epoll set.
+  };
+
+  FileDescriptor _epoll_fd;
+  std::vector<RuleCategory> _rule_categories {};
+  std::list<std::shared_ptr<FDRule>> _fd_rules {};
+  std::list<std::shared_ptr<BasicRule>> _non_fd_rules {};
+  std::unordered_map<int, Watch> _watches {};
+  std::vector<epoll_event> _events {};
+
+  //! How many times one wakeup services a rule whose fd is still ready
+  constexpr static unsigned int max_rounds_per_wakeup = 4;
+
+  uint64_t _wakeups {};
+  uint64_t _epoll_events {};
+  uint64_t _callbacks {};
+
+  void update_watch( const int fd_num );
+  void remove_rule( const std::shared_ptr<FDRule>& rule );
+
+public:
+  EventLoop();
+
+  //! Returns the category id of a new category of rules, used in the summary.
+  size_t add_category( const std::string& name );
+
+  class RuleHandle
+  {
+    std::weak_ptr<BasicRule> rule_weak_ptr_;
+
+  public:
+    template<class RuleType>
+    RuleHandle( const std::shared_ptr<RuleType> x )
+      : rule_weak_ptr_( x )
+    {}
+
+    void cancel();
+  };
+
+  //! Calls `callback` whenever `fd` is ready in `direction` and `interest` returns true.
+  //! \details Readiness is edge-triggered: a rule stays ready until its callback reads (or writes)
+  //! the fd and finds it not ready (FileDescriptor::read_blocked, or write_blocked after write_some), so callbacks
+  //! need not drain the fd in one call. A callback that is called while ready and interested, and
+  //! neither reads (writes) nor reaches EOF, would make the loop spin; that is detected and throws.
+  RuleHandle add_rule(
+    const size_t category_id,
+    FileDescriptor& fd,
+    const Direction direction,
+    const CallbackT& callback,
+    const InterestT& interest = [] { return true; },
+    const CallbackT& cancel = [] {} );
+
+  //! Calls `callback` on every call to wait_next_event while `interest` returns true.
+  RuleHandle add_rule(
+    const size_t category_id,
+    const CallbackT& callback,
+    const InterestT& interest = [] { return true; } );
+
+  //! Calls [epoll_wait(2)](\ref man2::epoll_wait) and executes the callback of each ready rule.
+  //! \details Time blocked in epoll_wait is logged as Timer::Category::WaitingForEvent in the
+  //! global timer, and each callback as Timer::Category::Nonblock (and in its rule category).
+  Result wait_next_event( const int timeout_ms );
+
+  // convenience function to add category and rule at the same time
+  template<typename... Targs>
+  auto add_rule( const std::string& name, Targs&&... Fargs )
+  {
+    return add_rule( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
+
+  uint64_t wakeups() const { return _wakeups; }
+  uint64_t callbacks() const { return _callbacks; }
+
+  void summary( std::ostream& out ) const;
+};
+
+using Direction = EventLoop::Direction;
@@ -70,6 +70,7 @@ size_t FileDescriptor::read( string_span buffer )
   const ssize_t bytes_read = ::read( fd_num(), buffer.mutable_data(), buffer.size() );
   if ( bytes_read < 0 ) {
     if ( _internal_fd->_non_blocking and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      _internal_fd->_read_blocked = true;
       return 0;
     } else {
       throw unix_error( "read" );
@@ -77,6 +78,7 @@ size_t FileDescriptor::read( string_span buffer )
   }
 
   register_read();
+  _internal_fd->_read_blocked = false;
 
   if ( bytes_read == 0 ) {
     _internal_fd->_eof = true;
@@ -102,6 +104,7 @@ size_t FileDescriptor::write( const string_view buffer )
     throw runtime_error( "write wrote more than length of input buffer" );
   }
 
+  _internal_fd->_write_blocked = false;
   return bytes_written;
 }
 
@@ -119,6 +122,28 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
   return bytes_written;
 }
 
+size_t FileDescriptor::write_some( const string_view buffer )
+{
+  if ( buffer.empty() ) {
+    return 0;
+  }
+
+  const ssize_t bytes_written = ::write( fd_num(), buffer.data(), buffer.size() );
+  if ( bytes_written < 0 and _internal_fd->_non_blocking and ( errno == EAGAIN or errno == EWOULDBLOCK ) ) {
+    _internal_fd->_write_blocked = true;
+    return 0;
+  }
+  CheckSystemCall( "write", bytes_written );
+  register_write();
+  _internal_fd->_write_blocked = false;
+
+  if ( bytes_written > ssize_t( buffer.size() ) ) {
+    throw runtime_error( "write wrote more than length of input buffer" );
+  }
+
+  return bytes_written;
+}
+
 void FileDescriptor::set_blocking( const bool blocking )
 {
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) );
@@ -152,3 +177,10 @@ int FileDescriptor::FDWrapper::CheckSystemCall( const string_view s_attempt, con
 
   throw unix_error( s_attempt );
 }
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  int fds[2];
+  CheckSystemCall( "pipe2", pipe2( fds, O_CLOEXEC ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "spans.hh"
@@ -21,6 +22,8 @@ class FileDescriptor
     bool _non_blocking = true; //!< Flag indicating whether FDWrapper::_fd is non-blocking
     unsigned _read_count = 0;  //!< The number of times FDWrapper::_fd has been read
     unsigned _write_count = 0; //!< The numberof times FDWrapper::_fd has been written
+    bool _read_blocked = false;  //!< Flag indicating whether the last read found FDWrapper::_fd not readable
+    bool _write_blocked = false; //!< Flag indicating whether the last write found FDWrapper::_fd not writable
 
     //! Construct from a file descriptor number returned by the kernel
     explicit FDWrapper( const int fd );
@@ -75,6 +78,12 @@ public:
 
   size_t write( const std::vector<std::string_view>& buffers );
 
+  //! Write as much of a buffer as the fd takes without blocking
+  //! \returns number of bytes written: 0 when a non-blocking fd is not writable (see write_blocked()),
+  //! in which case the caller should wait for the fd to become writable (e.g. an EventLoop rule
+  //! in Direction::Out, or POLLOUT) instead of retrying
+  size_t write_some( const std::string_view buffer );
+
   //! Close the underlying file descriptor
   void close() { _internal_fd->close(); }
 
@@ -94,6 +103,8 @@ public:
   bool closed() const { return _internal_fd->_closed; }                   //!< \brief closed flag state
   unsigned int read_count() const { return _internal_fd->_read_count; }   //!< \brief number of reads
   unsigned int write_count() const { return _internal_fd->_write_count; } //!< \brief number of writes
+  bool read_blocked() const { return _internal_fd->_read_blocked; }       //!< \brief last read would have blocked
+  bool write_blocked() const { return _internal_fd->_write_blocked; }     //!< \brief last write would have blocked
   //!@}
 
   //! \name Copy/move constructor/assignment operators
@@ -106,6 +117,9 @@ public:
                                                                      //!@}
 };
 
+//! Create a pipe; returns the (read end, write end)
+std::pair<FileDescriptor, FileDescriptor> make_pipe();
+
 //! \class FileDescriptor
 //! In addition, FileDescriptor tracks EOF state and calls to FileDescriptor::read and
 //! FileDescriptor::write, which EventLoop uses to detect busy loop conditions.
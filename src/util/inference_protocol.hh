@@ -0,0 +1,36 @@
+/**
+ * File name: inference_protocol.hh
+ * Last Update: October 2026
+ * Description: Wire format between inference_server and its clients. A client
+ *              writes fixed-size requests on a Unix stream socket and reads
+ *              one fixed-size response per request, in the same order. Both
+ *              ends run on the same host, so values are in native byte order.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace inference {
+
+/* the 16 timestamps -> tempo (bpm) model of big_nn_1.cc */
+constexpr size_t input_size = 16;
+constexpr size_t output_size = 1;
+
+constexpr const char* default_socket_path = "/tmp/nnfun_inference.sock";
+
+struct Request
+{
+  std::array<float, input_size> input;
+};
+
+struct Response
+{
+  std::array<float, output_size> output;
+};
+
+static_assert( sizeof( Request ) == input_size * sizeof( float ) );
+static_assert( sizeof( Response ) == output_size * sizeof( float ) );
+
+}
@@ -0,0 +1,356 @@
+/**
+ * File name: inference_server.hh
+ * Last Update: October 2026
+ * Description: The batching and reply path of inference_server: a model
+ *              compiled for several batch sizes (BatchedModel), and the
+ *              single-threaded server that queues requests from all its
+ *              clients and answers them in batches (InferenceServer).
+ */
+
+#pragma once
+
+#include "eigen.hh"
+#include "exception.hh"
+#include "inference_protocol.hh"
+#include "socket.hh"
+#include "timer.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/* copy the parameters of one network into another with the same layer sizes (any batch size) */
+template<class Source, class Destination>
+void copy_parameters( const Source& source, Destination& destination )
+{
+  std::vector<std::pair<Eigen::MatrixXf, Eigen::MatrixXf>> params;
+  source.forEachLayer( [&]( const auto& layer ) { params.emplace_back( layer.weights(), layer.biases() ); } );
+
+  size_t k = 0;
+  destination.forEachLayer( [&]( auto& layer ) {
+    layer.weights() = params.at( k ).first;
+    layer.biases() = params.at( k ).second;
+    k++;
+  } );
+}
+
+/*
+ * Class Name: BatchedModel
+ * Description: One network per batch size (listed in increasing order).
+ *              apply() runs n requests through the smallest batch size that
+ *              holds them, padding the rest of the batch with zeros.
+ */
+template<template<unsigned int> class NetworkT, unsigned int... batch_sizes>
+class BatchedModel
+{
+  std::tuple<std::unique_ptr<NetworkT<batch_sizes>>...> networks_;
+
+  template<unsigned int batch_size>
+  static void run( NetworkT<batch_size>& network,
+                   const inference::Request* requests,
+                   const size_t n,
+                   inference::Response* responses )
+  {
+    using namespace inference;
+    Eigen::Matrix<float, batch_size, input_size> input = Eigen::Matrix<float, batch_size, input_size>::Zero();
+    for ( size_t i = 0; i < n; i++ ) {
+      input.row( i ) = Eigen::Map<const Eigen::Matrix<float, 1, input_size>>( requests[i].input.data() );
+    }
+
+    network.apply( input );
+
+    for ( size_t i = 0; i < n; i++ ) {
+      Eigen::Map<Eigen::Matrix<float, 1, output_size>>( responses[i].output.data() ) = network.output().row( i );
+    }
+  }
+
+public:
+  constexpr static unsigned int max_batch_size = std::max( { batch_sizes... } );
+
+  /* make( integral_constant<unsigned int, b> ) returns the network for batch size b */
+  template<class Factory>
+  explicit BatchedModel( Factory&& make )
+    : networks_ { make( std::integral_constant<unsigned int, batch_sizes> {} )... }
+  {}
+
+  void apply( const inference::Request* requests, const size_t n, inference::Response* responses )
+  {
+    if ( n == 0 or n > max_batch_size ) {
+      throw std::runtime_error( "BatchedModel: invalid batch of " + std::to_string( n ) );
+    }
+
+    bool done = false;
+    ( ( done = done
+               or ( n <= batch_sizes
+                    and ( run<batch_sizes>( *std::get<std::unique_ptr<NetworkT<batch_sizes>>>( networks_ ),
+                                            requests,
+                                            n,
+                                            responses ),
+                          true ) ) ),
+      ... );
+  }
+};
+
+struct ServerStats
+{
+  uint64_t requests {};
+  uint64_t batches {};
+  uint64_t deadline_batches {};
+};
+
+/*
+ * Class Name: InferenceServer
+ * Description: Answers the requests of every connected client from one
+ *              thread. Requests are queued, oldest first, and the queue is
+ *              run as one batch when it holds Batched::max_batch_size
+ *              requests or when its oldest request has waited deadline_ns.
+ *
+ *              Client sockets are non-blocking. Each client's replies are
+ *              appended to its own output buffer and written as the socket
+ *              takes them (POLLOUT), so a client that stops reading only
+ *              delays itself. Once a client has max_buffered_output bytes
+ *              of unsent replies, its requests are not read until it catches
+ *              up. A client that shuts down its writing direction still gets
+ *              the replies to everything it sent.
+ */
+template<class Batched>
+class InferenceServer
+{
+public:
+  constexpr static size_t max_buffered_output = 1 << 20;
+
+private:
+  struct Client
+  {
+    LocalStreamSocket socket;
+    std::string input {};  /* bytes of a partial request */
+    std::string output {}; /* replies not yet written */
+    size_t queued = 0;     /* requests in the queue */
+    bool eof = false;      /* no more requests will come */
+
+    bool done() const { return eof and queued == 0 and output.empty(); }
+  };
+
+  struct PendingRequest
+  {
+    uint64_t client;
+    uint64_t arrival_ns;
+    inference::Request request;
+  };
+
+  Batched& batched_;
+  LocalStreamSocket listener_;
+  uint64_t deadline_ns_;
+
+  std::map<uint64_t, Client> clients_ {};
+  uint64_t next_client_id_ = 0;
+  std::deque<PendingRequest> pending_ {};
+  std::vector<inference::Request> batch_requests_ = std::vector<inference::Request>( Batched::max_batch_size );
+  std::vector<inference::Response> batch_responses_ = std::vector<inference::Response>( Batched::max_batch_size );
+  ServerStats stats_ {};
+
+  std::vector<pollfd> pollfds_ {};
+  std::vector<uint64_t> pollfd_clients_ {};
+  std::string read_buffer_ = std::string( 64 * 1024, 0 );
+
+  void drop( const uint64_t id, const std::string& why )
+  {
+    std::cerr << "dropping client " << id << ": " << why << "\n";
+    clients_.erase( id );
+  }
+
+  /* write as much of the client's buffered replies as its socket takes; false if the client is gone */
+  bool flush( const uint64_t id, Client& client )
+  {
+    try {
+      while ( not client.output.empty() ) {
+        const size_t n = client.socket.write_some( client.output );
+        if ( n == 0 ) {
+          break; /* wait for POLLOUT */
+        }
+        client.output.erase( 0, n );
+      }
+    } catch ( const unix_error& e ) {
+      drop( id, e.what() );
+      return false;
+    }
+    return true;
+  }
+
+  void run_batch()
+  {
+    const size_t n = std::min<size_t>( pending_.size(), Batched::max_batch_size );
+    for ( size_t i = 0; i < n; i++ ) {
+      batch_requests_[i] = pending_[i].request;
+    }
+    batched_.apply( batch_requests_.data(), n, batch_responses_.data() );
+
+    /* append each reply to its client's buffer, in request order */
+    for ( size_t i = 0; i < n; i++ ) {
+      auto client = clients_.find( pending_[i].client );
+      if ( client == clients_.end() ) {
+        continue; /* dropped while its requests were queued */
+      }
+      client->second.output.append( reinterpret_cast<const char*>( &batch_responses_[i] ),
+                                    sizeof( inference::Response ) );
+      client->second.queued--;
+    }
+    pending_.erase( pending_.begin(), pending_.begin() + n );
+
+    stats_.requests += n;
+    stats_.batches++;
+  }
+
+  /* read what the client sent and queue its complete requests */
+  void receive( const uint64_t id, Client& client )
+  {
+    size_t bytes_read = 0;
+    try {
+      bytes_read = client.socket.read( string_span { read_buffer_.data(), read_buffer_.size() } );
+    } catch ( const unix_error& e ) {
+      drop( id, e.what() );
+      return;
+    }
+
+    if ( client.socket.eof() ) {
+      client.eof = true;
+      return;
+    }
+
+    client.input.append( read_buffer_.data(), bytes_read );
+    const uint64_t now = Timer::timestamp_ns();
+    size_t offset = 0;
+    for ( ; offset + sizeof( inference::Request ) <= client.input.size(); offset += sizeof( inference::Request ) ) {
+      PendingRequest& entry = pending_.emplace_back( PendingRequest { id, now, {} } );
+      memcpy( &entry.request, client.input.data() + offset, sizeof( inference::Request ) );
+      client.queued++;
+    }
+    client.input.erase( 0, offset );
+  }
+
+public:
+  /* listener must already be listening */
+  InferenceServer( Batched& batched, LocalStreamSocket&& listener, const uint64_t deadline_ns )
+    : batched_( batched )
+    , listener_( std::move( listener ) )
+    , deadline_ns_( deadline_ns )
+  {}
+
+  /* serve a connected socket (e.g. one end of LocalStreamSocket::make_pair) as if it had been accepted */
+  void add_client( LocalStreamSocket&& socket )
+  {
+    socket.set_blocking( false );
+    clients_.emplace( next_client_id_++, Client { std::move( socket ) } );
+  }
+
+  /*
+   * Function Name: poll_once
+   * Description: This function waits until a socket is ready or the oldest
+   *              queued request reaches its deadline (or max_wait_ns, if
+   *              given), then accepts, reads, runs the batches that are due
+   *              and writes the replies that the sockets take.
+   */
+  void poll_once( const int64_t max_wait_ns = -1 )
+  {
+    pollfds_.clear();
+    pollfd_clients_.clear();
+    pollfds_.push_back( { listener_.fd_num(), POLLIN, 0 } );
+    for ( const auto& [id, client] : clients_ ) {
+      short events = 0;
+      if ( not client.eof and client.output.size() < max_buffered_output ) {
+        events |= POLLIN;
+      }
+      if ( not client.output.empty() ) {
+        events |= POLLOUT;
+      }
+      /* poll ignores negative fds: a client with nothing to read or write waits for its queued requests */
+      pollfds_.push_back( { events ? client.socket.fd_num() : -1, events, 0 } );
+      pollfd_clients_.push_back( id );
+    }
+
+    /* sleep until a socket is ready, or until the oldest pending request's deadline */
+    int64_t wait = max_wait_ns;
+    if ( not pending_.empty() ) {
+      const uint64_t now = Timer::timestamp_ns();
+      const uint64_t batch_deadline = pending_.front().arrival_ns + deadline_ns_;
+      const int64_t until_deadline = batch_deadline > now ? batch_deadline - now : 0;
+      wait = wait < 0 ? until_deadline : std::min( wait, until_deadline );
+    }
+    timespec timeout { static_cast<time_t>( wait / BILLION ), static_cast<long>( wait % int64_t( BILLION ) ) };
+    CheckSystemCall( "ppoll", ppoll( pollfds_.data(), pollfds_.size(), wait < 0 ? nullptr : &timeout, nullptr ) );
+
+    if ( pollfds_.front().revents & POLLIN ) {
+      add_client( listener_.accept() );
+    }
+
+    for ( size_t i = 1; i < pollfds_.size(); i++ ) {
+      const uint64_t id = pollfd_clients_[i - 1];
+      Client& client = clients_.at( id );
+      const short revents = pollfds_[i].revents;
+
+      if ( ( revents & POLLOUT ) and not flush( id, client ) ) {
+        continue;
+      }
+      if ( revents & ( POLLIN | POLLHUP | POLLERR ) and not client.eof ) {
+        receive( id, client );
+      }
+    }
+
+    while ( pending_.size() >= Batched::max_batch_size ) {
+      run_batch();
+    }
+
+    if ( not pending_.empty() and Timer::timestamp_ns() >= pending_.front().arrival_ns + deadline_ns_ ) {
+      stats_.deadline_batches++;
+      run_batch();
+    }
+
+    /* write new replies right away; whatever a socket does not take waits for POLLOUT */
+    for ( auto it = clients_.begin(); it != clients_.end(); ) {
+      auto& [id, client] = *it++;
+      if ( flush( id, client ) and client.done() ) {
+        clients_.erase( id );
+        if ( clients_.empty() ) {
+          print_stats();
+        }
+      }
+    }
+  }
+
+  /* answer requests until killed */
+  void serve()
+  {
+    while ( true ) {
+      poll_once();
+    }
+  }
+
+  void print_stats() const
+  {
+    std::cerr << "served " << stats_.requests << " requests in " << stats_.batches << " batches (mean batch "
+              << stats_.requests / double( std::max<uint64_t>( stats_.batches, 1 ) ) << ", "
+              << stats_.deadline_batches << " cut by the deadline)\n";
+  }
+
+  const ServerStats& stats() const { return stats_; }
+  size_t num_clients() const { return clients_.size(); }
+  size_t queued() const { return pending_.size(); }
+
+  /* bytes of replies waiting for each client's socket to become writable */
+  size_t buffered_output() const
+  {
+    size_t total = 0;
+    for ( const auto& [id, client] : clients_ ) {
+      total += client.output.size();
+    }
+    return total;
+  }
+};
@@ -0,0 +1,196 @@
+/**
+ * File name: onset_log.hh
+ * Last Update: October 2026
+ * Description: A compact binary log of timestamped onsets from many streams,
+ *              so that live note events can be replayed (onset_replay).
+ *
+ *              Layout (native byte order):
+ *                char     magic[8]     "NNFONLOG"
+ *                uint32_t num_streams
+ *                float    tempo[num_streams]   true tempo (bpm), 0 if unknown
+ *                then 12-byte records, in the order the onsets were seen:
+ *                  uint64_t time_ns   since the log was opened
+ *                  uint32_t stream
+ *
+ *              OnsetLogWriter collects records in a RingBuffer and writes
+ *              them out with RingBuffer::pop_to_fd in large chunks (from an
+ *              EventLoop rule, or when the buffer fills). OnsetLog maps a log
+ *              with ReadOnlyFile; a truncated last record is ignored.
+ *              OnsetReplayer feeds a log's onsets back through the streaming
+ *              tempo path (tempo_stream.hh).
+ */
+
+#pragma once
+
+#include "exception.hh"
+#include "file_descriptor.hh"
+#include "mmap.hh"
+#include "ring_buffer.hh"
+#include "tempo_stream.hh"
+#include "timer.hh"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace onset_log {
+
+constexpr std::array<char, 8> magic { 'N', 'N', 'F', 'O', 'N', 'L', 'O', 'G' };
+constexpr size_t record_size = sizeof( uint64_t ) + sizeof( uint32_t );
+
+struct Onset
+{
+  uint64_t time_ns;
+  uint32_t stream;
+};
+
+}
+
+class OnsetLogWriter
+{
+  constexpr static size_t buffer_capacity = 1 << 20;
+  // write out once this much is buffered
+  constexpr static size_t flush_threshold = buffer_capacity / 4;
+
+  FileDescriptor fd_;
+  RingBuffer buffer_ { buffer_capacity };
+  uint64_t start_ns_ = Timer::timestamp_ns();
+  uint64_t num_records_ {};
+
+public:
+  OnsetLogWriter( const std::string& filename, const std::vector<float>& tempos )
+    : fd_( CheckSystemCall( "open( \"" + filename + "\" )",
+                            open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 ) ) )
+  {
+    const uint32_t num_streams = tempos.size();
+    std::string header( onset_log::magic.data(), onset_log::magic.size() );
+    header.append( reinterpret_cast<const char*>( &num_streams ), sizeof( num_streams ) );
+    header.append( reinterpret_cast<const char*>( tempos.data() ), tempos.size() * sizeof( float ) );
+    if ( buffer_.push_from_const_str( header ) != header.size() ) {
+      throw std::runtime_error( "OnsetLogWriter: header too large" );
+    }
+  }
+
+  ~OnsetLogWriter()
+  {
+    try {
+      flush();
+    } catch ( const std::exception& e ) {
+      std::cerr << "Exception destructing OnsetLogWriter: " << e.what() << std::endl;
+    }
+  }
+
+  /* Disallow copying */
+  OnsetLogWriter( const OnsetLogWriter& other ) = delete;
+  OnsetLogWriter& operator=( const OnsetLogWriter& other ) = delete;
+
+  /* log an onset at time_ns (Timer::timestamp_ns clock) */
+  void record( const uint32_t stream, const uint64_t time_ns )
+  {
+    if ( buffer_.writable_region().size() < onset_log::record_size ) {
+      flush();
+    }
+
+    const uint64_t relative_ns = time_ns > start_ns_ ? time_ns - start_ns_ : 0;
+    string_span region = buffer_.writable_region();
+    memcpy( region.mutable_data(), &relative_ns, sizeof( relative_ns ) );
+    memcpy( region.mutable_data() + sizeof( relative_ns ), &stream, sizeof( stream ) );
+    buffer_.push( onset_log::record_size );
+    num_records_++;
+  }
+
+  bool wants_flush() const { return buffer_.bytes_stored() >= flush_threshold; }
+
+  /* write out everything buffered */
+  void flush()
+  {
+    while ( buffer_.bytes_stored() > 0 ) {
+      buffer_.pop_to_fd( fd_ );
+    }
+  }
+
+  uint64_t num_records() const { return num_records_; }
+};
+
+class OnsetLog
+{
+  ReadOnlyFile file_;
+  std::vector<float> tempos_ {};
+  size_t records_offset_ {};
+  size_t num_onsets_ {};
+
+public:
+  explicit OnsetLog( const std::string& filename )
+    : file_( filename )
+  {
+    const std::string_view contents = file_;
+    uint32_t num_streams;
+    if ( contents.size() < onset_log::magic.size() + sizeof( num_streams )
+         or memcmp( contents.data(), onset_log::magic.data(), onset_log::magic.size() ) ) {
+      throw std::runtime_error( filename + ": not an onset log" );
+    }
+    memcpy( &num_streams, contents.data() + onset_log::magic.size(), sizeof( num_streams ) );
+
+    records_offset_ = onset_log::magic.size() + sizeof( num_streams ) + num_streams * sizeof( float );
+    if ( contents.size() < records_offset_ ) {
+      throw std::runtime_error( filename + ": truncated onset log header" );
+    }
+    tempos_.resize( num_streams );
+    memcpy( tempos_.data(),
+            contents.data() + onset_log::magic.size() + sizeof( num_streams ),
+            num_streams * sizeof( float ) );
+
+    num_onsets_ = ( contents.size() - records_offset_ ) / onset_log::record_size;
+  }
+
+  size_t num_streams() const { return tempos_.size(); }
+  float tempo( const size_t stream ) const { return tempos_.at( stream ); }
+  size_t size() const { return num_onsets_; }
+
+  onset_log::Onset operator[]( const size_t i ) const
+  {
+    const char* record = file_.addr() + records_offset_ + i * onset_log::record_size;
+    onset_log::Onset ret;
+    memcpy( &ret.time_ns, record, sizeof( ret.time_ns ) );
+    memcpy( &ret.stream, record + sizeof( ret.time_ns ), sizeof( ret.stream ) );
+    if ( ret.stream >= tempos_.size() ) {
+      throw std::runtime_error( "onset log: record " + std::to_string( i ) + " has a bad stream number" );
+    }
+    return ret;
+  }
+};
+
+/*
+ * Class Name: OnsetReplayer
+ * Description: Feeds the onsets of a log, in order, to one OnsetParser per
+ *              stream, encoded as they arrived on the wire (a Timestamps
+ *              stream, on a clock that starts at start_ns), so that a replay
+ *              sees the windows the live streams did.
+ */
+class OnsetReplayer
+{
+  std::vector<tempo_stream::OnsetParser> parsers_;
+  uint64_t start_ns_;
+
+public:
+  OnsetReplayer( const size_t num_streams, const uint64_t start_ns )
+    : parsers_( num_streams, tempo_stream::OnsetParser { tempo_stream::Format::Timestamps } )
+    , start_ns_( start_ns )
+  {}
+
+  /* parse an onset received at now_ns, and return whether its stream has a full window */
+  bool feed( const onset_log::Onset& onset, const uint64_t now_ns )
+  {
+    const uint64_t wire_time_ns = start_ns_ + onset.time_ns;
+    tempo_stream::OnsetParser& parser = parsers_.at( onset.stream );
+    parser.parse( { reinterpret_cast<const char*>( &wire_time_ns ), sizeof( wire_time_ns ) }, now_ns );
+    return parser.window_full();
+  }
+
+  const tempo_stream::OnsetParser& parser( const size_t stream ) const { return parsers_.at( stream ); }
+};
@@ -0,0 +1,171 @@
+#include "perf_counters.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+perf_event_attr event_attr( const PerfCounters::Event event )
+{
+  perf_event_attr attr;
+  memset( &attr, 0, sizeof( attr ) );
+  attr.size = sizeof( attr );
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  switch ( event ) {
+    case PerfCounters::Event::Cycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PerfCounters::Event::Instructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfCounters::Event::LLCMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case PerfCounters::Event::DTLBMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_DTLB | ( PERF_COUNT_HW_CACHE_OP_READ << 8 )
+                    | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+      break;
+    default:
+      throw runtime_error( "PerfCounters: unknown event" );
+  }
+
+  return attr;
+}
+
+}
+
+PerfCounters::PerfCounters()
+{
+  for ( size_t i = 0; i < num_events; i++ ) {
+    perf_event_attr attr = event_attr( static_cast<Event>( i ) );
+    const int group_fd = _fds.empty() ? -1 : _fds.front().fd_num();
+
+    const int fd = syscall( SYS_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, group_fd, 0 );
+    if ( fd < 0 ) {
+      _error += string( _error.empty() ? "" : "; " ) + _event_names.at( i ) + ": " + strerror( errno );
+      continue;
+    }
+
+    _slot[i] = _fds.size();
+    _fds.emplace_back( fd );
+  }
+}
+
+PerfCounters::Reading PerfCounters::read_raw()
+{
+  Reading ret {};
+
+  if ( not available() ) {
+    return ret;
+  }
+
+  /* PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, then one value per event in the group */
+  array<uint64_t, 3 + num_events> buf {};
+  const size_t bytes_read
+    = _fds.front().read( { reinterpret_cast<char*>( buf.data() ), ( 3 + _fds.size() ) * sizeof( uint64_t ) } );
+  if ( bytes_read < ( 3 + _fds.size() ) * sizeof( uint64_t ) or buf[0] != _fds.size() ) {
+    throw runtime_error( "PerfCounters: short or mismatched group read" );
+  }
+
+  ret.time_enabled = buf[1];
+  ret.time_running = buf[2];
+  for ( size_t i = 0; i < num_events; i++ ) {
+    if ( _slot[i].has_value() ) {
+      ret.raw[i] = buf[3 + _slot[i].value()];
+    }
+  }
+
+  return ret;
+}
+
+optional<PerfCounters::Reading> PerfCounters::try_read() noexcept
+{
+  try {
+    return read_raw();
+  } catch ( const exception& ) {
+    return nullopt;
+  }
+}
+
+PerfCounters::Sample PerfCounters::scaled_delta( const Reading& start, const Reading& end )
+{
+  /* if the PMU was multiplexed between groups during the interval, extrapolate to the whole interval */
+  const uint64_t enabled = end.time_enabled - start.time_enabled;
+  const uint64_t running = end.time_running - start.time_running;
+  const double scale = ( running > 0 and running < enabled ) ? double( enabled ) / running : 1.0;
+
+  Sample ret {};
+  for ( size_t i = 0; i < num_events; i++ ) {
+    ret[i] = ( end.raw[i] - start.raw[i] ) * scale;
+  }
+  return ret;
+}
+
+PerfCounters& thread_perf_counters()
+{
+  thread_local PerfCounters counters;
+  return counters;
+}
+
+void PerfCounters::summary( ostream& out, const vector<pair<string, reference_wrapper<const Record>>>& records ) const
+{
+  out << "Hardware counter summary\n------------------------\n\n";
+
+  if ( not available() ) {
+    out << "Hardware counters unavailable (" << _error << "); reporting wall time only.\n\n";
+  } else if ( not _error.empty() ) {
+    out << "Some counters unavailable (" << _error << ").\n\n";
+  }
+
+  const auto cycles = static_cast<size_t>( Event::Cycles );
+  const auto instructions = static_cast<size_t>( Event::Instructions );
+
+  for ( const auto& [name, record_ref] : records ) {
+    const Record& record = record_ref.get();
+    out << "   " << name << ": " << string( name.size() < 28 ? 28 - name.size() : 0, ' ' );
+    out << "[count=" << record.count << "]";
+    if ( record.count > 0 ) {
+      out << " [mean=";
+      Timer::pp_ns( out, record.total_ns / record.count );
+      out << "]";
+    }
+    out << "\n";
+
+    if ( record.count == 0 ) {
+      continue;
+    }
+
+    for ( size_t i = 0; i < num_events; i++ ) {
+      if ( not _slot[i].has_value() ) {
+        continue;
+      }
+      out << "      " << _event_names.at( i ) << ": " << string( 16 - strlen( _event_names.at( i ) ), ' ' );
+      out << fixed << setprecision( 0 ) << setw( 14 ) << record.totals[i] / double( record.count ) << " per call";
+      if ( i != cycles and i != instructions and available( Event::Instructions )
+           and record.totals[instructions] > 0 ) {
+        out << "  (" << setprecision( 3 ) << 1000.0 * record.totals[i] / record.totals[instructions]
+            << " per 1k instructions)";
+      }
+      out << "\n";
+    }
+
+    if ( available( Event::Cycles ) and available( Event::Instructions ) and record.totals[cycles] > 0 ) {
+      out << "      IPC: " << string( 16 - 3, ' ' ) << setprecision( 2 ) << setw( 14 )
+          << record.totals[instructions] / double( record.totals[cycles] ) << "\n";
+    }
+  }
+}
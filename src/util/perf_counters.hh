@@ -0,0 +1,140 @@
+#pragma once
+
+#include "file_descriptor.hh"
+#include "timer.hh"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Class Name: PerfCounters
+ * Description: A group of hardware counters for the calling thread, opened
+ *              with perf_event_open(2) and read together so the values cover
+ *              the same interval: cycles, instructions, last-level cache
+ *              misses and data TLB misses. Only user-space events are
+ *              counted, which is allowed at the default perf_event_paranoid
+ *              setting.
+ *              If the kernel or the machine does not provide an event (no
+ *              PMU in a VM, perf disabled, seccomp), that counter reads as
+ *              unavailable. If the group cannot be opened at all, available()
+ *              is false and every read returns zeros.
+ */
+class PerfCounters
+{
+public:
+  enum class Event
+  {
+    Cycles,
+    Instructions,
+    LLCMisses,
+    DTLBMisses,
+    count
+  };
+
+  constexpr static size_t num_events = static_cast<size_t>( Event::count );
+
+  constexpr static std::array<const char*, num_events> _event_names { { "cycles",
+                                                                        "instructions",
+                                                                        "LLC misses",
+                                                                        "dTLB misses" } };
+
+  using Sample = std::array<uint64_t, num_events>;
+
+  /* one group read, unscaled: the raw counts and how long the group was enabled and on the PMU */
+  struct Reading
+  {
+    uint64_t time_enabled;
+    uint64_t time_running;
+    Sample raw;
+  };
+
+  struct Record
+  {
+    uint64_t count;
+    uint64_t total_ns;
+    Sample totals;
+
+    void log( const uint64_t time_ns, const Sample& delta )
+    {
+      count++;
+      total_ns += time_ns;
+      for ( size_t i = 0; i < num_events; i++ ) {
+        totals[i] += delta[i];
+      }
+    }
+
+    void reset() { *this = Record {}; }
+  };
+
+private:
+  std::vector<FileDescriptor> _fds {};
+  std::array<std::optional<size_t>, num_events> _slot {}; /* position of each event in a group read */
+  std::string _error {};
+
+public:
+  /* open the counter group for the calling thread */
+  PerfCounters();
+
+  bool available() const { return not _fds.empty(); }
+  bool available( const Event event ) const { return _slot[static_cast<size_t>( event )].has_value(); }
+
+  /* why the group (or some event in it) could not be opened; empty if everything is counting */
+  const std::string& error() const { return _error; }
+
+  /* current values of all counters, scaled for multiplexing (unavailable ones read as zero) */
+  Sample read() { return scaled_delta( {}, read_raw() ); }
+
+  /* the raw group values; throws if the read fails */
+  Reading read_raw();
+
+  /* same as read_raw, but empty if the read fails */
+  std::optional<Reading> try_read() noexcept;
+
+  /* the counts between two readings. If the PMU was multiplexed between groups, the raw differences are
+     extrapolated by the share of the interval the group was running, not by each reading's whole lifetime. */
+  static Sample scaled_delta( const Reading& start, const Reading& end );
+
+  /* print a table of records, with IPC and misses per thousand instructions */
+  void summary( std::ostream& out,
+                const std::vector<std::pair<std::string, std::reference_wrapper<const Record>>>& records ) const;
+};
+
+/* the calling thread's counter group, opened on first use */
+PerfCounters& thread_perf_counters();
+
+/* counts a scope into a PerfCounters::Record, like RecordOnlyScopeTimer does for a Timer::Record.
+   Never throws: a scope whose counters could not be read is left out of the record. */
+class PerfScopeCounter
+{
+  PerfCounters* _counters;
+  PerfCounters::Record* _record;
+  uint64_t _start_time;
+  std::optional<PerfCounters::Reading> _start;
+
+public:
+  PerfScopeCounter( PerfCounters& counters, PerfCounters::Record& record )
+    : _counters( &counters )
+    , _record( &record )
+    , _start_time( Timer::timestamp_ns() )
+    , _start( counters.try_read() )
+  {}
+
+  ~PerfScopeCounter()
+  {
+    const std::optional<PerfCounters::Reading> end = _counters->try_read();
+    const uint64_t now = Timer::timestamp_ns();
+
+    if ( _start.has_value() and end.has_value() ) {
+      _record->log( now - _start_time, PerfCounters::scaled_delta( _start.value(), end.value() ) );
+    }
+  }
+
+  PerfScopeCounter( const PerfScopeCounter& ) = delete;
+  PerfScopeCounter& operator=( const PerfScopeCounter& ) = delete;
+};
@@ -0,0 +1,79 @@
+#include "socket.hh"
+#include "exception.hh"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+sockaddr_un local_address( const string& path )
+{
+  sockaddr_un addr;
+  memset( &addr, 0, sizeof( addr ) );
+  addr.sun_family = AF_UNIX;
+
+  if ( path.size() >= sizeof( addr.sun_path ) ) {
+    throw runtime_error( "socket path too long: " + path );
+  }
+  memcpy( addr.sun_path, path.data(), path.size() );
+
+  return addr;
+}
+
+}
+
+LocalStreamSocket::LocalStreamSocket( FileDescriptor&& fd )
+  : FileDescriptor( move( fd ) )
+{}
+
+LocalStreamSocket::LocalStreamSocket()
+  : FileDescriptor( ::CheckSystemCall( "socket", socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) ) )
+{}
+
+void LocalStreamSocket::bind( const string& path )
+{
+  struct stat info;
+  if ( lstat( path.c_str(), &info ) == 0 and S_ISSOCK( info.st_mode ) ) {
+    CheckSystemCall( "unlink( \"" + path + "\" )", unlink( path.c_str() ) );
+  }
+
+  const sockaddr_un addr = local_address( path );
+  CheckSystemCall( "bind( \"" + path + "\" )",
+                   ::bind( fd_num(), reinterpret_cast<const sockaddr*>( &addr ), sizeof( addr ) ) );
+}
+
+void LocalStreamSocket::listen( const int backlog )
+{
+  CheckSystemCall( "listen", ::listen( fd_num(), backlog ) );
+}
+
+LocalStreamSocket LocalStreamSocket::accept()
+{
+  register_read();
+  return LocalStreamSocket(
+    FileDescriptor { CheckSystemCall( "accept", ::accept4( fd_num(), nullptr, nullptr, SOCK_CLOEXEC ) ) } );
+}
+
+void LocalStreamSocket::connect( const string& path )
+{
+  const sockaddr_un addr = local_address( path );
+  CheckSystemCall( "connect( \"" + path + "\" )",
+                   ::connect( fd_num(), reinterpret_cast<const sockaddr*>( &addr ), sizeof( addr ) ) );
+}
+
+void LocalStreamSocket::shutdown_write()
+{
+  CheckSystemCall( "shutdown", ::shutdown( fd_num(), SHUT_WR ) );
+}
+
+pair<LocalStreamSocket, LocalStreamSocket> LocalStreamSocket::make_pair()
+{
+  int fds[2];
+  ::CheckSystemCall( "socketpair", socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds ) );
+  return { LocalStreamSocket { FileDescriptor { fds[0] } }, LocalStreamSocket { FileDescriptor { fds[1] } } };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <string>
+#include <utility>
+
+//! A stream socket in the Unix (local) domain, addressed by a filesystem path
+class LocalStreamSocket : public FileDescriptor
+{
+  //! Wrap a socket returned by accept()
+  explicit LocalStreamSocket( FileDescriptor&& fd );
+
+public:
+  //! Create an unconnected socket
+  LocalStreamSocket();
+
+  //! Bind to `path`, replacing a stale socket file left there by an earlier server
+  void bind( const std::string& path );
+
+  //! Listen for incoming connections
+  void listen( const int backlog = 64 );
+
+  //! Accept a connection from the listen queue
+  LocalStreamSocket accept();
+
+  //! Connect to a server bound to `path`
+  void connect( const std::string& path );
+
+  //! Shut down the writing direction, so the peer reads EOF
+  void shutdown_write();
+
+  //! Create a pair of connected sockets
+  static std::pair<LocalStreamSocket, LocalStreamSocket> make_pair();
+};
@@ -0,0 +1,151 @@
+/**
+ * File name: tempo_stream.hh
+ * Last Update: October 2026
+ * Description: Parsing of onset-event streams into the 16-timestamp windows
+ *              that the tempo network (16 timestamps -> bpm) takes as input.
+ *
+ *              A stream is a byte stream (a pipe, a socket, a MIDI device)
+ *              in one of two formats:
+ *                Timestamps: each onset is a uint64_t (native byte order),
+ *                            its time in ns on the sender's steady clock
+ *                Midi:       MIDI messages; each note-on with a nonzero
+ *                            velocity is an onset, at the time it is read
+ */
+
+#pragma once
+
+#include "eigen.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace tempo_stream {
+
+constexpr unsigned int window_size = 16;
+
+enum class Format
+{
+  Timestamps,
+  Midi
+};
+
+/* the MIDI messages written by a stand-in device: note-on and note-off of one key */
+constexpr std::array<char, 3> midi_note_on { char( 0x90 ), 60, 100 };
+constexpr std::array<char, 3> midi_note_off { char( 0x80 ), 60, 0 };
+
+/*
+ * Class Name: OnsetParser
+ * Description: Splits a stream's bytes into onsets (carrying partial records
+ *              over to the next read) and keeps the last window_size onset
+ *              times.
+ */
+class OnsetParser
+{
+  Format format_;
+  std::string partial_ {};
+
+  std::array<uint64_t, window_size> onsets_ns_ {};
+  uint64_t num_onsets_ {};
+
+  // running MIDI status byte and the data bytes of the current message
+  uint8_t midi_status_ {};
+  std::array<uint8_t, 2> midi_data_ {};
+  unsigned int midi_num_data_ {};
+
+  template<class OnOnset>
+  void add_onset( const uint64_t time_ns, OnOnset&& on_onset )
+  {
+    onsets_ns_[num_onsets_++ % window_size] = time_ns;
+    on_onset( time_ns );
+  }
+
+  template<class OnOnset>
+  void parse_midi_byte( const uint8_t byte, const uint64_t now_ns, OnOnset&& on_onset )
+  {
+    if ( byte & 0x80 ) {
+      /* status byte (real-time messages, 0xF8 and up, do not interrupt a message) */
+      if ( byte < 0xF8 ) {
+        midi_status_ = byte;
+        midi_num_data_ = 0;
+      }
+      return;
+    }
+
+    if ( midi_status_ < 0x80 or midi_status_ >= 0xF0 ) {
+      return; /* no channel message in progress */
+    }
+
+    midi_data_.at( midi_num_data_++ ) = byte;
+    const unsigned int message_length = ( ( midi_status_ & 0xF0 ) == 0xC0 or ( midi_status_ & 0xF0 ) == 0xD0 ) ? 1 : 2;
+    if ( midi_num_data_ == message_length ) {
+      midi_num_data_ = 0; /* running status: the next data bytes start a new message */
+      if ( ( midi_status_ & 0xF0 ) == 0x90 and midi_data_[1] > 0 ) {
+        add_onset( now_ns, on_onset );
+      }
+    }
+  }
+
+public:
+  explicit OnsetParser( const Format format )
+    : format_( format )
+  {}
+
+  /* parse bytes read at now_ns; calls on_onset( time_ns ) for each new onset, and returns their number */
+  template<class OnOnset>
+  unsigned int parse( std::string_view bytes, const uint64_t now_ns, OnOnset&& on_onset )
+  {
+    const uint64_t onsets_before = num_onsets_;
+
+    if ( format_ == Format::Midi ) {
+      for ( const char c : bytes ) {
+        parse_midi_byte( c, now_ns, on_onset );
+      }
+    } else {
+      if ( not partial_.empty() ) {
+        const size_t needed = std::min( sizeof( uint64_t ) - partial_.size(), bytes.size() );
+        partial_.append( bytes.substr( 0, needed ) );
+        bytes.remove_prefix( needed );
+        if ( partial_.size() == sizeof( uint64_t ) ) {
+          uint64_t time_ns;
+          memcpy( &time_ns, partial_.data(), sizeof( time_ns ) );
+          add_onset( time_ns, on_onset );
+          partial_.clear();
+        }
+      }
+      while ( bytes.size() >= sizeof( uint64_t ) ) {
+        uint64_t time_ns;
+        memcpy( &time_ns, bytes.data(), sizeof( time_ns ) );
+        add_onset( time_ns, on_onset );
+        bytes.remove_prefix( sizeof( uint64_t ) );
+      }
+      partial_.append( bytes );
+    }
+
+    return num_onsets_ - onsets_before;
+  }
+
+  unsigned int parse( const std::string_view bytes, const uint64_t now_ns )
+  {
+    return parse( bytes, now_ns, []( uint64_t ) {} );
+  }
+
+  uint64_t num_onsets() const { return num_onsets_; }
+  bool window_full() const { return num_onsets_ >= window_size; }
+
+  /* the last window_size onsets, in seconds since the first of them (the network's input) */
+  Eigen::Matrix<float, 1, window_size> window() const
+  {
+    Eigen::Matrix<float, 1, window_size> ret;
+    const uint64_t first = onsets_ns_[num_onsets_ % window_size];
+    for ( unsigned int i = 0; i < window_size; i++ ) {
+      ret( i ) = ( onsets_ns_[( num_onsets_ + i ) % window_size] - first ) / 1e9;
+    }
+    return ret;
+  }
+};
+
+}
@@ -0,0 +1,138 @@
+#include "thread_pool.hh"
+#include "affinity.hh"
+
+#include <cerrno>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+// set on the threads whose parallel_for calls run all their tasks themselves
+thread_local bool run_inline = false;
+
+/* NN_LAYER_THREADS if it is a positive number, or else the number of available CPUs (or 1 if that is unknown) */
+unsigned int layer_threads()
+{
+  if ( const char* threads = getenv( "NN_LAYER_THREADS" ) ) {
+    char* end;
+    errno = 0;
+    const unsigned long n = strtoul( threads, &end, 10 );
+    if ( end != threads and *end == '\0' and errno == 0 and n > 0 and n <= numeric_limits<unsigned int>::max() ) {
+      return n;
+    }
+    cerr << "ThreadPool: ignoring NN_LAYER_THREADS=\"" << threads << "\" (not a positive number)\n";
+  }
+
+  try {
+    return available_cpus().size();
+  } catch ( const exception& ) {
+    return 1;
+  }
+}
+
+}
+
+ThreadPool::ThreadPool( const unsigned int num_threads )
+{
+  for ( unsigned int worker = 1; worker < num_threads; worker++ ) {
+    workers_.emplace_back( &ThreadPool::work, this, worker );
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    unique_lock lock { mutex_ };
+    stopping_ = true;
+  }
+  wake_.notify_all();
+
+  for ( auto& worker : workers_ ) {
+    worker.join();
+  }
+}
+
+void ThreadPool::work( const unsigned int worker )
+{
+  run_inline_on_this_thread();
+
+  /* worker i shares a CPU with the caller only when there are fewer CPUs than threads */
+  try {
+    const vector<unsigned int> cpus = available_cpus();
+    pin_this_thread( cpus.at( worker % cpus.size() ) );
+  } catch ( const exception& ) {
+    /* an unpinned worker still computes the right result */
+  }
+
+  uint64_t seen = 0;
+  while ( true ) {
+    Job job;
+    const void* context;
+    unsigned int num_tasks;
+    {
+      unique_lock lock { mutex_ };
+      wake_.wait( lock, [&] { return stopping_ or generation_ != seen; } );
+      if ( stopping_ ) {
+        return;
+      }
+      seen = generation_;
+      job = job_;
+      context = context_;
+      num_tasks = num_tasks_;
+    }
+
+    for ( unsigned int task = next_task_++; task < num_tasks; task = next_task_++ ) {
+      job( context, task );
+    }
+    busy_workers_.fetch_sub( 1, memory_order_release );
+  }
+}
+
+void ThreadPool::run( const Job job, const void* context, const unsigned int num_tasks )
+{
+  unique_lock caller_lock { caller_mutex_, defer_lock };
+  if ( workers_.empty() or num_tasks <= 1 or run_inline or not caller_lock.try_lock() ) {
+    for ( unsigned int task = 0; task < num_tasks; task++ ) {
+      job( context, task );
+    }
+    return;
+  }
+
+  {
+    unique_lock lock { mutex_ };
+    job_ = job;
+    context_ = context;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    busy_workers_ = workers_.size();
+    generation_++;
+  }
+  wake_.notify_all();
+
+  /* a parallel_for inside one of the caller's tasks runs inline (rather than try to lock caller_mutex_ again) */
+  run_inline = true;
+  for ( unsigned int task = next_task_++; task < num_tasks; task = next_task_++ ) {
+    job( context, task );
+  }
+  run_inline = false;
+
+  /* every worker checks in, so none is still reading this job when the next one is set */
+  while ( busy_workers_.load( memory_order_acquire ) > 0 ) {
+    this_thread::yield();
+  }
+}
+
+void ThreadPool::run_inline_on_this_thread()
+{
+  run_inline = true;
+}
+
+ThreadPool& ThreadPool::layers()
+{
+  static ThreadPool pool { layer_threads() };
+  return pool;
+}
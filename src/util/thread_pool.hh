@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Class Name: ThreadPool
+ * Description: A fixed set of worker threads, each pinned to one of the CPUs
+ *              this process may run on, that share the tasks of one
+ *              parallel_for at a time. Threads are created once, with the
+ *              pool; a parallel_for only wakes them, and the calling thread
+ *              runs tasks too, so a pool of size n uses n - 1 workers.
+ *
+ *              One parallel_for runs at a time. A parallel_for called while
+ *              another is running (from another thread, or from inside one
+ *              of its tasks) runs all its tasks on the calling thread, so
+ *              concurrently trained networks do not wait on each other.
+ *              So does one called from a pool's worker, or from a thread
+ *              that called run_inline_on_this_thread (a worker that already
+ *              has a CPU of its own, e.g. one per CPU in GradientChecker),
+ *              so a pool does not oversubscribe the CPUs of other workers.
+ *              Tasks must not throw.
+ */
+class ThreadPool
+{
+  using Job = void ( * )( const void* context, unsigned int task );
+
+  std::vector<std::thread> workers_ {};
+
+  // the job of the current parallel_for, and a count of parallel_for calls that workers wake on
+  std::mutex mutex_ {};
+  std::condition_variable wake_ {};
+  uint64_t generation_ = 0;
+  bool stopping_ = false;
+  Job job_ = nullptr;
+  const void* context_ = nullptr;
+  unsigned int num_tasks_ = 0;
+
+  std::atomic<unsigned int> next_task_ { 0 };
+  std::atomic<unsigned int> busy_workers_ { 0 };
+
+  // held for the length of a parallel_for
+  std::mutex caller_mutex_ {};
+
+  void work( const unsigned int worker );
+  void run( const Job job, const void* context, const unsigned int num_tasks );
+
+public:
+  //! Start num_threads - 1 pinned workers (num_threads counts the calling thread)
+  explicit ThreadPool( const unsigned int num_threads );
+  ~ThreadPool();
+
+  /* Disallow copying */
+  ThreadPool( const ThreadPool& other ) = delete;
+  ThreadPool& operator=( const ThreadPool& other ) = delete;
+
+  //! Number of threads that run tasks, including the caller of parallel_for
+  unsigned int size() const { return workers_.size() + 1; }
+
+  //! Call f( task ) for every task in [0, num_tasks) across the pool, and return when all are done
+  template<class F>
+  void parallel_for( const unsigned int num_tasks, const F& f )
+  {
+    run( []( const void* context, const unsigned int task ) { ( *static_cast<const F*>( context ) )( task ); },
+         &f,
+         num_tasks );
+  }
+
+  //! Run every parallel_for this thread calls on this thread (for a worker that has a CPU of its own)
+  static void run_inline_on_this_thread();
+
+  //! The pool shared by wide layers (layer.hh): one thread per available CPU, or NN_LAYER_THREADS if positive
+  static ThreadPool& layers();
+};
@@ -1,23 +1,51 @@
 #include "timer.hh"
 #include "exception.hh"
 
+#include <atomic>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <ostream>
+#include <thread>
 
 using namespace std;
 
-void Timer::summary( ostream& out ) const
+void Timer::merge( const Timer& other )
 {
-  const uint64_t now = timestamp_ns();
+  for ( unsigned int i = 0; i < num_categories; i++ ) {
+    _records.at( i ).merge( other._records.at( i ) );
+    _exclusive_ns.at( i ) += other._exclusive_ns.at( i );
+  }
+}
 
-  const uint64_t elapsed = now - _beginning_timestamp;
+void Timer::reset( const uint64_t now )
+{
+  for ( unsigned int i = 0; i < num_categories; i++ ) {
+    _records.at( i ).reset();
+    _exclusive_ns.at( i ) = 0;
+  }
+  for ( size_t i = 0; i < _depth; i++ ) {
+    _stack.at( i ).start = now;
+    _stack.at( i ).children_ns = 0;
+  }
+  _beginning_timestamp = now;
+}
+
+void Timer::summary( ostream& out ) const
+{
+  summary( out, timestamp_ns() - _beginning_timestamp );
+}
 
+void Timer::summary( ostream& out, const uint64_t elapsed, const size_t num_threads ) const
+{
   out << "Global timing summary\n---------------------\n\n";
 
   out << "Total time: ";
-  pp_ns( out, now - _beginning_timestamp );
+  pp_ns( out, elapsed );
+  if ( num_threads > 1 ) {
+    out << " (summed over " << num_threads << " threads)";
+  }
   out << "\n";
 
   uint64_t accounted = 0;
@@ -25,8 +53,8 @@ void Timer::summary( ostream& out ) const
   for ( unsigned int i = 0; i < num_categories; i++ ) {
     out << "   " << _category_names.at( i ) << ": ";
     out << string( 32 - strlen( _category_names.at( i ) ), ' ' );
-    out << fixed << setw( 5 ) << setprecision( 1 ) << 100 * _records.at( i ).total_ns / double( elapsed ) << "%";
-    accounted += _records.at( i ).total_ns;
+    out << fixed << setw( 5 ) << setprecision( 1 ) << 100 * _exclusive_ns.at( i ) / double( elapsed ) << "%";
+    accounted += _exclusive_ns.at( i );
 
     if ( _records.at( i ).count > 0 ) {
       out << "   [mean=";
@@ -39,12 +67,220 @@ void Timer::summary( ostream& out ) const
     out << "[max= ";
     pp_ns( out, _records.at( i ).max_ns );
     out << "]";
+    _records.at( i ).print_percentiles( out );
     out << " [count=" << _records.at( i ).count << "]";
 
     out << "\n";
   }
 
-  const uint64_t unaccounted = elapsed - accounted;
+  const uint64_t unaccounted = elapsed - min( accounted, elapsed );
   out << "\n   Unaccounted: " << string( 23, ' ' );
   out << 100 * unaccounted / double( elapsed ) << "%\n";
+  out << "\n   (shares exclude nested timers; mean, max and percentiles include them)\n";
+  out << defaultfloat;
+}
+
+namespace {
+
+atomic<ThreadTimer*>& registry_head()
+{
+  static atomic<ThreadTimer*> head { nullptr };
+  return head;
+}
+
+/* held by reset_global_timer, by readers of every thread's records, and by threads registering or exiting */
+mutex& registry_mutex()
+{
+  static mutex m;
+  return m;
+}
+
+// longest a reader waits for busy threads to publish a fresh snapshot
+constexpr uint64_t snapshot_wait_ns = 10'000'000;
+
+/* the records of exited threads since the last reset_global_timer (guarded by registry_mutex) */
+struct RetiredRecords
+{
+  Timer timer {};
+  uint64_t elapsed_ns {}; // summed over the threads
+  size_t num_threads {};
+};
+
+RetiredRecords& retired_records()
+{
+  static RetiredRecords retired;
+  return retired;
+}
+
+/* whether the timer's records predate the last reset_global_timer (its thread has not caught up yet) */
+bool stale( const ThreadTimer& entry )
+{
+  return entry.generation.load( memory_order_acquire ) != global_timer_generation.load( memory_order_acquire );
+}
+
+uint64_t elapsed_until( const Timer& timer, const uint64_t end )
+{
+  return end > timer.beginning_timestamp() ? end - timer.beginning_timestamp() : 0;
+}
+
+/* folds the thread's records into the retired ones when the thread exits, and frees its entry for reuse */
+struct ThreadExit
+{
+  ThreadTimer* entry;
+  ~ThreadExit()
+  {
+    const lock_guard lock { registry_mutex() };
+    if ( not stale( *entry ) ) {
+      RetiredRecords& retired = retired_records();
+      retired.timer.merge( entry->timer );
+      retired.elapsed_ns += elapsed_until( entry->timer, Timer::timestamp_ns() );
+      retired.num_threads++;
+    }
+    entry->in_use.store( false, memory_order_release );
+  }
+};
+
+template<class Function>
+void for_each_registered_timer( Function&& f )
+{
+  for ( ThreadTimer* entry = registry_head().load( memory_order_acquire ); entry; entry = entry->next ) {
+    f( *entry );
+  }
+}
+
+/* calls f( timer, elapsed_ns, num_threads ) with the records of every thread (see merged_global_timer): the
+   running threads one by one, and the exited ones together */
+template<class Function>
+void for_each_thread_records( Function&& f )
+{
+  ThreadTimer& own = this_thread_timer();
+  const uint64_t request = global_timer_snapshot_request.fetch_add( 1, memory_order_relaxed ) + 1;
+  own.snapshot_request.store( request, memory_order_relaxed );
+
+  /* give the busy threads a moment to answer, without the lock (the registry itself is lock-free) */
+  const uint64_t deadline = Timer::timestamp_ns() + snapshot_wait_ns;
+  for_each_registered_timer( [&]( const ThreadTimer& entry ) {
+    while ( entry.snapshot_request.load( memory_order_acquire ) < request
+            and entry.busy.load( memory_order_acquire ) and entry.in_use.load( memory_order_acquire )
+            and Timer::timestamp_ns() < deadline ) {
+      this_thread::sleep_for( chrono::microseconds( 100 ) );
+    }
+  } );
+
+  const lock_guard lock { registry_mutex() };
+  if ( stale( own ) ) {
+    catch_up_with_reset( own );
+  }
+
+  const RetiredRecords& retired = retired_records();
+  if ( retired.num_threads > 0 ) {
+    f( retired.timer, retired.elapsed_ns, retired.num_threads );
+  }
+
+  const uint64_t now = Timer::timestamp_ns();
+  const uint64_t generation = global_timer_generation.load( memory_order_acquire );
+  for_each_registered_timer( [&]( ThreadTimer& entry ) {
+    if ( &entry == &own ) {
+      f( own.timer, elapsed_until( own.timer, now ), 1 );
+      return;
+    }
+
+    if ( not entry.in_use.load( memory_order_acquire ) ) {
+      return;
+    }
+
+    const lock_guard snapshot_lock { entry.snapshot_mutex };
+    if ( entry.snapshot and entry.snapshot_generation == generation ) {
+      f( *entry.snapshot, elapsed_until( *entry.snapshot, entry.snapshot_ns ), 1 );
+    }
+  } );
+}
+
+}
+
+ThreadTimer& register_thread_timer()
+{
+  ThreadTimer* entry = nullptr;
+  {
+    const lock_guard lock { registry_mutex() };
+    for_each_registered_timer( [&]( ThreadTimer& candidate ) {
+      if ( not entry and not candidate.in_use.load( memory_order_acquire ) ) {
+        entry = &candidate;
+      }
+    } );
+
+    if ( entry ) {
+      entry->timer = Timer {};
+      entry->generation.store( global_timer_generation.load( memory_order_acquire ), memory_order_relaxed );
+      entry->busy.store( false, memory_order_relaxed );
+      {
+        const lock_guard snapshot_lock { entry->snapshot_mutex };
+        entry->snapshot.reset();
+      }
+      entry->in_use.store( true, memory_order_release );
+    }
+  }
+
+  if ( not entry ) {
+    entry = new ThreadTimer;
+    entry->generation.store( global_timer_generation.load( memory_order_acquire ), memory_order_relaxed );
+    entry->in_use.store( true, memory_order_relaxed );
+    entry->next = registry_head().load( memory_order_relaxed );
+    while ( not registry_head().compare_exchange_weak(
+      entry->next, entry, memory_order_release, memory_order_relaxed ) ) {}
+  }
+
+  thread_local ThreadExit thread_exit { entry };
+  return *entry;
+}
+
+void catch_up_with_reset( ThreadTimer& entry )
+{
+  const uint64_t generation = global_timer_generation.load( memory_order_acquire );
+  entry.timer.reset( global_timer_reset_ns.load( memory_order_relaxed ) );
+  entry.generation.store( generation, memory_order_release );
+}
+
+void publish_timer_snapshot( ThreadTimer& entry )
+{
+  const uint64_t request = global_timer_snapshot_request.load( memory_order_relaxed );
+  {
+    const lock_guard lock { entry.snapshot_mutex };
+    entry.snapshot = entry.timer;
+    entry.snapshot_ns = Timer::timestamp_ns();
+    entry.snapshot_generation = entry.generation.load( memory_order_relaxed );
+  }
+  entry.snapshot_request.store( request, memory_order_release );
+}
+
+void reset_global_timer()
+{
+  /* the retired records are reset here, so not while they are read */
+  const lock_guard lock { registry_mutex() };
+
+  global_timer_reset_ns.store( Timer::timestamp_ns(), memory_order_relaxed );
+  global_timer_generation.fetch_add( 1, memory_order_acq_rel );
+  retired_records() = RetiredRecords {};
+}
+
+Timer merged_global_timer()
+{
+  Timer merged;
+  for_each_thread_records( [&]( const Timer& timer, uint64_t, size_t ) { merged.merge( timer ); } );
+  return merged;
+}
+
+void global_timer_summary( ostream& out )
+{
+  Timer merged;
+  uint64_t elapsed = 0;
+  size_t num_threads = 0;
+
+  for_each_thread_records( [&]( const Timer& timer, const uint64_t timer_elapsed, const size_t timer_threads ) {
+    merged.merge( timer );
+    elapsed += timer_elapsed;
+    num_threads += timer_threads;
+  } );
+
+  merged.summary( out, max<uint64_t>( elapsed, 1 ), num_threads );
 }
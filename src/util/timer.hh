@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <ostream>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 
@@ -37,12 +43,81 @@ public:
     }
   }
 
+  /* log-linear (HDR-style) histogram of durations: exact below 16 ns, then 16 buckets per power of two,
+     so a bucket's values are within 1/16 of each other. Logging is constant time and never allocates. */
+  class Histogram
+  {
+  public:
+    constexpr static unsigned int sub_bucket_bits = 4;
+    constexpr static uint64_t sub_buckets = 1 << sub_bucket_bits;
+    constexpr static size_t num_buckets = ( 64 - sub_bucket_bits + 1 ) * sub_buckets;
+
+  private:
+    std::array<uint64_t, num_buckets> _counts {};
+    uint64_t _count {};
+
+  public:
+    static size_t bucket( const uint64_t time_ns )
+    {
+      if ( time_ns < sub_buckets ) {
+        return time_ns;
+      }
+      const unsigned int exponent = 63 - __builtin_clzll( time_ns );
+      const unsigned int shift = exponent - sub_bucket_bits;
+      return ( shift + 1 ) * sub_buckets + ( ( time_ns >> shift ) & ( sub_buckets - 1 ) );
+    }
+
+    /* the largest duration that falls in a bucket */
+    static uint64_t bucket_max( const size_t index )
+    {
+      if ( index < sub_buckets ) {
+        return index;
+      }
+      const unsigned int shift = index / sub_buckets - 1;
+      const uint64_t lowest = ( sub_buckets + index % sub_buckets ) << shift;
+      return lowest + ( ( uint64_t( 1 ) << shift ) - 1 );
+    }
+
+    void log( const uint64_t time_ns )
+    {
+      _counts[bucket( time_ns )]++;
+      _count++;
+    }
+
+    void merge( const Histogram& other )
+    {
+      for ( size_t i = 0; i < num_buckets; i++ ) {
+        _counts[i] += other._counts[i];
+      }
+      _count += other._count;
+    }
+
+    uint64_t count() const { return _count; }
+
+    /* the duration (rounded up to its bucket) below which a fraction q of the logged durations fall */
+    uint64_t percentile( const double q ) const
+    {
+      const uint64_t rank = std::max<uint64_t>( 1, std::ceil( q * _count ) );
+      uint64_t seen = 0;
+      for ( size_t i = 0; i < num_buckets; i++ ) {
+        seen += _counts[i];
+        if ( seen >= rank ) {
+          return bucket_max( i );
+        }
+      }
+      return 0;
+    }
+  };
+
   struct Record
   {
     uint64_t count;
     uint64_t total_ns;
     uint64_t max_ns;
     uint64_t min_ns = std::numeric_limits<uint64_t>::max();
+    std::optional<Histogram> histogram {}; // percentiles, if enabled (kept inline, so logging never allocates)
+
+    void enable_histogram() { histogram.emplace(); }
 
     void log( const uint64_t time_ns )
     {
@@ -50,12 +125,59 @@ public:
       total_ns += time_ns;
       max_ns = std::max( max_ns, time_ns );
       min_ns = std::min( min_ns, time_ns );
+      if ( histogram.has_value() ) {
+        histogram->log( time_ns );
+      }
+    }
+
+    /* fold in another Record (e.g. the same measurement from another thread) */
+    void merge( const Record& other )
+    {
+      count += other.count;
+      total_ns += other.total_ns;
+      max_ns = std::max( max_ns, other.max_ns );
+      min_ns = std::min( min_ns, other.min_ns );
+      if ( histogram.has_value() and other.histogram.has_value() ) {
+        histogram->merge( other.histogram.value() );
+      } else if ( histogram.has_value() ) {
+        histogram.reset(); // the other record's durations are unknown, so these percentiles would be wrong
+      }
+    }
+
+    /* the percentile (0 < q <= 1) of the logged durations, clamped to [min, max]; needs the histogram */
+    uint64_t percentile( const double q ) const
+    {
+      if ( not histogram.has_value() ) {
+        throw std::runtime_error( "Timer::Record::percentile: histogram not enabled" );
+      }
+      if ( count == 0 ) {
+        return 0;
+      }
+      return std::clamp( histogram->percentile( q ), min_ns, max_ns );
     }
 
     void reset()
     {
       count = total_ns = max_ns = 0;
       min_ns = std::numeric_limits<uint64_t>::max();
+      if ( histogram.has_value() ) {
+        histogram.emplace();
+      }
+    }
+
+    /* prints " [p50=...] [p99=...] [p99.9=...]" if the histogram is enabled and there are durations */
+    void print_percentiles( std::ostream& out ) const
+    {
+      if ( not histogram.has_value() or count == 0 ) {
+        return;
+      }
+      out << " [p50=";
+      pp_ns( out, percentile( 0.5 ) );
+      out << "] [p99=";
+      pp_ns( out, percentile( 0.99 ) );
+      out << "] [p99.9=";
+      pp_ns( out, percentile( 0.999 ) );
+      out << "]";
     }
   };
 
@@ -71,55 +193,204 @@ public:
   constexpr static std::array<const char*, num_categories> _category_names { { "Nonblocking operations",
                                                                                "Waiting for event" } };
 
+  constexpr static size_t max_depth = 16;
+
 private:
+  /* an open timer scope */
+  struct Frame
+  {
+    Category category;
+    uint64_t start;
+    uint64_t children_ns; // inclusive time of the scopes nested in this one
+  };
+
   uint64_t _beginning_timestamp = timestamp_ns();
-  std::array<Record, num_categories> _records {};
-  std::optional<Category> _current_category {};
-  uint64_t _start_time {};
+  std::array<Record, num_categories> _records {};         // inclusive durations (nested scopes included)
+  std::array<uint64_t, num_categories> _exclusive_ns {}; // time in each category minus its nested scopes
+  std::array<Frame, max_depth> _stack {};
+  size_t _depth {};
 
 public:
+  Timer()
+  {
+    for ( auto& record : _records ) {
+      record.enable_histogram();
+    }
+  }
+
   template<Category category>
   void start( const uint64_t now = timestamp_ns() )
   {
-    if ( _current_category.has_value() ) {
-      throw std::runtime_error( "timer started when already running" );
+    if ( _depth == max_depth ) {
+      throw std::runtime_error( "timers nested too deeply" );
     }
 
-    _current_category = category;
-    _start_time = now;
+    _stack[_depth++] = { category, now, 0 };
   }
 
   template<Category category>
   void stop( const uint64_t now = timestamp_ns() )
   {
-    if ( not _current_category.has_value() or _current_category.value() != category ) {
+    if ( _depth == 0 or _stack[_depth - 1].category != category ) {
       throw std::runtime_error( "timer stopped when not running, or with mismatched category" );
     }
 
-    _records[static_cast<size_t>( category )].log( now - _start_time );
-    _current_category.reset();
+    const Frame& frame = _stack[--_depth];
+    const uint64_t inclusive_ns = now - frame.start;
+    _records[static_cast<size_t>( category )].log( inclusive_ns );
+    _exclusive_ns[static_cast<size_t>( category )] += inclusive_ns - std::min( frame.children_ns, inclusive_ns );
+    if ( _depth > 0 ) {
+      _stack[_depth - 1].children_ns += inclusive_ns;
+    }
   }
 
+  const Record& record( const Category category ) const { return _records.at( static_cast<size_t>( category ) ); }
+  uint64_t exclusive_ns( const Category category ) const
+  {
+    return _exclusive_ns.at( static_cast<size_t>( category ) );
+  }
+  size_t depth() const { return _depth; }
+  /* the category of the innermost open scope (depth() must be positive) */
+  Category innermost() const { return _stack[_depth - 1].category; }
+  uint64_t beginning_timestamp() const { return _beginning_timestamp; }
+
+  /* fold in another thread's records */
+  void merge( const Timer& other );
+
+  /* clear the records and restart the clock (scopes still open only count time from now on) */
+  void reset( const uint64_t now = timestamp_ns() );
+
+  /* this timer's records, as shares of the time since it started (or was reset) */
   void summary( std::ostream& out ) const;
+
+  /* the records, as shares of elapsed_ns (summed over threads for a merged Timer) */
+  void summary( std::ostream& out, const uint64_t elapsed_ns, const size_t num_threads = 1 ) const;
 };
 
+/* one thread's timer in the registry (when the thread exits, its records are folded into the
+   retired ones and the entry is handed to the next thread that registers) */
+struct ThreadTimer
+{
+  Timer timer {};
+  std::atomic<uint64_t> generation {};       // the last reset_global_timer this timer has caught up with
+  std::atomic<bool> in_use {};               // false once the thread has exited
+  std::atomic<uint64_t> snapshot_request {}; // the last global_timer_snapshot_request this thread has answered
+  std::atomic<bool> busy {}; // in a scope other than WaitingForEvent, so it will start or stop one soon
+
+  /* the copy of the timer published for readers in other threads, when it was taken, and the reset it belongs to */
+  std::mutex snapshot_mutex {};
+  std::optional<Timer> snapshot {};
+  uint64_t snapshot_ns {};
+  uint64_t snapshot_generation {};
+
+  ThreadTimer* next {};
+};
+
+/* Gives the calling thread a timer in a lock-free registry: the entry of an exited
+   thread if there is one, or else a new entry. */
+ThreadTimer& register_thread_timer();
+
+/* number of reset_global_timer calls so far, and the time of the last one */
+inline std::atomic<uint64_t> global_timer_generation { 0 };
+inline std::atomic<uint64_t> global_timer_reset_ns { 0 };
+
+/* number of times another thread has asked every running thread for a snapshot of its timer */
+inline std::atomic<uint64_t> global_timer_snapshot_request { 0 };
+
+/* resets the calling thread's timer to the last reset_global_timer */
+void catch_up_with_reset( ThreadTimer& entry );
+
+/* publishes a snapshot of the calling thread's timer, answering the last global_timer_snapshot_request */
+void publish_timer_snapshot( ThreadTimer& entry );
+
+/* the calling thread's entry in the registry */
+inline ThreadTimer& this_thread_timer()
+{
+  thread_local ThreadTimer& entry = register_thread_timer();
+  return entry;
+}
+
+/* The calling thread's timer. Only its own thread touches it: a reset or a
+   request for a snapshot by another thread is applied here, on the next
+   start or stop. */
 inline Timer& global_timer()
 {
-  static Timer the_global_timer;
-  return the_global_timer;
+  ThreadTimer& entry = this_thread_timer();
+  if ( entry.generation.load( std::memory_order_relaxed )
+       != global_timer_generation.load( std::memory_order_acquire ) ) {
+    catch_up_with_reset( entry );
+  }
+  if ( entry.snapshot_request.load( std::memory_order_relaxed )
+       != global_timer_snapshot_request.load( std::memory_order_relaxed ) ) {
+    publish_timer_snapshot( entry );
+  }
+  return entry.timer;
 }
 
-inline void reset_global_timer()
+/* starts a scope of the calling thread's timer, and tells readers whether the thread is busy */
+template<Timer::Category category>
+inline void start_global_timer( const uint64_t now = Timer::timestamp_ns() )
 {
-  global_timer() = Timer {};
+  global_timer().start<category>( now );
+  this_thread_timer().busy.store( category != Timer::Category::WaitingForEvent, std::memory_order_release );
 }
 
+/* stops a scope of the calling thread's timer, and tells readers whether the thread is still busy */
+template<Timer::Category category>
+inline void stop_global_timer( const uint64_t now = Timer::timestamp_ns() )
+{
+  Timer& timer = global_timer();
+  timer.stop<category>( now );
+  this_thread_timer().busy.store( timer.depth() > 0 and timer.innermost() != Timer::Category::WaitingForEvent,
+                                  std::memory_order_release );
+}
+
+/* Resets every thread's timer. Timers of threads that have exited are reset
+   here; a running thread resets its own on its next timed scope, and until
+   then its old records are left out of the merged records. Waits for a
+   concurrent merged_global_timer or global_timer_summary to finish reading,
+   which takes microseconds (it never waits for threads under the lock). */
+void reset_global_timer();
+
+/* Every thread's records, merged: the calling thread's own, those of threads
+   that have exited, and a snapshot of each running thread's. Busy running
+   threads (in a timed scope other than WaitingForEvent) are asked for a fresh
+   snapshot, and publish it on their next start or stop. The others (e.g.
+   blocked in epoll_wait or on a condition variable, or not timing anything)
+   are not waited for. A thread that does not answer is counted with the last
+   snapshot it published since the last reset, if any. Threads that have not
+   caught up with a reset yet are left out.
+   Worst case, the call waits 10 ms, for a busy thread whose scope lasts that
+   long; without busy threads it does not wait. */
+Timer merged_global_timer();
+
+/* merges every thread's records (as merged_global_timer) and prints the summary */
+void global_timer_summary( std::ostream& out );
+
 template<Timer::Category category>
 class GlobalScopeTimer
 {
 public:
-  GlobalScopeTimer() { global_timer().start<category>(); }
-  ~GlobalScopeTimer() { global_timer().stop<category>(); }
+  GlobalScopeTimer() { start_global_timer<category>(); }
+  ~GlobalScopeTimer() { stop_global_timer<category>(); }
+};
+
+/* times a scope into a Record, without touching the global timer's category state */
+class RecordOnlyScopeTimer
+{
+  Timer::Record* _timer;
+  uint64_t _start_time;
+
+public:
+  RecordOnlyScopeTimer( Timer::Record& timer )
+    : _timer( &timer )
+    , _start_time( Timer::timestamp_ns() )
+  {}
+
+  ~RecordOnlyScopeTimer() { _timer->log( Timer::timestamp_ns() - _start_time ); }
+
+  RecordOnlyScopeTimer( const RecordOnlyScopeTimer& ) = delete;
+  RecordOnlyScopeTimer& operator=( const RecordOnlyScopeTimer& ) = delete;
 };
 
 template<Timer::Category category>
@@ -133,16 +404,23 @@ public:
     : _timer( &timer )
     , _start_time( Timer::timestamp_ns() )
   {
-    global_timer().start<category>( _start_time );
+    start_global_timer<category>( _start_time );
   }
 
   ~RecordScopeTimer()
   {
     const uint64_t now = Timer::timestamp_ns();
     _timer->log( now - _start_time );
-    global_timer().stop<category>( now );
+    stop_global_timer<category>( now );
   }
 
   RecordScopeTimer( const RecordScopeTimer& ) = delete;
   RecordScopeTimer& operator=( const RecordScopeTimer& ) = delete;
 };
+
+/* keep the compiler from discarding or hoisting the benchmarked work */
+template<class T>
+inline void do_not_optimize( T* p )
+{
+  asm volatile( "" : : "g"( p ) : "memory" );
+}
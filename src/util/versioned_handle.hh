@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * Class Name: VersionedHandle
+ * Description: An immutable value (e.g. a set of model weights) that can be
+ *              replaced while other threads are reading it, in the style of
+ *              RCU (read-copy-update).
+ *
+ *              A writer builds the new value on its own, then publish()
+ *              swaps it in with one atomic pointer exchange. Readers never
+ *              lock: each one holds a Reader (a slot of its own), and
+ *              Reader::read() announces the current epoch in that slot and
+ *              loads the current version. Whatever version a reader got stays
+ *              valid until its Guard is destroyed, and the next read() sees
+ *              the newest version.
+ *
+ *              A replaced version is freed once every reader that could have
+ *              loaded it has finished (its grace period), by reclaim() or the
+ *              next publish() -- never on a reader's path.
+ *
+ *              Readers must not hold a Guard across long waits, or retired
+ *              versions pile up. At most max_readers Readers can exist at once.
+ */
+template<class T>
+class VersionedHandle
+{
+public:
+  constexpr static size_t max_readers = 64;
+
+private:
+  struct Version
+  {
+    std::unique_ptr<const T> value;
+    uint64_t number;
+  };
+
+  // one per Reader, on its own cache line so readers do not contend
+  struct alignas( 64 ) ReaderSlot
+  {
+    // epoch at which the reader's current read began, or 0 when it is not reading
+    std::atomic<uint64_t> epoch { 0 };
+    std::atomic<bool> in_use { false };
+  };
+
+  std::atomic<Version*> current_ { nullptr };
+  std::atomic<uint64_t> epoch_ { 1 };
+  // number of the current version, kept apart so version() need not touch a Version it does not hold
+  std::atomic<uint64_t> current_number_ { 0 };
+  std::array<ReaderSlot, max_readers> slots_ {};
+
+  // writer side: serializes publish() and reclaim()
+  std::mutex writer_mutex_ {};
+  // replaced versions, and the epoch at which they stopped being current
+  std::vector<std::pair<std::unique_ptr<Version>, uint64_t>> retired_ {};
+  uint64_t last_version_ {};
+  uint64_t num_reclaimed_ {};
+
+  size_t reclaim_locked()
+  {
+    /*
+     * A reader loads the version after announcing its epoch, and publish() bumps the epoch after
+     * swapping the version, so a reader whose epoch is at least a version's retire epoch cannot hold it.
+     */
+    uint64_t oldest_reader = std::numeric_limits<uint64_t>::max();
+    for ( const auto& slot : slots_ ) {
+      const uint64_t epoch = slot.epoch.load();
+      if ( epoch != 0 ) {
+        oldest_reader = std::min( oldest_reader, epoch );
+      }
+    }
+
+    const size_t num_retired = retired_.size();
+    retired_.erase( std::remove_if( retired_.begin(),
+                                    retired_.end(),
+                                    [&]( const auto& retired ) { return retired.second <= oldest_reader; } ),
+                    retired_.end() );
+    num_reclaimed_ += num_retired - retired_.size();
+
+    return retired_.size();
+  }
+
+public:
+  /* the handle starts out holding `initial` as version 1 */
+  explicit VersionedHandle( std::unique_ptr<const T> initial )
+  {
+    publish( std::move( initial ) );
+  }
+
+  ~VersionedHandle() { delete current_.load(); }
+
+  /* Disallow copying */
+  VersionedHandle( const VersionedHandle& other ) = delete;
+  VersionedHandle& operator=( const VersionedHandle& other ) = delete;
+
+  /*
+   * Function Name: publish
+   * Description: This function makes `value` the current version. Readers
+   *              that already hold the old version keep it until they finish,
+   *              and the old version is freed after that (see reclaim).
+   * Parameters:
+   *			1. value is the new, fully built value (not null)
+   * Return: the new version number
+   */
+  uint64_t publish( std::unique_ptr<const T> value )
+  {
+    if ( not value ) {
+      throw std::invalid_argument( "VersionedHandle: cannot publish a null value" );
+    }
+
+    std::lock_guard lock { writer_mutex_ };
+    const uint64_t number = ++last_version_;
+    Version* old = current_.exchange( new Version { std::move( value ), number } );
+    current_number_.store( number );
+    const uint64_t retire_epoch = epoch_.fetch_add( 1 ) + 1;
+    if ( old ) {
+      retired_.emplace_back( std::unique_ptr<Version>( old ), retire_epoch );
+    }
+    reclaim_locked();
+    return number;
+  }
+
+  /* free the retired versions whose grace period is over; returns how many are still waiting */
+  size_t reclaim()
+  {
+    std::lock_guard lock { writer_mutex_ };
+    return reclaim_locked();
+  }
+
+  /* wait until every retired version has been freed */
+  void synchronize()
+  {
+    while ( reclaim() > 0 ) {
+      std::this_thread::yield();
+    }
+  }
+
+  uint64_t version() const { return current_number_.load(); }
+
+  uint64_t num_reclaimed()
+  {
+    std::lock_guard lock { writer_mutex_ };
+    return num_reclaimed_;
+  }
+
+  /*
+   * Class Name: Reader
+   * Description: A reading thread's registration with the handle. Use one
+   *              per thread; reads through it are wait-free.
+   */
+  class Reader
+  {
+    VersionedHandle* handle_;
+    ReaderSlot* slot_ {};
+
+  public:
+    explicit Reader( VersionedHandle& handle )
+      : handle_( &handle )
+    {
+      for ( auto& slot : handle.slots_ ) {
+        if ( not slot.in_use.exchange( true ) ) {
+          slot_ = &slot;
+          return;
+        }
+      }
+      throw std::runtime_error( "VersionedHandle: too many readers" );
+    }
+
+    ~Reader() { slot_->in_use.store( false ); }
+
+    /* Disallow copying */
+    Reader( const Reader& other ) = delete;
+    Reader& operator=( const Reader& other ) = delete;
+
+    /* the version read by Reader::read(), held until the Guard is destroyed */
+    class Guard
+    {
+      ReaderSlot* slot_;
+      const Version* version_;
+
+    public:
+      Guard( ReaderSlot* slot, const Version* version )
+        : slot_( slot )
+        , version_( version )
+      {}
+
+      ~Guard() { slot_->epoch.store( 0, std::memory_order_release ); }
+
+      /* Disallow copying */
+      Guard( const Guard& other ) = delete;
+      Guard& operator=( const Guard& other ) = delete;
+
+      const T& operator*() const { return *version_->value; }
+      const T* operator->() const { return version_->value.get(); }
+      uint64_t version() const { return version_->number; }
+    };
+
+    /* the current version (one read at a time per Reader) */
+    Guard read()
+    {
+      assert( slot_->epoch.load( std::memory_order_relaxed ) == 0 );
+      slot_->epoch.store( handle_->epoch_.load() );
+      return Guard { slot_, handle_->current_.load() };
+    }
+  };
+};